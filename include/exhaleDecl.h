@@ -1,5 +1,5 @@
 /* exhaleDecl.h - header file with declarations for exhale DLL ex-/import under Windows
- * written by C. R. Helmrich, last modified in 2020 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -26,6 +26,50 @@
 # define EXHALE_DECL
 #endif
 
+/* PCM sample formats accepted by the streaming interface, see exhalePushPcm */
+typedef enum ExhalePcmFormat
+{
+  EXHALE_PCM_S16 = 0, /* int16_t samples */
+  EXHALE_PCM_S24 = 1, /* int32_t samples with 24-bit range, native format of exhaleCreate */
+  EXHALE_PCM_F32 = 2  /* float samples in range -1.0 to 1.0 */
+} ExhalePcmFormat;
+
+/* input conversion flags of the planar input interface, see exhaleSetPlanarInput, may be combined */
+typedef enum ExhaleInputFlags
+{
+  EXHALE_INPUT_CLIP   = 1, /* saturate EXHALE_PCM_S24 samples to 24-bit range, float samples are always saturated */
+  EXHALE_INPUT_DITHER = 2  /* add triangular (TPDF) dither of +-1 LSB to float samples before rounding to 24 bit */
+} ExhaleInputFlags;
+
+/* encoder stages timed in ExhaleFrameStats, in order of execution per frame */
+typedef enum ExhaleStatsStage
+{
+  EXHALE_STAGE_TEMPORAL = 0, /* temporalProcessing: window decision and MCLT */
+  EXHALE_STAGE_SPECTRAL = 1, /* spectralProcessing: grouping, TNS, SFB data */
+  EXHALE_STAGE_PSYCH    = 2, /* psychBitAllocation: scale factor estimation */
+  EXHALE_STAGE_QUANT    = 3, /* quantizationCoding: quantization incl. RDOC */
+  EXHALE_STAGE_AU_WRITE = 4, /* createAudioFrame: bit-stream (AU) writing */
+  EXHALE_NUM_STAGES     = 5
+} ExhaleStatsStage;
+
+/* per-frame encoder statistics, filled by each exhaleEncodeFrame call once set via exhaleSetFrameStats */
+typedef struct ExhaleFrameStats
+{
+  uint32_t frameCount;     /* frame index, 0 for first exhaleEncodeFrame call */
+  uint32_t stageNanoSec[EXHALE_NUM_STAGES];   /* wall-clock time per stage */
+  uint32_t auBytes;        /* size of the encoded AU, same as returned value */
+  uint32_t rateFactor;     /* rate control factor after the frame, 0: none */
+  uint8_t  cplxLevel;      /* complexity reduction level of the RTF guard */
+  uint8_t  indepFlag;      /* usacIndependencyFlag of the AU */
+  uint8_t  numChannels;    /* number of valid entries in per-channel arrays */
+  uint8_t  numElements;    /* number of valid entries in stereoMode array */
+  uint16_t channelBits[8]; /* bits of fd_channel_stream() of each channel */
+  uint8_t  rdocPasses[8];  /* rate-distortion optimized quantization runs */
+  uint8_t  tnsFilters[8];  /* number of TNS filters applied in each channel */
+  uint8_t  windowSequence[8];  /* window_sequence (0-3), 2: EIGHT_SHORT */
+  uint8_t  stereoMode[5];  /* ms_mask_present of each element, 0 if not CPE */
+} ExhaleFrameStats;
+
 #ifdef __cplusplus
 struct ExhaleEncAPI
 {
@@ -46,6 +90,12 @@ struct ExhaleEncAPI; /* opaque type */
 typedef struct ExhaleEncAPI ExhaleEncAPI;
 #endif
 
+struct ExhaleResAPI; /* opaque resampler type */
+typedef struct ExhaleResAPI ExhaleResAPI;
+
+/* real-time factor guard callback: context, frame count, measured real-time factor in percent, new complexity level */
+typedef void (*ExhaleStatsCallback) (void* const, const uint32_t, const unsigned, const unsigned);
+
 /* C constructor */
 EXHALE_DECL ExhaleEncAPI* exhaleCreate (int32_t* const, unsigned char* const, const unsigned, const unsigned,
                                         const unsigned, const unsigned, const unsigned, const bool, const bool);
@@ -61,6 +111,40 @@ EXHALE_DECL unsigned exhaleEncodeLookahead (ExhaleEncAPI*);
 /* C frame encoder */
 EXHALE_DECL unsigned exhaleEncodeFrame (ExhaleEncAPI*);
 
+/* C complexity setter, number of trellis states per SFB (2-8) and per tuple (1-4), 0: preset's default */
+EXHALE_DECL unsigned exhaleSetComplexity (ExhaleEncAPI*, const unsigned, const unsigned);
+
+/* C real-time factor guard setter, target in percent of the frame duration (0: off) and optional stats callback */
+EXHALE_DECL unsigned exhaleSetTargetRtf (ExhaleEncAPI*, const unsigned, ExhaleStatsCallback, void* const);
+
+/* C streaming input, for encoders created with NULL buffers: samples, count per channel, ExhalePcmFormat, planar flag */
+EXHALE_DECL unsigned exhalePushPcm (ExhaleEncAPI*, const void* const, const unsigned, const unsigned, const bool);
+
+/* C streaming end of input, encodes all pending samples into AUs */
+EXHALE_DECL unsigned exhaleFlush (ExhaleEncAPI*);
+
+/* C streaming output, copies the next AU into buffer of given size: AU bytes (0: none pending), timestamp in samples */
+EXHALE_DECL unsigned exhaleDrainAu (ExhaleEncAPI*, unsigned char* const, const unsigned, uint32_t* const, int64_t* const);
+
+/* C thread count setter, call before exhaleInitEncoder for element-parallel multichannel coding */
+EXHALE_DECL unsigned exhaleSetNumThreads (ExhaleEncAPI*, const unsigned);
+
+/* C frame statistics setter, struct filled by every subsequent frame encoder call, NULL: off (default) */
+EXHALE_DECL unsigned exhaleSetFrameStats (ExhaleEncAPI*, ExhaleFrameStats* const);
+
+/* C planar input setter, replaces exhaleCreate's interleaved buffer (may be NULL if called before exhaleInitEncoder): array
+   of per-channel sample pointers, read by every lookahead or frame encoder call, ExhalePcmFormat, ExhaleInputFlags */
+EXHALE_DECL unsigned exhaleSetPlanarInput (ExhaleEncAPI*, const void* const* const, const unsigned, const unsigned);
+
+/* C resampler constructor: input and output sampling rate, number of channels, max. output samples per call, NULL on error */
+EXHALE_DECL ExhaleResAPI* exhaleCreateResampler (const unsigned, const unsigned, const unsigned, const unsigned);
+/* C resampler destructor */
+EXHALE_DECL unsigned exhaleDeleteResampler (ExhaleResAPI*);
+/* C resampler input length: channel-interleaved samples read by the next exhaleResample call with same arguments */
+EXHALE_DECL unsigned exhaleGetResamplerInput (ExhaleResAPI*, const unsigned, const bool);
+/* C resampler, in place on 24-bit channel-interleaved samples: number of output samples, restart (first call is a restart) */
+EXHALE_DECL unsigned exhaleResample (ExhaleResAPI*, int32_t* const, const unsigned, const bool);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
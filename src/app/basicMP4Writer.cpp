@@ -1,5 +1,5 @@
 /* basicMP4Writer.cpp - source file for class with basic MPEG-4 file writing capability
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  * pre-roll serializer and related code added by J. Calhoun in 2020, see merge request 4
  *
  * The copyright in this software is being made available under the exhale Copyright License
@@ -73,6 +73,155 @@ void BasicMP4Writer::push32BitValue (const uint32_t value) // push to dynamic he
   m_dynamicHeader.push_back ((value      ) & UCHAR_MAX);
 }
 
+void BasicMP4Writer::pushUserData () // push udta to dynamic header
+{
+#if UDTA_BSIZE
+  const char ver[] = EXHALELIB_VERSION_MAJOR "." EXHALELIB_VERSION_MINOR EXHALELIB_VERSION_BUGFIX;
+  const char mod[] = "(MoSal Mod)";
+  uint32_t i;
+
+  push32BitValue (UDTA_BSIZE);
+  m_dynamicHeader.push_back (0x75); m_dynamicHeader.push_back (0x64);
+  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x61); // udta
+  push32BitValue (UDTA_BSIZE - 8);
+  m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x65);
+  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x61); // meta
+  push32BitValue (0);
+
+  push32BitValue (33);
+  m_dynamicHeader.push_back (0x68); m_dynamicHeader.push_back (0x64);
+  m_dynamicHeader.push_back (0x6C); m_dynamicHeader.push_back (0x72); // hdlr
+  push32BitValue (0);
+  push32BitValue (0);
+  m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x64);
+  m_dynamicHeader.push_back (0x69); m_dynamicHeader.push_back (0x72); // mdir
+  m_dynamicHeader.push_back (0x61); m_dynamicHeader.push_back (0x70);
+  m_dynamicHeader.push_back (0x70); m_dynamicHeader.push_back (0x6C); // appl
+  push32BitValue (0);
+  push32BitValue (0);
+  m_dynamicHeader.push_back (0);
+
+  push32BitValue (UDTA_BSIZE - 53);
+  m_dynamicHeader.push_back (0x69); m_dynamicHeader.push_back (0x6C);
+  m_dynamicHeader.push_back (0x73); m_dynamicHeader.push_back (0x74); // ilst
+  push32BitValue (UDTA_BSIZE - 53 - 8);
+  m_dynamicHeader.push_back (0xA9); m_dynamicHeader.push_back (0x74);
+  m_dynamicHeader.push_back (0x6F); m_dynamicHeader.push_back (0x6F); // too
+  push32BitValue (UDTA_BSIZE - 53 - 16);
+  m_dynamicHeader.push_back (0x64); m_dynamicHeader.push_back (0x61);
+  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x61); // data
+  push32BitValue (1);
+  push32BitValue (0);
+  m_dynamicHeader.push_back (0x65); m_dynamicHeader.push_back (0x78);
+  m_dynamicHeader.push_back (0x68); m_dynamicHeader.push_back (0x61);
+  m_dynamicHeader.push_back (0x6C); m_dynamicHeader.push_back (0x65); // exhale
+  m_dynamicHeader.push_back (0x20);
+  for (i = 0; i < 5; i++) m_dynamicHeader.push_back ((uint8_t) ver[i]);
+  m_dynamicHeader.push_back (0x20);
+  for (i = 0; i < std::size(mod) - 1; i++) m_dynamicHeader.push_back ((uint8_t) mod[i]);
+#endif
+}
+
+unsigned BasicMP4Writer::writeFragment (const uint32_t finalFrameLength) // 0: not final
+{
+  const uint32_t numFrames    = (uint32_t) m_fragmentSizes.size ();
+  const uint32_t firstFrame   = m_frameCount - numFrames;
+  const uint32_t moofOffset   = m_mediaSize - (uint32_t) m_fragmentData.size ();
+#ifdef NO_PREROLL_DATA
+  const bool     syncFragment = (firstFrame == 0);
+#else
+  const bool     syncFragment = (firstFrame % (m_rndAccPeriod << 1) == 0); // as in stss
+#endif
+  const bool     rollFragment = (firstFrame % (m_rndAccPeriod << 1) == m_rndAccPeriod); // as in csgp
+  const uint32_t sbgpAtomSize = (rollFragment ? (numFrames > 1 ? 36 : 28) : 0);
+  const uint32_t trunAtomSize = STSX_BSIZE + 4 /*data_offset*/ + (syncFragment ? 4 : 0) + numFrames * (finalFrameLength > 0 ? 8 : 4);
+  const uint32_t trafAtomSize = 8 + 16 /*tfhd*/ + 20 /*tfdt*/ + sbgpAtomSize + trunAtomSize;
+  const uint32_t moofAtomSize = 8 + 16 /*mfhd*/ + trafAtomSize;
+  const uint64_t decodeTime   = (uint64_t) firstFrame * m_frameLength;
+  uint32_t i;
+
+  if (numFrames == 0) return 0;
+
+  if (m_mediaSize > 0xFFFFFFF0u - moofAtomSize - 8)
+  {
+    return 1; // file getting too big
+  }
+
+  // create moof atom and mdat header of fragment
+  m_dynamicHeader.clear ();
+  push32BitValue (moofAtomSize);
+  m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x6F);
+  m_dynamicHeader.push_back (0x6F); m_dynamicHeader.push_back (0x66); // moof
+  push32BitValue (16);
+  m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x66);
+  m_dynamicHeader.push_back (0x68); m_dynamicHeader.push_back (0x64); // mfhd
+  push32BitValue (0);
+  push32BitValue (++m_fragmentCount);
+  push32BitValue (trafAtomSize);
+  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x72);
+  m_dynamicHeader.push_back (0x61); m_dynamicHeader.push_back (0x66); // traf
+  push32BitValue (16);
+  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x66);
+  m_dynamicHeader.push_back (0x68); m_dynamicHeader.push_back (0x64); // tfhd
+  push32BitValue (0x020000); // default-base-is-moof
+  push32BitValue (1); // track
+  push32BitValue (20);
+  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x66);
+  m_dynamicHeader.push_back (0x64); m_dynamicHeader.push_back (0x74); // tfdt
+  push32BitValue (1 << 24);
+  push32BitValue (uint32_t (decodeTime >> 32));
+  push32BitValue (uint32_t (decodeTime & UINT_MAX));
+
+  if (rollFragment) // first AU is member of 'prol' group
+  {
+    push32BitValue (sbgpAtomSize);
+    m_dynamicHeader.push_back (0x73); m_dynamicHeader.push_back (0x62);
+    m_dynamicHeader.push_back (0x67); m_dynamicHeader.push_back (0x70); // sbgp
+    push32BitValue (0);
+    m_dynamicHeader.push_back (0x70); m_dynamicHeader.push_back (0x72);
+    m_dynamicHeader.push_back (0x6F); m_dynamicHeader.push_back (0x6C); // prol
+    push32BitValue (numFrames > 1 ? 2 : 1);
+    push32BitValue (1);
+    push32BitValue (1); // sgpd idx
+    if (numFrames > 1)
+    {
+      push32BitValue (numFrames - 1);
+      push32BitValue (0);
+    }
+  }
+  push32BitValue (trunAtomSize);
+  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x72);
+  m_dynamicHeader.push_back (0x75); m_dynamicHeader.push_back (0x6E); // trun
+  push32BitValue (0x201 | (syncFragment ? 0x4 : 0) | (finalFrameLength > 0 ? 0x100 : 0));
+  push32BitValue (numFrames);
+  push32BitValue (moofAtomSize + 8); // data_offset
+  if (syncFragment) push32BitValue (0x02000000); // sync AU
+
+  for (i = 0; i < numFrames; i++)
+  {
+    if (finalFrameLength > 0) push32BitValue (i + 1 < numFrames ? m_frameLength : finalFrameLength);
+    push32BitValue (m_fragmentSizes.at (i));
+  }
+  push32BitValue ((uint32_t) m_fragmentData.size () + 8);
+  m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x64);
+  m_dynamicHeader.push_back (0x61); m_dynamicHeader.push_back (0x74); // mdat
+
+  if (syncFragment) m_fragmentSyncs.push_back (moofOffset);
+  m_rndAccOffsets.push_back (moofOffset + moofAtomSize + 8);
+  m_mediaSize += moofAtomSize + 8;
+
+  if ((m_writeBuffer.write (&m_dynamicHeader.front (), (uint32_t) m_dynamicHeader.size ()) != (int) m_dynamicHeader.size ()) ||
+      (m_writeBuffer.write (&m_fragmentData.front (), (uint32_t) m_fragmentData.size ()) != (int) m_fragmentData.size ()) ||
+      (m_flushOnIpf && (m_writeBuffer.flush () > 0))) // fragment starts at RA point
+  {
+    return 1; // write error
+  }
+  m_fragmentData.clear ();
+  m_fragmentSizes.clear ();
+
+  return 0; // no error
+}
+
 // public functions
 int BasicMP4Writer::addFrameAU (const uint8_t* byteBuf, const uint32_t byteCount)
 {
@@ -81,12 +230,22 @@ int BasicMP4Writer::addFrameAU (const uint8_t* byteBuf, const uint32_t byteCount
     return 1; // invalid file handle or file getting too big
   }
 
+  if (m_fragmented) // collect AUs of one RA period, write previous fragment
+  {
+    if ((m_fragmentSizes.size () >= m_rndAccPeriod) && (writeFragment (0) > 0)) return 1;
+
+    m_fragmentSizes.push_back (byteCount);
+    m_fragmentData.insert (m_fragmentData.end (), byteBuf, byteBuf + byteCount);
+  }
+  else
   // add frame byte-size, in Big Endian format, to frame size list (stsz)
   push32BitValue (byteCount);
 
   if (((m_frameCount++) % m_rndAccPeriod) == 0) // add RAP to list (stco)
   {
-    m_rndAccOffsets.push_back (m_mediaSize);
+    if (m_flushOnIpf && !m_fragmented && ((byteBuf[0] & 0xE0) == 0xC0) && (m_writeBuffer.flush () > 0)) return 1;
+
+    if (!m_fragmented) m_rndAccOffsets.push_back (m_mediaSize); // else in writeFragment
 #ifndef NO_PREROLL_DATA
     if (((m_frameCount - 1u) % (m_rndAccPeriod << 1)) == 0)  // every 2nd
     {
@@ -104,7 +263,7 @@ int BasicMP4Writer::addFrameAU (const uint8_t* byteBuf, const uint32_t byteCount
   }
   m_mediaSize += byteCount;
 
-  return _WRITE (m_fileHandle, byteBuf, byteCount);  // write access unit
+  return (m_fragmented ? (int) byteCount : m_writeBuffer.write (byteBuf, byteCount)); // buffer access unit
 }
 
 int BasicMP4Writer::finishFile (const unsigned avgBitrate, const unsigned maxBitrate, const uint32_t audioLength,
@@ -149,6 +308,79 @@ int BasicMP4Writer::finishFile (const unsigned avgBitrate, const unsigned maxBit
     return 1; // invalid file handle or file getting too big
   }
 
+  m_staticHeader[558] = ((maxBitrate >> 24) & UCHAR_MAX);
+  m_staticHeader[559] = ((maxBitrate >> 16) & UCHAR_MAX);
+  m_staticHeader[560] = ((maxBitrate >>  8) & UCHAR_MAX);
+  m_staticHeader[561] = ( maxBitrate        & UCHAR_MAX);
+  m_staticHeader[562] = ((avgBitrate >> 24) & UCHAR_MAX);
+  m_staticHeader[563] = ((avgBitrate >> 16) & UCHAR_MAX);
+  m_staticHeader[564] = ((avgBitrate >>  8) & UCHAR_MAX);
+  m_staticHeader[565] = ( avgBitrate        & UCHAR_MAX);
+
+  if (m_fragmented) // write final fragment with trimmed last AU, then mfra index
+  {
+    const uint32_t numSyncs = (uint32_t) m_fragmentSyncs.size ();
+    const uint32_t tfraAtomSize = STSX_BSIZE + 8 + numSyncs * 19;
+    const uint32_t mfraAtomSize = 8 + tfraAtomSize + 16;
+
+    if ((writeFragment ((numSamplesFinalFrame == 0 ? m_frameLength : __max (m_postLength + 1u, numSamplesFinalFrame)) - m_postLength) > 0) ||
+        (m_mediaSize > 0xFFFFFFF0u - mfraAtomSize))
+    {
+      return 1;
+    }
+    m_dynamicHeader.clear ();
+    push32BitValue (mfraAtomSize);
+    m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x66);
+    m_dynamicHeader.push_back (0x72); m_dynamicHeader.push_back (0x61); // mfra
+    push32BitValue (tfraAtomSize);
+    m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x66);
+    m_dynamicHeader.push_back (0x72); m_dynamicHeader.push_back (0x61); // tfra
+    push32BitValue (1 << 24);
+    push32BitValue (1); // track
+    push32BitValue (0); // 8-bit traf, trun, sample numbers
+    push32BitValue (numSyncs);
+
+    for (i = 0; i < numSyncs; i++) // sync fragments are evenly spaced
+    {
+#ifdef NO_PREROLL_DATA
+      const uint64_t syncTime = 0;
+#else
+      const uint64_t syncTime = (uint64_t) i * (m_rndAccPeriod << 1) * m_frameLength;
+#endif
+      push32BitValue (uint32_t (syncTime >> 32));
+      push32BitValue (uint32_t (syncTime & UINT_MAX));
+      push32BitValue (0);
+      push32BitValue (m_fragmentSyncs.at (i));
+      m_dynamicHeader.push_back (1); m_dynamicHeader.push_back (1); m_dynamicHeader.push_back (1);
+    }
+    push32BitValue (16);
+    m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x66);
+    m_dynamicHeader.push_back (0x72); m_dynamicHeader.push_back (0x6F); // mfro
+    push32BitValue (0);
+    push32BitValue (mfraAtomSize);
+
+    bytesWritten = m_writeBuffer.write (&m_dynamicHeader.front (), (uint32_t) m_dynamicHeader.size ());
+    m_mediaSize += mfraAtomSize;
+
+    if (m_writeBuffer.flush () > 0) return 1;
+
+    // file is complete; if seekable, refresh esds bit-rates and ASC + UC in place
+    if (ascBuf != nullptr) memcpy (&m_staticHeader[571], ascBuf, 5 * sizeof (uint8_t));
+
+    if (_SEEK (m_fileHandle, 558 - 16 /*stts*/, 0 /*SEEK_SET*/) == 558 - 16)
+    {
+      _WRITE (m_fileHandle, &m_staticHeader[558], STAT_HEADER_SIZE - 558);
+      if (ascBuf != nullptr)
+      {
+        _WRITE (m_fileHandle, &ascBuf[5], m_ascSizeM5);
+#ifndef NO_PREROLL_DATA
+        if (!m_ipfConfig.empty ()) updateIPFs (&m_ipfConfig.front (), (uint32_t) m_ipfConfig.size (), 0);
+#endif
+      }
+    }
+    return bytesWritten;
+  }
+
   if (ascBuf != nullptr) // update ASC + UC data if required
   {
     memcpy (&m_staticHeader[571], ascBuf, 5 * sizeof (uint8_t));
@@ -175,15 +407,6 @@ int BasicMP4Writer::finishFile (const unsigned avgBitrate, const unsigned maxBit
   header4Byte[460>>2] = toBigEndian (m_frameCount - 1); // 2 entries used
   header4Byte[472>>2] = toBigEndian ((numSamplesFinalFrame == 0 ? m_frameLength : __max (m_postLength + 1u, numSamplesFinalFrame)) - m_postLength);
 
-  m_staticHeader[558] = ((maxBitrate >> 24) & UCHAR_MAX);
-  m_staticHeader[559] = ((maxBitrate >> 16) & UCHAR_MAX);
-  m_staticHeader[560] = ((maxBitrate >>  8) & UCHAR_MAX);
-  m_staticHeader[561] = ( maxBitrate        & UCHAR_MAX);
-  m_staticHeader[562] = ((avgBitrate >> 24) & UCHAR_MAX);
-  m_staticHeader[563] = ((avgBitrate >> 16) & UCHAR_MAX);
-  m_staticHeader[564] = ((avgBitrate >>  8) & UCHAR_MAX);
-  m_staticHeader[565] = ( avgBitrate        & UCHAR_MAX);
-
   // finish dynamically-sized 2nd part of MPEG-4 file header
   m_dynamicHeader.at (m_ascSizeM5 +  6) = ((stszAtomSize >> 24) & UCHAR_MAX);
   m_dynamicHeader.at (m_ascSizeM5 +  7) = ((stszAtomSize >> 16) & UCHAR_MAX);
@@ -268,50 +491,7 @@ int BasicMP4Writer::finishFile (const unsigned avgBitrate, const unsigned maxBit
     m_dynamicHeader.push_back (1 << ((numFramesFirstPeriod & 1) ? 0 : 4));
     for (i++; i < compPatternLength; i++) m_dynamicHeader.push_back (0);  // rest of nonmembers, second part
   }
-#if UDTA_BSIZE
-  const char ver[] = EXHALELIB_VERSION_MAJOR "." EXHALELIB_VERSION_MINOR EXHALELIB_VERSION_BUGFIX;
-  const char mod[] = "(MoSal Mod)";
-
-  push32BitValue (UDTA_BSIZE);
-  m_dynamicHeader.push_back (0x75); m_dynamicHeader.push_back (0x64);
-  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x61); // udta
-  push32BitValue (UDTA_BSIZE - 8);
-  m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x65);
-  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x61); // meta
-  push32BitValue (0);
-
-  push32BitValue (33);
-  m_dynamicHeader.push_back (0x68); m_dynamicHeader.push_back (0x64);
-  m_dynamicHeader.push_back (0x6C); m_dynamicHeader.push_back (0x72); // hdlr
-  push32BitValue (0);
-  push32BitValue (0);
-  m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x64);
-  m_dynamicHeader.push_back (0x69); m_dynamicHeader.push_back (0x72); // mdir
-  m_dynamicHeader.push_back (0x61); m_dynamicHeader.push_back (0x70);
-  m_dynamicHeader.push_back (0x70); m_dynamicHeader.push_back (0x6C); // appl
-  push32BitValue (0);
-  push32BitValue (0);
-  m_dynamicHeader.push_back (0);
-
-  push32BitValue (UDTA_BSIZE - 53);
-  m_dynamicHeader.push_back (0x69); m_dynamicHeader.push_back (0x6C);
-  m_dynamicHeader.push_back (0x73); m_dynamicHeader.push_back (0x74); // ilst
-  push32BitValue (UDTA_BSIZE - 53 - 8);
-  m_dynamicHeader.push_back (0xA9); m_dynamicHeader.push_back (0x74);
-  m_dynamicHeader.push_back (0x6F); m_dynamicHeader.push_back (0x6F); // too
-  push32BitValue (UDTA_BSIZE - 53 - 16);
-  m_dynamicHeader.push_back (0x64); m_dynamicHeader.push_back (0x61);
-  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x61); // data
-  push32BitValue (1);
-  push32BitValue (0);
-  m_dynamicHeader.push_back (0x65); m_dynamicHeader.push_back (0x78);
-  m_dynamicHeader.push_back (0x68); m_dynamicHeader.push_back (0x61);
-  m_dynamicHeader.push_back (0x6C); m_dynamicHeader.push_back (0x65); // exhale
-  m_dynamicHeader.push_back (0x20);
-  for (i = 0; i < 5; i++) m_dynamicHeader.push_back ((uint8_t) ver[i]);
-  m_dynamicHeader.push_back (0x20);
-  for (i = 0; i < std::size(mod) - 1; i++) m_dynamicHeader.push_back ((uint8_t) mod[i]);
-#endif
+  pushUserData ();
   const uint32_t moovAndMdatOverhead = STAT_HEADER_SIZE + (uint32_t) m_dynamicHeader.size () + 8;
   const uint32_t headerPaddingLength = uint32_t (m_mediaOffset - moovAndMdatOverhead);
 
@@ -331,9 +511,7 @@ int BasicMP4Writer::finishFile (const unsigned avgBitrate, const unsigned maxBit
   {
     if (pNdx == 0)  // add padding byte with library version
     {
-#if !UDTA_BSIZE
       const char ver[] = EXHALELIB_VERSION_MAJOR "." EXHALELIB_VERSION_MINOR EXHALELIB_VERSION_BUGFIX;
-#endif
       const int verInt = (ver[0] - 0x30) * 100 + (ver[2] - 0x30) * 10 + (ver[4] - 0x30);
 
       m_dynamicHeader.push_back (__max (0, __min (UCHAR_MAX, verInt)));
@@ -351,6 +529,8 @@ int BasicMP4Writer::finishFile (const unsigned avgBitrate, const unsigned maxBit
     }
   }
 
+  if (m_writeBuffer.flush () > 0) return 1; // AUs must be in file
+
   _SEEK (m_fileHandle, 0, 0 /*SEEK_SET*/);  // back to start
 
   bytesWritten += _WRITE (m_fileHandle, m_staticHeader, STAT_HEADER_SIZE);
@@ -377,7 +557,7 @@ int BasicMP4Writer::initHeader (const uint32_t audioLength, const unsigned extra
 
   for (int i = estimHeaderSize; i > 0; i -= STAT_HEADER_SIZE)
   {
-    bytesWritten += _WRITE (m_fileHandle, m_staticHeader, __min (i, STAT_HEADER_SIZE));
+    bytesWritten += m_writeBuffer.write (m_staticHeader, __min (i, STAT_HEADER_SIZE));
   }
   m_mediaOffset = bytesWritten; // first frame will be written at this offset
   m_postLength -= __min (m_postLength, extraDelay);
@@ -385,6 +565,78 @@ int BasicMP4Writer::initHeader (const uint32_t audioLength, const unsigned extra
   return bytesWritten;
 }
 
+int BasicMP4Writer::initFragments (const unsigned extraDelay)
+{
+  const uint32_t sgpdAtomSize = STSX_BSIZE + 4 /*defaultLength == 2*/ + 4 /*entryCount == 1*/ + 2 /*rollDistance*/;
+  const uint32_t mvexAtomSize = 8 + 32 /*trex*/;
+  const uint32_t stblIncrSize = m_ascSizeM5 + STSX_BSIZE + 4 /*stsz*/ + STSX_BSIZE * 2 /*stsc, stco*/ + sgpdAtomSize - 16 /*stts*/;
+  uint32_t* const header4Byte = (uint32_t* const) m_staticHeader;
+  int bytesWritten = 0;
+
+  if ((m_fileHandle == -1) || (m_frameCount > 0))
+  {
+    return 0; // invalid file handle or AUs already written
+  }
+
+  // init segment: moov with empty sample tables and mvex, durations left open
+  header4Byte[ 24>>2] = toBigEndian (toUShortValue (MOOV_BSIZE) + stblIncrSize + UDTA_BSIZE + mvexAtomSize);
+  header4Byte[ 56>>2] = 0;
+  header4Byte[164>>2] = toBigEndian (toUShortValue (TRAK_BSIZE) + stblIncrSize);
+  header4Byte[200>>2] = 0;
+  header4Byte[300>>2] = toBigEndian (toUShortValue (MDIA_BSIZE) + stblIncrSize);
+  header4Byte[332>>2] = 0;
+  header4Byte[376>>2] = toBigEndian (toUShortValue (MINF_BSIZE) + stblIncrSize);
+  header4Byte[288>>2] = 0;  // elst
+  header4Byte[436>>2] = toBigEndian (toUShortValue (STBL_BSIZE) + stblIncrSize);
+  header4Byte[444>>2] = toBigEndian (STSX_BSIZE); // stts
+  header4Byte[456>>2] = 0;
+
+  push32BitValue (STSX_BSIZE);
+  m_dynamicHeader.push_back (0x73); m_dynamicHeader.push_back (0x74);
+  m_dynamicHeader.push_back (0x73); m_dynamicHeader.push_back (0x63); // stsc
+  push32BitValue (0);
+  push32BitValue (0);
+  push32BitValue (STSX_BSIZE);
+  m_dynamicHeader.push_back (0x73); m_dynamicHeader.push_back (0x74);
+  m_dynamicHeader.push_back (0x63); m_dynamicHeader.push_back (0x6F); // stco
+  push32BitValue (0);
+  push32BitValue (0);
+  push32BitValue (sgpdAtomSize);
+  m_dynamicHeader.push_back (0x73); m_dynamicHeader.push_back (0x67);
+  m_dynamicHeader.push_back (0x70); m_dynamicHeader.push_back (0x64); // sgpd
+  push32BitValue (1 << 24);
+  m_dynamicHeader.push_back (0x70); m_dynamicHeader.push_back (0x72);
+  m_dynamicHeader.push_back (0x6F); m_dynamicHeader.push_back (0x6C); // prol
+  push32BitValue (2);
+  push32BitValue (1);
+  m_dynamicHeader.push_back (0);  m_dynamicHeader.push_back (m_frameLength > 1024 ? 2 : 1); // roll_distance
+  pushUserData ();
+  push32BitValue (mvexAtomSize);
+  m_dynamicHeader.push_back (0x6D); m_dynamicHeader.push_back (0x76);
+  m_dynamicHeader.push_back (0x65); m_dynamicHeader.push_back (0x78); // mvex
+  push32BitValue (32);
+  m_dynamicHeader.push_back (0x74); m_dynamicHeader.push_back (0x72);
+  m_dynamicHeader.push_back (0x65); m_dynamicHeader.push_back (0x78); // trex
+  push32BitValue (0);
+  push32BitValue (1); // track
+  push32BitValue (1); // stsd idx
+  push32BitValue (m_frameLength);
+  push32BitValue (0);
+  push32BitValue (0x01010000); // non-sync AUs by default
+
+  // write stts without its two entries
+  bytesWritten += m_writeBuffer.write (m_staticHeader, 460);
+  bytesWritten += m_writeBuffer.write (&m_staticHeader[476], STAT_HEADER_SIZE - 476);
+  bytesWritten += m_writeBuffer.write (&m_dynamicHeader.front (), (uint32_t) m_dynamicHeader.size ());
+
+  m_fragmented  = true;
+  m_mediaOffset = 0; // RA offsets are file offsets
+  m_mediaSize   = bytesWritten;
+  m_postLength -= __min (m_postLength, extraDelay);
+
+  return bytesWritten;
+}
+
 unsigned BasicMP4Writer::open (const int mp4FileHandle, const unsigned sampleRate,  const unsigned numChannels,
                                const unsigned bitDepth, const unsigned frameLength, const unsigned pregapLength,
                                const unsigned raPeriod, const uint8_t* ascBuf,      const unsigned ascSize,
@@ -403,6 +655,7 @@ unsigned BasicMP4Writer::open (const int mp4FileHandle, const unsigned sampleRat
   }
 
   m_fileHandle = mp4FileHandle;
+  m_writeBuffer.open (mp4FileHandle); // unbuffered if allocation fails
   reset (frameLength, pregapLength, __min (USHRT_MAX, raPeriod), sampleRate);
 
   // create fixed-length 576-byte part of MPEG-4 file header
@@ -467,6 +720,8 @@ unsigned BasicMP4Writer::open (const int mp4FileHandle, const unsigned sampleRat
 void BasicMP4Writer::reset (const unsigned frameLength, const unsigned pregapLength, const unsigned raPeriod, const unsigned sampleRate)
 {
   m_ascSizeM5    = 0;
+  m_fragmentCount = 0;
+  m_fragmented   = false;
   m_frameCount   = 0;
   m_frameLength  = frameLength;
   m_mediaOffset  = 0;  // offset of first 'mdat' data byte serialized to file
@@ -476,11 +731,16 @@ void BasicMP4Writer::reset (const unsigned frameLength, const unsigned pregapLen
   m_rndAccPeriod = raPeriod;
   m_sampleRate   = sampleRate;
   m_dynamicHeader.clear ();
+  m_fragmentData.clear ();
+  m_fragmentSizes.clear ();
+  m_fragmentSyncs.clear ();
   m_rndAccOffsets.clear ();
 #ifndef NO_PREROLL_DATA
   m_ipfCfgOffsets.clear ();
+  m_ipfConfig.clear ();
 #endif
 
+  m_writeBuffer.reset (); // discard pending bytes
   if (m_fileHandle != -1) _SEEK (m_fileHandle, 0, 0 /*SEEK_SET*/);
 }
 
@@ -495,6 +755,15 @@ int BasicMP4Writer::updateIPFs (const uint8_t* ascUcBuf, const uint32_t ascUcLen
     return 1; // invalid file handle or IPF config parameter
   }
 
+  if (m_fragmented && !m_fragmentSizes.empty ()) // wait until final fragment is written
+  {
+    m_ipfConfig.assign (&ascUcBuf[ucOffset], &ascUcBuf[ascUcLength]);
+
+    return 0;
+  }
+
+  if (m_writeBuffer.flush () > 0) return 1; // AUs must be in file
+
   // write updated UsacConfig() to AudioPreRoll() extensions
   for (uint32_t i = 0; i < (uint32_t) m_ipfCfgOffsets.size (); i++)
   {
@@ -502,7 +771,7 @@ int BasicMP4Writer::updateIPFs (const uint8_t* ascUcBuf, const uint32_t ascUcLen
 
     if (configOffset > 0) // this AU is an IPF
     {
-      _SEEK (m_fileHandle, m_rndAccOffsets.at (i << 1) + m_mediaOffset + configOffset, 0 /*SEEK_SET*/);
+      if (_SEEK (m_fileHandle, m_rndAccOffsets.at (i << 1) + m_mediaOffset + configOffset, 0 /*SEEK_SET*/) < 0) break;
       bytesWritten += _WRITE (m_fileHandle, &ascUcBuf[ucOffset], bw);
       configsWritten++;
     }
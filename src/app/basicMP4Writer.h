@@ -1,5 +1,5 @@
 /* basicMP4Writer.h - header file for class with basic MPEG-4 file writing capability
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -12,6 +12,7 @@
 #define _BASIC_MP4_WRITER_H_
 
 #include "exhaleAppPch.h"
+#include "basicWriteBuffer.h"
 
 // constant data sizes in bytes
 #define STAT_HEADER_SIZE   576
@@ -34,7 +35,10 @@ private:
   // member variables
   unsigned m_ascSizeM5;  // ASC + UsacConfig byte-size - 5
   int      m_fileHandle;
+  bool     m_flushOnIpf; // write out pending data at IPFs
   unsigned m_frameCount;
+  unsigned m_fragmentCount; // moof sequence number
+  bool     m_fragmented; // write moof + mdat fragments
   unsigned m_frameLength;
   uint32_t m_mediaOffset;  // offset of first mdat payload
   uint32_t m_mediaSize; // number of bytes of mdat content
@@ -43,19 +47,26 @@ private:
   unsigned m_rndAccPeriod;  // random-access (RA) interval
   unsigned m_sampleRate;
   uint8_t  m_staticHeader[STAT_HEADER_SIZE]; // fixed-size
+  BasicWriteBuffer m_writeBuffer; // combines small writes
   std::vector <uint8_t> m_dynamicHeader; // variable-sized
+  std::vector <uint8_t> m_fragmentData; // AUs of fragment
+  std::vector <uint32_t> m_fragmentSizes; // AU byte-sizes
+  std::vector <uint32_t> m_fragmentSyncs; // moof offsets
   std::vector <uint32_t> m_rndAccOffsets; // random access
 #ifndef NO_PREROLL_DATA
   std::vector <uint8_t> m_ipfCfgOffsets; // IPF UsacConfig
+  std::vector <uint8_t> m_ipfConfig; // deferred UsacConfig
 #endif
 
-  // helper function
-  void push32BitValue (const uint32_t value); // to header
+  // helper functions
+  void     push32BitValue (const uint32_t value); // to header
+  void     pushUserData ();
+  unsigned writeFragment  (const uint32_t finalFrameLength);
 
 public:
 
   // constructor
-  BasicMP4Writer () { m_fileHandle = -1;  reset (0, 0, 0, 0); }
+  BasicMP4Writer () { m_fileHandle = -1;  m_flushOnIpf = false;  reset (0, 0, 0, 0); }
   // destructor
 #ifdef NO_PREROLL_DATA
   ~BasicMP4Writer() { m_dynamicHeader.clear (); m_rndAccOffsets.clear (); }
@@ -68,11 +79,13 @@ public:
                   const uint32_t modifTime = 0, const uint8_t* ascBuf = nullptr);
   unsigned getFrameCount () const { return m_frameCount; }
   int initHeader (const uint32_t audioLength, const unsigned extraDelay);
+  int initFragments (const unsigned extraDelay); // instead of initHeader
   unsigned open  (const int mp4FileHandle, const unsigned sampleRate,  const unsigned numChannels,
                   const unsigned bitDepth, const unsigned frameLength, const unsigned pregapLength,
                   const unsigned raPeriod, const uint8_t* ascBuf,      const unsigned ascSize,
                   const uint32_t creatTime = 0, const char vbrQuality = 0);
   void     reset (const unsigned frameLength, const unsigned pregapLength, const unsigned raPeriod, const unsigned sampleRate);
+  void     setFlushOnIPF (const bool flushOnIpf) { m_flushOnIpf = flushOnIpf; } // for live streaming
 #ifndef NO_PREROLL_DATA
   int updateIPFs (const uint8_t* ascUcBuf, const uint32_t ascUcLength, const uint32_t ucOffset);
 #endif
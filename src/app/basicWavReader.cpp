@@ -1,5 +1,5 @@
 /* basicWavReader.cpp - source file for class with basic WAVE file reading capability
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -10,6 +10,13 @@
 
 #include "exhaleAppPch.h"
 #include "basicWavReader.h"
+#if BWR_MMAP_READ
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+#if BWR_CONV_SSE41
+# include <smmintrin.h>
+#endif
 
 // static helper functions
 static unsigned reverseFourBytes (const uint8_t* b)
@@ -25,22 +32,151 @@ static int64_t fourBytesToLength (const uint8_t* b, const int64_t lengthLimit)
 
   return __min (lengthLimit, chunkLength); // for security
 }
-#if BWR_BUFFERED_READ
-static inline unsigned getFrames (const int fileHandle, void* dataBuf, const unsigned frameCount,
-                                  const bool roundSize, const unsigned bytesPerFrame)
+
+// static sample conversion functions, to 24-bit PCM
+static void convDataFloat16 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
 {
-  const int size = ((frameCount + (roundSize ? 1 << (BWR_READ_FRACT - 1) : 0)) >> BWR_READ_FRACT) * bytesPerFrame;
-  int  bytesRead = _READ (fileHandle, dataBuf, size); // 1
+  const int16_t* fBuf = (const int16_t*) byteBuf; // words
+
+  for (unsigned i = sampleCount; i > 0; i--)
+  {
+    const int16_t i16 = *(fBuf++);
+    const int32_t e = ((i16 & 0x7C00) >> 10) - 18; // exp.
+    // an exponent e <= -12 will lead to zero-quantization
+    *frameBuf = int32_t (e < 0 ? (1024 + (i16 & 0x03FF) + (1 << (-1 - e)) /*rounding offset*/) >> -e
+                               : (e > 12 ? MAX_VALUE_AUDIO24 /*inf*/ : (1024 + (i16 & 0x03FF)) << e));
+    if ((i16 & 0x8000) != 0) *frameBuf *= -1; // neg. sign
+    frameBuf++;
+  }
+}
 
-  if ((bytesRead = __max (0, bytesRead)) < size)
+static void convDataFloat32 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  for (unsigned i = sampleCount; i > 0; i--)
   {
-    const int br = _READ (fileHandle, (uint8_t*) dataBuf + bytesRead, size - bytesRead);
+    float f32; // data chunk may be only 2-byte aligned
 
-    bytesRead += __max (0, br); // bytes of read attempt 2
+    memcpy (&f32, byteBuf, sizeof (float));
+    byteBuf += 4;
+    f32 *= float (1 << 23); // * 2^23
+    *frameBuf = int32_t (f32 + (f32 < 0.0 ? -0.5 : 0.5)); // rounding
+    if (*frameBuf < MIN_VALUE_AUDIO24) *frameBuf = MIN_VALUE_AUDIO24;
+    else
+    if (*frameBuf > MAX_VALUE_AUDIO24) *frameBuf = MAX_VALUE_AUDIO24;
+    frameBuf++;
   }
-  return bytesRead / bytesPerFrame;  // num of frames read
 }
-#endif
+
+static void convDataLnPcm08 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  for (unsigned i = sampleCount; i > 0; i--)
+  {
+    *(frameBuf++) = ((int32_t) *(byteBuf++) - 128) << 16; // * 2^16
+  }
+}
+
+static void convDataLnPcm16 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  const int16_t* iBuf = (const int16_t*) byteBuf; // words
+
+  for (unsigned i = sampleCount; i > 0; i--)
+  {
+    *(frameBuf++) = (int32_t) *(iBuf++) * (1 << 8); // * 2^8
+  }
+}
+
+static void convDataLnPcm24 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  for (unsigned i = sampleCount; i > 0; i--)
+  {
+    const int32_t i24 = (int32_t) byteBuf[0] | ((int32_t) byteBuf[1] << 8) | ((int32_t) byteBuf[2] << 16);
+    byteBuf += 3;
+    *(frameBuf++) = (i24 > MAX_VALUE_AUDIO24 ? i24 + 2 * MIN_VALUE_AUDIO24 : i24);
+  }
+}
+
+static void convDataLnPcm32 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  for (unsigned i = sampleCount; i > 0; i--)
+  {
+    int32_t i32; // data chunk may be only 2-byte aligned
+
+    memcpy (&i32, byteBuf, sizeof (int32_t));
+    byteBuf += 4;
+    const int32_t i24 = ((i32 >> 1) + (1 << 6)) >> 7; // * 2^-8 with rounding, overflow-safe
+    *(frameBuf++) = __min (MAX_VALUE_AUDIO24, i24);
+  }
+}
+#if BWR_CONV_SSE41
+
+// vectorized versions of the above, bit-exact to the scalar code
+static TARGET_SSE41 void convDataFloat32SSE41 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  const __m128  scale = _mm_set1_ps (float (1 << 23));
+  const __m128  half  = _mm_set1_ps (0.5f);
+  const __m128  mHalf = _mm_set1_ps (-0.5f);
+  const __m128i iMin  = _mm_set1_epi32 (INT_MIN); // result of invalid conversion
+  const __m128i vMax  = _mm_set1_epi32 (MAX_VALUE_AUDIO24);
+  const __m128i vMin  = _mm_set1_epi32 (MIN_VALUE_AUDIO24);
+  unsigned i = 0;
+
+  for (; i + 4 <= sampleCount; i += 4)
+  {
+    const __m128  f = _mm_mul_ps (_mm_loadu_ps ((const float*) byteBuf + i), scale);
+    const __m128i t = _mm_cvttps_epi32 (f);  // truncation, then round half away from zero
+    const __m128  r = _mm_sub_ps (f, _mm_cvtepi32_ps (t)); // exact fractional part
+    const __m128i v = _mm_andnot_si128 (_mm_cmpeq_epi32 (t, iMin), _mm_set1_epi32 (-1));
+    const __m128i u = _mm_and_si128 (_mm_castps_si128 (_mm_cmpge_ps (r, half)), v);
+    const __m128i d = _mm_and_si128 (_mm_castps_si128 (_mm_cmple_ps (r, mHalf)), v);
+
+    _mm_storeu_si128 ((__m128i*) (frameBuf + i), _mm_max_epi32 (vMin, _mm_min_epi32 (vMax, _mm_add_epi32 (_mm_sub_epi32 (t, u), d))));
+  }
+  convDataFloat32 (byteBuf + i * 4, frameBuf + i, sampleCount - i);
+}
+
+static TARGET_SSE41 void convDataLnPcm16SSE41 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  unsigned i = 0;
+
+  for (; i + 8 <= sampleCount; i += 8)
+  {
+    const __m128i w = _mm_loadu_si128 ((const __m128i*) (byteBuf + i * 2));
+
+    _mm_storeu_si128 ((__m128i*) (frameBuf + i),     _mm_slli_epi32 (_mm_cvtepi16_epi32 (w), 8));
+    _mm_storeu_si128 ((__m128i*) (frameBuf + i + 4), _mm_slli_epi32 (_mm_cvtepi16_epi32 (_mm_srli_si128 (w, 8)), 8));
+  }
+  convDataLnPcm16 (byteBuf + i * 2, frameBuf + i, sampleCount - i);
+}
+
+static TARGET_SSE41 void convDataLnPcm24SSE41 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  const __m128i shuf = _mm_setr_epi8 (-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11); // 3 bytes to top of dword
+  unsigned i = 0;
+
+  for (; i + 6 <= sampleCount; i += 4) // 16-byte loads, stay within the last 12 bytes
+  {
+    const __m128i b = _mm_loadu_si128 ((const __m128i*) (byteBuf + i * 3));
+
+    _mm_storeu_si128 ((__m128i*) (frameBuf + i), _mm_srai_epi32 (_mm_shuffle_epi8 (b, shuf), 8)); // sign extension
+  }
+  convDataLnPcm24 (byteBuf + i * 3, frameBuf + i, sampleCount - i);
+}
+
+static TARGET_SSE41 void convDataLnPcm32SSE41 (const uint8_t* byteBuf, int32_t* frameBuf, const unsigned sampleCount)
+{
+  const __m128i vOff = _mm_set1_epi32 (1 << 6);
+  const __m128i vMax = _mm_set1_epi32 (MAX_VALUE_AUDIO24);
+  unsigned i = 0;
+
+  for (; i + 4 <= sampleCount; i += 4)
+  {
+    const __m128i d = _mm_loadu_si128 ((const __m128i*) (byteBuf + i * 4));
+
+    _mm_storeu_si128 ((__m128i*) (frameBuf + i), _mm_min_epi32 (vMax, _mm_srai_epi32 (_mm_add_epi32 (_mm_srai_epi32 (d, 1), vOff), 7)));
+  }
+  convDataLnPcm32 (byteBuf + i * 4, frameBuf + i, sampleCount - i);
+}
+#endif // BWR_CONV_SSE41
 
 // private reader functions
 bool BasicWavReader::readRiffHeader ()
@@ -103,7 +239,39 @@ bool BasicWavReader::readDataHeader ()
   return (m_chunkLength > 0); // true: WAVE data available
 }
 
-// private helper function
+// private helper functions
+const uint8_t* BasicWavReader::getDataBytes (const unsigned byteCount, unsigned& bytesAvail)
+{
+  const uint8_t* dataBytes = nullptr;
+
+  if (m_mapData != nullptr) // memory-mapped file, no copy
+  {
+    bytesAvail = (unsigned) __min ((int64_t) byteCount, __max (0, m_mapLength - m_mapOffset));
+    dataBytes  = &m_mapData[m_mapOffset];
+    m_mapOffset += bytesAvail;
+
+    return dataBytes;
+  }
+  if (m_bufferFill - m_bufferOffset < byteCount) // refill read-ahead buffer with few large reads
+  {
+    int bytesRead = 1;
+
+    m_bufferFill -= m_bufferOffset;
+    memmove (m_byteBuffer, &m_byteBuffer[m_bufferOffset], m_bufferFill);
+    m_bufferOffset = 0;
+
+    while ((m_bufferFill < byteCount) && (bytesRead > 0)) // each read asks for all free buffer space
+    {
+      if ((bytesRead = (int) _READ (m_fileHandle, &m_byteBuffer[m_bufferFill], m_bufferSize - m_bufferFill)) > 0) m_bufferFill += bytesRead;
+    }
+  }
+  bytesAvail = __min (byteCount, m_bufferFill - m_bufferOffset);
+  dataBytes  = (const uint8_t*) &m_byteBuffer[m_bufferOffset];
+  m_bufferOffset += bytesAvail;
+
+  return dataBytes;
+}
+
 bool BasicWavReader::seekToChunkTag (uint8_t* const buf, const uint32_t tagID)
 {
   if ((m_bytesRead = _READ (m_fileHandle, buf, CHUNK_HEADER_SIZE)) != CHUNK_HEADER_SIZE) return false; // error
@@ -129,253 +297,12 @@ bool BasicWavReader::seekToChunkTag (uint8_t* const buf, const uint32_t tagID)
   return (m_bytesRemaining > 0);
 }
 
-// static reading functions
-unsigned BasicWavReader::readDataFloat16 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                          const unsigned chanCount, void* tempBuf)
-{
-#if BWR_BUFFERED_READ
-  const unsigned rest = ((frameCount >> (BWR_READ_FRACT - 1)) << (BWR_READ_FRACT - 1)) < frameCount ? 1 : 0;
-  unsigned framesRead = 0;
-
-  for (unsigned fract = 0; fract < (1 << BWR_READ_FRACT) + rest; fract++)
-  {
-    const int16_t* fBuf = (const int16_t*) tempBuf; // words
-    const unsigned read = getFrames (fileHandle, tempBuf, frameCount, (fract & 1), chanCount * 2);
-
-    for (unsigned i = read * chanCount; i > 0; i--)
-    {
-      const int16_t i16 = *(fBuf++);
-      const int32_t e = ((i16 & 0x7C00) >> 10) - 18; // exp.
-      // an exponent e <= -12 will lead to zero-quantization
-      *frameBuf = int32_t (e < 0 ? (1024 + (i16 & 0x03FF) + (1 << (-1 - e)) /*rounding offset*/) >> -e
-                                 : (e > 12 ? MAX_VALUE_AUDIO24 /*inf*/ : (1024 + (i16 & 0x03FF)) << e));
-      if ((i16 & 0x8000) != 0) *frameBuf *= -1; // neg. sign
-      frameBuf++;
-    }
-    framesRead += read;
-  }
-  if (framesRead < frameCount) // zero out missing samples
-  {
-    memset (frameBuf, 0, (frameCount - framesRead) * chanCount * sizeof (int32_t));
-  }
-  return framesRead;
-#else
-  unsigned bytesRead = 0;
-
-  for (unsigned i = frameCount * chanCount; i > 0; i--)
-  {
-    int16_t i16 = 0;
-
-    bytesRead += _READ (fileHandle, &i16, 2);
-
-    const int32_t e = ((i16 & 0x7C00) >> 10) - 18; // exp.
-    // an exponent e <= -12 will lead to zero-quantization
-    *frameBuf = int32_t (e < 0 ? (1024 + (i16 & 0x03FF) + (1 << (-1 - e)) /*rounding offset*/) >> -e
-                               : (e > 12 ? MAX_VALUE_AUDIO24 /*inf*/ : (1024 + (i16 & 0x03FF)) << e));
-    if ((i16 & 0x8000) != 0) *frameBuf *= -1; // neg. sign
-    frameBuf++;
-  }
-  return bytesRead / (chanCount * 2);
-#endif
-}
-
-unsigned BasicWavReader::readDataFloat32 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                          const unsigned chanCount, void* tempBuf)
-{
-#if BWR_BUFFERED_READ
-  const unsigned rest = ((frameCount >> (BWR_READ_FRACT - 1)) << (BWR_READ_FRACT - 1)) < frameCount ? 1 : 0;
-  unsigned framesRead = 0;
-
-  for (unsigned fract = 0; fract < (1 << BWR_READ_FRACT) + rest; fract++)
-  {
-    const float*   fBuf = (const float*) tempBuf; // 4 bytes
-    const unsigned read = getFrames (fileHandle, tempBuf, frameCount, (fract & 1), chanCount * 4);
-
-    for (unsigned i = read * chanCount; i > 0; i--)
-    {
-      const float   f32 = *fBuf * float (1 << 23); // * 2^23
-      fBuf++;
-      *frameBuf = int32_t (f32 + (f32 < 0.0 ? -0.5 : 0.5)); // rounding
-      if (*frameBuf < MIN_VALUE_AUDIO24) *frameBuf = MIN_VALUE_AUDIO24;
-      else
-      if (*frameBuf > MAX_VALUE_AUDIO24) *frameBuf = MAX_VALUE_AUDIO24;
-      frameBuf++;
-    }
-    framesRead += read;
-  }
-  if (framesRead < frameCount) // zero out missing samples
-  {
-    memset (frameBuf, 0, (frameCount - framesRead) * chanCount * sizeof (int32_t));
-  }
-  return framesRead;
-#else
-  unsigned bytesRead = 0;
-
-  for (unsigned i = frameCount * chanCount; i > 0; i--)
-  {
-    float f32 = 0.0;
-
-    bytesRead += _READ (fileHandle, &f32, 4);
-    *frameBuf = int32_t (f32 * (1 << 23) + (f32 < 0.0 ? -0.5 : 0.5)); // * 2^23 with rounding
-    if (*frameBuf < MIN_VALUE_AUDIO24) *frameBuf = MIN_VALUE_AUDIO24;
-    else
-    if (*frameBuf > MAX_VALUE_AUDIO24) *frameBuf = MAX_VALUE_AUDIO24;
-    frameBuf++;
-  }
-  return bytesRead / (chanCount * 4);
-#endif
-}
-
-unsigned BasicWavReader::readDataLnPcm08 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                          const unsigned chanCount, void* tempBuf)
-{
-#if BWR_BUFFERED_READ
-  const unsigned rest = ((frameCount >> (BWR_READ_FRACT - 1)) << (BWR_READ_FRACT - 1)) < frameCount ? 1 : 0;
-  unsigned framesRead = 0;
-
-  for (unsigned fract = 0; fract < (1 << BWR_READ_FRACT) + rest; fract++)
-  {
-    const uint8_t* iBuf = (const uint8_t*) tempBuf; // 1b
-    const unsigned read = getFrames (fileHandle, tempBuf, frameCount, (fract & 1), chanCount);
-
-    for (unsigned i = read * chanCount; i > 0; i--)
-    {
-      *(frameBuf++) = ((int32_t) *(iBuf++) - 128) << 16; // * 2^16
-    }
-    framesRead += read;
-  }
-  if (framesRead < frameCount) // zero out missing samples
-  {
-    memset (frameBuf, 0, (frameCount - framesRead) * chanCount * sizeof (int32_t));
-  }
-  return framesRead;
-#else
-  unsigned bytesRead = 0;
-
-  for (unsigned i = frameCount * chanCount; i > 0; i--)
-  {
-    uint8_t ui8 = 128;
-
-    bytesRead += _READ (fileHandle, &ui8, 1);
-    *(frameBuf++) = ((int32_t) ui8 - 128) << 16; // * 2^16
-  }
-  return bytesRead / chanCount;
-#endif
-}
-
-unsigned BasicWavReader::readDataLnPcm16 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                          const unsigned chanCount, void* tempBuf)
-{
-#if BWR_BUFFERED_READ
-  const unsigned rest = ((frameCount >> (BWR_READ_FRACT - 1)) << (BWR_READ_FRACT - 1)) < frameCount ? 1 : 0;
-  unsigned framesRead = 0;
-
-  for (unsigned fract = 0; fract < (1 << BWR_READ_FRACT) + rest; fract++)
-  {
-    const int16_t* iBuf = (const int16_t*) tempBuf; // words
-    const unsigned read = getFrames (fileHandle, tempBuf, frameCount, (fract & 1), chanCount * 2);
-
-    for (unsigned i = read * chanCount; i > 0; i--)
-    {
-      *(frameBuf++) = (int32_t) *(iBuf++) * (1 << 8); // * 2^8
-    }
-    framesRead += read;
-  }
-  if (framesRead < frameCount) // zero out missing samples
-  {
-    memset (frameBuf, 0, (frameCount - framesRead) * chanCount * sizeof (int32_t));
-  }
-  return framesRead;
-#else
-  unsigned bytesRead = 0;
-
-  for (unsigned i = frameCount * chanCount; i > 0; i--)
-  {
-    int16_t i16 = 0;
-
-    bytesRead += _READ (fileHandle, &i16, 2);
-    *(frameBuf++) = (int32_t) i16 << 8; // * 2^8
-  }
-  return bytesRead / (chanCount * 2);
-#endif
-}
-
-unsigned BasicWavReader::readDataLnPcm24 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                          const unsigned chanCount, void* tempBuf)
-{
-#if BWR_BUFFERED_READ
-  const unsigned rest = ((frameCount >> (BWR_READ_FRACT - 1)) << (BWR_READ_FRACT - 1)) < frameCount ? 1 : 0;
-  unsigned framesRead = 0;
-
-  for (unsigned fract = 0; fract < (1 << BWR_READ_FRACT) + rest; fract++)
-  {
-    const uint8_t* iBuf = (const uint8_t*) tempBuf; // 3b
-    const unsigned read = getFrames (fileHandle, tempBuf, frameCount, (fract & 1), chanCount * 3);
-
-    for (unsigned i = read * chanCount; i > 0; i--)
-    {
-      const int32_t i24 = (int32_t) iBuf[0] | ((int32_t) iBuf[1] << 8) | ((int32_t) iBuf[2] << 16);
-      iBuf += 3;
-      *(frameBuf++) = (i24 > MAX_VALUE_AUDIO24 ? i24 + 2 * MIN_VALUE_AUDIO24 : i24);
-    }
-    framesRead += read;
-  }
-  if (framesRead < frameCount) // zero out missing samples
-  {
-    memset (frameBuf, 0, (frameCount - framesRead) * chanCount * sizeof (int32_t));
-  }
-  return framesRead;
-#else
-  unsigned bytesRead = 0;
-
-  for (unsigned i = frameCount * chanCount; i > 0; i--)
-  {
-    int32_t i24 = 0;
-
-    bytesRead += _READ (fileHandle, &i24, 3);
-    *(frameBuf++) = (i24 > MAX_VALUE_AUDIO24 ? i24 + 2 * MIN_VALUE_AUDIO24 : i24);
-  }
-  return bytesRead / (chanCount * 3);
-#endif
-}
-
-unsigned BasicWavReader::readDataLnPcm32 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                          const unsigned chanCount, void* tempBuf)
+void BasicWavReader::unmapFile ()
 {
-#if BWR_BUFFERED_READ
-  const unsigned rest = ((frameCount >> (BWR_READ_FRACT - 1)) << (BWR_READ_FRACT - 1)) < frameCount ? 1 : 0;
-  unsigned framesRead = 0;
-
-  for (unsigned fract = 0; fract < (1 << BWR_READ_FRACT) + rest; fract++)
-  {
-    const int32_t* iBuf = (const int32_t*) tempBuf; // dword
-    const unsigned read = getFrames (fileHandle, tempBuf, frameCount, (fract & 1), chanCount * 4);
-
-    for (unsigned i = read * chanCount; i > 0; i--)
-    {
-      const int32_t i24 = ((*iBuf >> 1) + (1 << 6)) >> 7; // * 2^-8 with rounding, overflow-safe
-      iBuf++;
-      *(frameBuf++) = __min (MAX_VALUE_AUDIO24, i24);
-    }
-    framesRead += read;
-  }
-  if (framesRead < frameCount) // zero out missing samples
-  {
-    memset (frameBuf, 0, (frameCount - framesRead) * chanCount * sizeof (int32_t));
-  }
-  return framesRead;
-#else
-  unsigned bytesRead = 0;
-
-  for (unsigned i = frameCount * chanCount; i > 0; i--)
-  {
-    int32_t i24 = 0;
-    bytesRead += _READ (fileHandle, &i24, 4);
-    i24 = ((i24 >> 1) + (1 << 6)) >> 7; // * 2^-8 with rounding, overflow-safe
-    *(frameBuf++) = __min (MAX_VALUE_AUDIO24, i24);
-  }
-  return bytesRead / (chanCount * 4);
+#if BWR_MMAP_READ
+  if (m_mapData != nullptr) munmap ((void*) m_mapData, (size_t) m_mapLength);
 #endif
+  m_mapData = nullptr;
 }
 
 // public functions
@@ -408,9 +335,35 @@ unsigned BasicWavReader::open (const int wavFileHandle, const uint16_t maxFrameR
   {
     return 4; // WAVE data part invalid or unsupported
   }
-  if ((m_byteBuffer = (char*) malloc (m_waveFrameSize * ((maxFrameRead + (1 << (BWR_READ_FRACT - 1))) >> BWR_READ_FRACT))) == nullptr)
+#if BWR_MMAP_READ
+  if (fileLength < LLONG_MAX) // regular file: map it and convert directly from the page cache
+  {
+    const int64_t dataOffset = lseek (m_fileHandle, 0, 1 /*SEEK_CUR*/);
+    struct stat   fileStat;
+
+    if ((dataOffset > 0) && (fstat (m_fileHandle, &fileStat) == 0) && S_ISREG (fileStat.st_mode) && (fileStat.st_size > dataOffset) &&
+        (sizeof (size_t) >= 8 || fileStat.st_size < (1 << 30)))
+    {
+      void* mapData = mmap (nullptr, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, m_fileHandle, 0);
+
+      if (mapData != MAP_FAILED)
+      {
+        madvise (mapData, (size_t) fileStat.st_size, MADV_SEQUENTIAL);
+        m_mapData   = (const uint8_t*) mapData;
+        m_mapLength = fileStat.st_size;
+        m_mapOffset = dataOffset;
+      }
+    }
+  }
+  if (m_mapData == nullptr) // pipe, or mapping failed
+#endif
   {
-    return 5; // read-in byte buffer allocation failed
+    m_bufferSize = __max (BWR_READ_AHEAD, m_waveFrameSize * maxFrameRead);
+
+    if ((m_byteBuffer = (char*) malloc (m_bufferSize)) == nullptr)
+    {
+      return 5; // read-in byte buffer allocation failed
+    }
   }
   m_frameLimit = maxFrameRead;
 
@@ -426,33 +379,53 @@ unsigned BasicWavReader::open (const int wavFileHandle, const uint16_t maxFrameR
     switch (m_waveBitDepth)
     {
       case 8:
-        m_readDataFunc = readDataLnPcm08; break;
+        m_convDataFunc = convDataLnPcm08; break;
       case 16:
-        m_readDataFunc = readDataLnPcm16; break;
+        m_convDataFunc = convDataLnPcm16; break;
       case 24:
-        m_readDataFunc = readDataLnPcm24; break;
+        m_convDataFunc = convDataLnPcm24; break;
       default:
-        m_readDataFunc = readDataLnPcm32; break;
+        m_convDataFunc = convDataLnPcm32; break;
     }
   }
-  else  m_readDataFunc = (m_waveBitDepth == 16 ? readDataFloat16 : readDataFloat32);
+  else  m_convDataFunc = (m_waveBitDepth == 16 ? convDataFloat16 : convDataFloat32);
+#if BWR_CONV_SSE41
+
+  if (isSse41Supported ()) // use vectorized converter
+  {
+    if (m_convDataFunc == convDataLnPcm16) m_convDataFunc = convDataLnPcm16SSE41;
+    else
+    if (m_convDataFunc == convDataLnPcm24) m_convDataFunc = convDataLnPcm24SSE41;
+    else
+    if (m_convDataFunc == convDataLnPcm32) m_convDataFunc = convDataLnPcm32SSE41;
+    else
+    if (m_convDataFunc == convDataFloat32) m_convDataFunc = convDataFloat32SSE41;
+  }
+#endif
 
-  return (m_readDataFunc == nullptr ? 6 : 0); // 0: OK
+  return (m_convDataFunc == nullptr ? 6 : 0); // 0: OK
 }
 
 unsigned BasicWavReader::read (int32_t* const frameBuf, const uint16_t frameCount)
 {
   const unsigned framesTotal = __min (m_frameLimit, frameCount);
+  const uint8_t* dataBytes;
   unsigned framesRead;
 
-  if ((frameBuf == nullptr) || (m_fileHandle == -1) || (framesTotal == 0) || (m_byteBuffer == nullptr) ||
+  if ((frameBuf == nullptr) || (m_fileHandle == -1) || (framesTotal == 0) || (m_byteBuffer == nullptr && m_mapData == nullptr) ||
       (m_bytesRemaining <= 0)) // end of chunk reached
   {
     if (frameBuf != nullptr) memset (frameBuf, 0, framesTotal * m_waveChannels * sizeof (int32_t));
 
     return 0; // invalid args or class not initialized
   }
-  framesRead  = m_readDataFunc (m_fileHandle, frameBuf, framesTotal, m_waveChannels, m_byteBuffer);
+  dataBytes  = getDataBytes (framesTotal * m_waveFrameSize, m_bytesRead);
+  framesRead = m_bytesRead / m_waveFrameSize;
+  m_convDataFunc (dataBytes, frameBuf, framesRead * m_waveChannels);
+  if (framesRead < framesTotal) // zero out missing samples
+  {
+    memset (&frameBuf[framesRead * m_waveChannels], 0, (framesTotal - framesRead) * m_waveChannels * sizeof (int32_t));
+  }
   m_bytesRead = m_waveFrameSize * framesRead;
   if ((m_bytesRemaining -= m_bytesRead) < 0)
   {
@@ -468,12 +441,19 @@ unsigned BasicWavReader::read (int32_t* const frameBuf, const uint16_t frameCoun
 
 void BasicWavReader::reset ()
 {
+  unmapFile ();
+
   m_byteBuffer     = nullptr;
+  m_bufferFill     = 0;
+  m_bufferOffset   = 0;
+  m_bufferSize     = 0;
   m_bytesRead      = 0;
   m_bytesRemaining = 0;
   m_chunkLength    = 0;
+  m_convDataFunc   = nullptr;
   m_frameLimit     = 0;
-  m_readDataFunc   = nullptr;
+  m_mapLength      = 0;
+  m_mapOffset      = 0;
   m_readOffset     = 0;
   m_waveBitDepth   = 0;
   m_waveChannels   = 0;
@@ -481,3 +461,28 @@ void BasicWavReader::reset ()
 
   if (m_fileHandle != -1) _SEEK (m_fileHandle, 0, 0 /*SEEK_SET*/);
 }
+
+int64_t BasicWavReader::skip (const int64_t frameCount)
+{
+  const int64_t bytesSkip = __min (m_bytesRemaining, frameCount * m_waveFrameSize);
+  const int64_t bytesBuff = __min (bytesSkip, (int64_t) m_bufferFill - m_bufferOffset);
+
+  if ((m_fileHandle == -1) || (bytesSkip <= 0))
+  {
+    return 0; // invalid args or class not initialized
+  }
+  if (m_mapData != nullptr) m_mapOffset += bytesSkip;
+  else
+  {
+    m_bufferOffset += (unsigned) bytesBuff; // skip buffered bytes first
+
+    if ((bytesSkip > bytesBuff) && (_SEEK (m_fileHandle, bytesSkip - bytesBuff, 1 /*SEEK_CUR*/) < 0))
+    {
+      return 0; // file seek failed
+    }
+  }
+  m_bytesRemaining -= bytesSkip;
+  m_chunkLength    += bytesSkip;
+
+  return bytesSkip / m_waveFrameSize;
+}
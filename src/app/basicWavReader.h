@@ -1,5 +1,5 @@
 /* basicWavReader.h - header file for class with basic WAVE file reading capability
- * written by C. R. Helmrich, last modified in 2020 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -12,10 +12,16 @@
 #define _BASIC_WAV_READER_H_
 
 #include "exhaleAppPch.h"
+#include "../lib/exhaleLibPch.h" // for SIMD_X86, CPU feature checks
 
 // constant data sizes & limits
-#define BWR_BUFFERED_READ        1 // faster reader
-#define BWR_READ_FRACT           5 // 2^-READ_FRACT
+#if defined (_WIN32) || defined (WIN32) || defined (_WIN64) || defined (WIN64)
+# define BWR_MMAP_READ           0
+#else
+# define BWR_MMAP_READ           1 // 1: memory-map regular files
+#endif
+#define BWR_CONV_SSE41           SIMD_X86 // 1: use SSE4.1 conversion if CPU supports it
+#define BWR_READ_AHEAD   (1 << 20) // read-ahead bytes for pipes
 #define CHUNK_FORMAT_MAX        40
 #define CHUNK_FORMAT_SIZE       16
 #define CHUNK_HEADER_SIZE        8
@@ -31,8 +37,8 @@ typedef enum WAV_TYPE
   WAV_FLOAT    // IEEE float
 } WAV_TYPE;
 
-// data reader function pointer
-typedef unsigned (*ReadFunc) (const int, int32_t*, const unsigned, const unsigned, void*);
+// sample converter function pointer
+typedef void (*ConvFunc) (const uint8_t*, int32_t*, const unsigned);
 
 // basic WAV audio reader class
 class BasicWavReader
@@ -40,13 +46,19 @@ class BasicWavReader
 private:
 
   // member variables
-  char*    m_byteBuffer;
+  char*    m_byteBuffer; // read-ahead buffer
+  unsigned m_bufferFill;
+  unsigned m_bufferOffset;
+  unsigned m_bufferSize;
   unsigned m_bytesRead;
   int64_t  m_bytesRemaining;
   int64_t  m_chunkLength;
+  ConvFunc m_convDataFunc;
   int      m_fileHandle;
   unsigned m_frameLimit;
-  ReadFunc m_readDataFunc;
+  const uint8_t* m_mapData; // mapped file or nullptr
+  int64_t  m_mapLength;
+  int64_t  m_mapOffset;
   int64_t  m_readOffset;
   unsigned m_waveBitDepth;
   unsigned m_waveBitRate;
@@ -58,27 +70,16 @@ private:
   bool     readRiffHeader ();
   bool     readFormatChunk();
   bool     readDataHeader ();
-  // private helper function
+  // private helper functions
+  const uint8_t* getDataBytes (const unsigned byteCount, unsigned& bytesAvail);
   bool     seekToChunkTag (uint8_t* const buf, const uint32_t tagName);
-  // static reading functions
-  static unsigned readDataFloat16 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                   const unsigned chanCount, void* tempBuf);
-  static unsigned readDataFloat32 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                   const unsigned chanCount, void* tempBuf);
-  static unsigned readDataLnPcm08 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                   const unsigned chanCount, void* tempBuf);
-  static unsigned readDataLnPcm16 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                   const unsigned chanCount, void* tempBuf);
-  static unsigned readDataLnPcm24 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                   const unsigned chanCount, void* tempBuf);
-  static unsigned readDataLnPcm32 (const int fileHandle, int32_t* frameBuf, const unsigned frameCount,
-                                   const unsigned chanCount, void* tempBuf);
+  void     unmapFile ();
 public:
 
   // constructor
-  BasicWavReader () { m_fileHandle = -1;  reset (); }
+  BasicWavReader () { m_fileHandle = -1;  m_mapData = nullptr;  reset (); }
   // destructor
-  ~BasicWavReader() { if (m_byteBuffer != nullptr) free ((void*) m_byteBuffer); }
+  ~BasicWavReader() { if (m_byteBuffer != nullptr) free ((void*) m_byteBuffer);  unmapFile (); }
   // public functions
   int64_t  getDataBytesLeft () const { return m_bytesRemaining; }
   int64_t  getDataBytesRead () const { return m_chunkLength; }
@@ -88,6 +89,7 @@ public:
   unsigned open  (const int wavFileHandle, const uint16_t maxFrameRead, const int64_t fileLength = LLONG_MAX /*for stdin*/);
   unsigned read  (int32_t* const frameBuf, const uint16_t frameCount);
   void     reset ();
+  int64_t  skip  (const int64_t frameCount); // seeks forward
 }; // BasicWavReader
 
 #endif // _BASIC_WAV_READER_H_
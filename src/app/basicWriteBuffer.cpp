@@ -0,0 +1,83 @@
+/* basicWriteBuffer.cpp - source file for class with write-combining file output capability
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2021 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#include "exhaleAppPch.h"
+#include "basicWriteBuffer.h"
+
+// private helper function
+int BasicWriteBuffer::writeOut (const uint8_t* data, const uint32_t byteCount)
+{
+  uint32_t bytesLeft = byteCount;
+
+  while (bytesLeft > 0) // pipes may accept fewer bytes per call
+  {
+    const int bw = _WRITE (m_fileHandle, data, bytesLeft);
+
+    if (bw <= 0) return (bytesLeft == byteCount ? bw : int (byteCount - bytesLeft));
+
+    data += bw;
+    bytesLeft -= (uint32_t) bw;
+  }
+  return (int) byteCount;
+}
+
+// public functions
+unsigned BasicWriteBuffer::flush ()
+{
+  const uint32_t bytesPending = m_bufferFill;
+
+  m_bufferFill = 0;
+  if (bytesPending == 0) return 0; // nothing to do
+
+  return (writeOut (m_bufferData, bytesPending) != (int) bytesPending ? 1 : 0);
+}
+
+unsigned BasicWriteBuffer::open (const int fileHandle, const uint32_t bufferSize)
+{
+  if ((fileHandle == -1) || (bufferSize < BWB_BUFFER_ALIGN) || (bufferSize > (1u << 24)))
+  {
+    return 1; // invalid file handle or buffer size
+  }
+  if ((m_bufferMem == nullptr) || (m_bufferSize != bufferSize))
+  {
+    MFREE (m_bufferMem);
+
+    if ((m_bufferMem = (uint8_t*) malloc (bufferSize + BWB_BUFFER_ALIGN - 1)) == nullptr)
+    {
+      m_fileHandle = fileHandle; // unbuffered fall-back
+      m_bufferSize = 0;
+      reset ();
+
+      return 2; // memory allocation error
+    }
+    m_bufferData = (uint8_t*) (((uintptr_t) m_bufferMem + BWB_BUFFER_ALIGN - 1) & ~(uintptr_t) (BWB_BUFFER_ALIGN - 1));
+    m_bufferSize = bufferSize;
+  }
+  m_fileHandle = fileHandle;
+  reset ();
+
+  return 0; // no error
+}
+
+int BasicWriteBuffer::write (const uint8_t* data, const uint32_t byteCount)
+{
+  if ((m_bufferMem == nullptr) || (m_bufferSize == 0)) return _WRITE (m_fileHandle, data, byteCount);
+
+  if (m_bufferFill + byteCount > m_bufferSize) // make room
+  {
+    if (flush () > 0) return -1;
+  }
+  if (byteCount >= m_bufferSize) return writeOut (data, byteCount); // large block
+
+  memcpy (&m_bufferData[m_bufferFill], data, byteCount);
+  m_bufferFill += byteCount;
+
+  return (int) byteCount;
+}
@@ -0,0 +1,50 @@
+/* basicWriteBuffer.h - header file for class with write-combining file output capability
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2021 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#ifndef _BASIC_WRITE_BUFFER_H_
+#define _BASIC_WRITE_BUFFER_H_
+
+#include "exhaleAppPch.h"
+
+// constants, experimental macros
+#define BWB_BUFFER_ALIGN   64 // byte alignment of buffer
+#define BWB_BUFFER_SIZE (1 << 16) // default buffer size
+
+// write-combining output class
+class BasicWriteBuffer
+{
+private:
+
+  // member variables
+  uint8_t* m_bufferData; // aligned start of m_bufferMem
+  uint32_t m_bufferFill; // number of bytes pending
+  uint8_t* m_bufferMem;
+  uint32_t m_bufferSize;
+  int      m_fileHandle;
+
+  // helper functions
+  int      writeOut (const uint8_t* data, const uint32_t byteCount); // unbuffered
+
+public:
+
+  // constructor
+  BasicWriteBuffer () { m_bufferData = m_bufferMem = nullptr;  m_bufferSize = 0;  m_fileHandle = -1;  reset (); }
+  // destructor
+  ~BasicWriteBuffer() { MFREE (m_bufferMem); }
+  // public functions
+  unsigned flush ();  // write all pending bytes to file
+  uint32_t getFill () const { return m_bufferFill; }
+  int      getHandle () const { return m_fileHandle; }
+  unsigned open  (const int fileHandle, const uint32_t bufferSize = BWB_BUFFER_SIZE);
+  void     reset () { m_bufferFill = 0; } // discard pending bytes
+  int      write (const uint8_t* data, const uint32_t byteCount); // same result as _WRITE
+}; // BasicWriteBuffer
+
+#endif // _BASIC_WRITE_BUFFER_H_
@@ -1,5 +1,5 @@
 /* exhaleApp.cpp - source file with main() routine for exhale application executable
- * written by C. R. Helmrich, last modified in 2023 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -24,6 +24,9 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <time.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #if defined (_WIN32) || defined (WIN32) || defined (_WIN64) || defined (WIN64)
 #include <direct.h>
 #include <windows.h>
@@ -78,242 +81,660 @@
 #define EA_PEAK_NORM -96.33f  // 20 * log10(2^-16), 16-bit normalization
 #define EA_PEAK_MIN   0.262f  // 20 * log10() + EA_PEAK_NORM = -108 dbFS
 #define EA_USE_WORK_DIR    1  // 1: use working instead of app directory
+#define EA_NUM_THREADS     4  // >1: element-parallel multichannel coding
+#define EA_SEG_THREADS    32  // >1: segment-parallel coding via option p
+#define EA_SEG_MIN_IPFS    4  // min. number of IPF periods per segment
+#define EA_SEG_MAX_IPFS   32  // max. number of IPF periods per segment
+#define EA_PIPE_SLOTS      4  // >1: threaded read, encode & write stages
 #define ENABLE_STDOUT_LOAS 0  // 1: experimental LOAS packed pipe output
+#define EA_FRAME_STATS     1  // 1: per-frame CSV/JSON stats via option c/j
 #define FULL_FRM_LOOKAHEAD   // on: encoder delay = zero or frame length
 
-static const int16_t usfc2x[32] = { // 2x upsampling filter coefficients
-  (83359-65536), -27563, 16273, -11344, 8541, -6708, 5403, -4419, 3647, -3025, 2514, -2088, 1730,
-  -1428, 1173, -957, 775, -622, 494, -388, 300, -230, 172, -127, 91, -63, 43, -27, 16, -9, 4, -1
-};
-
-static const int16_t rsfc3x[128] = {// 3x resampling filter coefficients
-  21846, 6711, (36099-32768), 0, -18000, -14370, 0, 10208, 8901, 0, -7062, -6389, 0, 5347, 4934, 0, -4258,
-  -3977, 0, 3499, 3294, 0, -2937, -2780, 0, 2501, 2376, 0, -2151, -2050, 0, 1864, 1779, 0, -1623, -1551,
-  0, 1417, 1355, 0, -1240, -1187, 0, 1086, 1040, 0, -952, -910, 0, 833, 797, 0, -728, -696, 0, 635, 607,
-  0, -553, -528, 0, 480, 457, 0, -415, -395, 0, 358, 340, 0, -307, -291, 0, 262, 248, 0, -223, -211, 0,
-  188, 177, 0, -158, -149, 0, 132, 124, 0, -109, -102, 0, 90, 84, 0, -73, -68, 0, 59, 55, 0, -47, -43,
-  0, 37, 34, 0, -29, -26, 0, 22, 20, 0, -16, -15, 0, 12, 10, 0, -8, -7, 0, 5, 5, 0, -3, -3, 0, 2
-};
-
-static bool eaInitUpsampler2x (int32_t** upsampleBuffer, const uint16_t bitRateMode, const uint16_t sampleRate,
+static bool eaInitUpsampler2x (ExhaleResAPI** resampler, const uint16_t bitRateMode, const uint16_t sampleRate,
                                const uint16_t frameSize, const uint16_t numChannels)
 {
-  const uint16_t inLength = frameSize >> 1;
-  const uint16_t chLength = inLength + (32 << 1);
   const bool useUpsampler = (frameSize > (32 << 1) && bitRateMode * 3675 > sampleRate);
 
-  if (useUpsampler)
-  {
-    if ((*upsampleBuffer = (int32_t*) malloc (chLength * numChannels * sizeof (int32_t))) == nullptr) return false;
+  if (useUpsampler) *resampler = exhaleCreateResampler (sampleRate, sampleRate * 2u, numChannels, frameSize);
 
-    for (uint16_t ch = 0; ch < numChannels; ch++)
-    {
-      memset (*upsampleBuffer + inLength + chLength * ch, 0, (chLength - inLength) * sizeof (int32_t));
-    }
-  }
-  return useUpsampler;
+  return useUpsampler && (*resampler != nullptr);
 }
 
-static bool eaInitDownsampler (int32_t** resampleBuffer, const uint16_t bitRateMode, const uint16_t sampleRate,
+static bool eaInitDownsampler (ExhaleResAPI** resampler, const uint16_t bitRateMode, const uint16_t sampleRate,
                                const uint16_t frameSize, const uint16_t numChannels)
 {
-  const uint16_t inLength = (frameSize * 3u) >> 1;
-  const uint16_t chLength = inLength + (frameSize >> 3);
   const bool useResampler = (frameSize >= 512 && bitRateMode <= 1 && sampleRate == 48000);
 
-  if (useResampler)
+  if (useResampler) *resampler = exhaleCreateResampler (sampleRate, 32000, numChannels, frameSize);
+
+  return useResampler && (*resampler != nullptr);
+}
+
+static uint16_t eaApplyLevelNorm (int32_t* /*o*/ pcmBuffer, uint16_t* oldLoudness, const uint16_t currLoudness,
+                                  const uint16_t frameSize, const uint16_t numChannels)
+{
+  const int64_t gainOld = __min (MAX_VALUE_AUDIO24, int64_t (0.5f + MAX_VALUE_AUDIO24 * pow (10.0f, (77.0f - *oldLoudness / 512.f) / 20.0f)));
+  const int64_t gainNew = __min (MAX_VALUE_AUDIO24, int64_t (0.5f + MAX_VALUE_AUDIO24 * pow (10.0f, (77.0f - currLoudness / 512.f) / 20.0f)));
+  const int64_t gRShift = 32 + __min (3, frameSize >> 10);
+  const int64_t gOffset = (int64_t) 1 << (gRShift - 1);
+  uint16_t ch, i;
+
+  if ((frameSize & (frameSize - 1)) || !pcmBuffer) return 0;
+
+  for (i = frameSize; i > 0; i--)
   {
-    if ((*resampleBuffer = (int32_t*) malloc (chLength * numChannels * sizeof (int32_t))) == nullptr) return false;
+    const int64_t gainI = gainOld * i + gainNew * (frameSize - i);
 
-    for (uint16_t ch = 0; ch < numChannels; ch++)
+    for (ch = numChannels; ch > 0; ch--, pcmBuffer++)
     {
-      memset (*resampleBuffer + inLength + chLength * ch, 0, (chLength - inLength) * sizeof (int32_t));
+      *pcmBuffer = int32_t ((gOffset + *pcmBuffer * gainI) >> gRShift);
     }
   }
-  return useResampler;
+  return (*oldLoudness = currLoudness);
+}
+
+static uint32_t eaGetMp4Time () // seconds since 1904, SOURCE_DATE_EPOCH overrides the current time for reproducible files
+{
+  time_t t = time (nullptr);
+#ifdef _MSC_VER
+  char* epoch = nullptr;
+  size_t len = 0;
+
+  if ((_dupenv_s (&epoch, &len, "SOURCE_DATE_EPOCH") == 0) && (epoch != nullptr)) t = (time_t) _strtoi64 (epoch, nullptr, 10);
+  free (epoch);
+#else
+  const char* const epoch = getenv ("SOURCE_DATE_EPOCH");
+
+  if (epoch != nullptr) t = (time_t) strtoll (epoch, nullptr, 10);
+#endif
+  return (t + 2082844800) & UINT_MAX;
+}
+
+#if ENABLE_STDOUT_LOAS
+static uint16_t eaInitLoasHeader (uint8_t* const loasHeader, // sets up LATM/LOAS header, returns payload offset
+                                  const uint8_t* const ascUcBuf, const uint32_t ascUcSize)
+{
+  if (ascUcSize == 0) return 0;
+
+  loasHeader[0] = 0x56; // 11-bit sync. word
+  loasHeader[1] = 0xE0; // AudioSyncStream()
+  // audioMuxLengthBytes will be placed here
+  loasHeader[3] = 0x20; // AudioMuxElement()
+  loasHeader[4] = 0x00;
+  memcpy (loasHeader + 5, ascUcBuf, ascUcSize); // 3 trailing bits
+  loasHeader[4 + ascUcSize] &= 0xE0;
+  loasHeader[4 + ascUcSize] |= 0x3; // first 5 bits after ASC + UC
+  loasHeader[5 + ascUcSize] = 0xFC;
+
+  return uint16_t (6 + ascUcSize);
 }
 
-static void eaApplyUpsampler2x (int32_t* const pcmBuffer, int32_t* const upsampleBuffer,
-                                const uint16_t frameSize, const uint16_t numChannels, const bool firstFrame = false)
+static uint32_t eaWriteLoasFrame (BasicWriteBuffer& outBuffer, uint8_t* const loasHeader, const uint16_t payloadOffset,
+                                  const uint8_t* const auBuffer, const uint32_t auSize)
 {
-  const int16_t lookahead = 32;
-  const uint16_t inLength = (frameSize >> 1) + (firstFrame ? lookahead : 0);
-  const uint16_t chLength = (frameSize >> 1) + (lookahead << 1);
-  uint16_t ch;
+  const uint32_t audioMuxLengthBytes = payloadOffset + 1 + auSize / 255 + auSize;
+  uint32_t size = payloadOffset, tmp = auSize;
+
+  if (audioMuxLengthBytes > 8191) return 0;
+
+  loasHeader[1] = uint8_t (audioMuxLengthBytes >> 8) | 0xE0; // set AudioSyncStream()
+  loasHeader[2] = uint8_t (audioMuxLengthBytes & UCHAR_MAX);
 
-  for (ch = 0; ch < numChannels; ch++) // step 1: add deinterleaved input samples to resampling buffer
+  loasHeader[size++] = (uint8_t) __min (UCHAR_MAX, tmp); // write PayloadLengthInfo()
+  while (tmp >= UCHAR_MAX)
   {
-    int32_t* chPcmBuf = &pcmBuffer[ch];
-    int32_t* chUpsBuf = &upsampleBuffer[chLength * ch];
+    tmp -= UCHAR_MAX;
+    loasHeader[size++] = (uint8_t) __min (UCHAR_MAX, tmp);
+  }
+  if (((auBuffer[0] & 0xE0) == 0xC0) && (outBuffer.flush () > 0)) return 0; // pipe: flush on IPF
+
+    if ( (uint32_t) outBuffer.write (loasHeader, size) != size) return 0;
+  return (uint32_t) outBuffer.write (auBuffer, auSize); // then buffer PayloadMux()
+}
+#endif // ENABLE_STDOUT_LOAS
+
+#if EA_FRAME_STATS
+// per-frame encoder statistics dump
+typedef struct EaStatsDump
+{
+  ExhaleFrameStats frameStats; // filled by encodeFrame
+  BasicWriteBuffer fileWriter;
+  uint32_t  rowCount;
+  bool      writeJson; // false: CSV
+} EaStatsDump;
+
+static const char* const eaStageNames[EXHALE_NUM_STAGES] = {"temporal", "spectral", "psych", "quant", "auWrite"};
+
+static bool eaWriteFrameStats (EaStatsDump* const d) // writes one CSV row or JSON object
+{
+  const ExhaleFrameStats& fs = d->frameStats;
+  char row[2048];
+  int  len = 0;
+  unsigned c;
 
-    if (firstFrame) // construct leading sample values via extrapolation
+  if (d->writeJson) // array of frame objects
+  {
+    len += sprintf_s (&row[len], sizeof (row) - len, "%s{\"frame\":%u,\"indepFlag\":%u,\"auBytes\":%u,\"rateFactor\":%u,\"cplxLevel\":%u,\"stageNs\":{",
+                      d->rowCount == 0 ? "[\n" : ",\n", fs.frameCount, fs.indepFlag, fs.auBytes, fs.rateFactor, fs.cplxLevel);
+    for (c = 0; c < EXHALE_NUM_STAGES; c++)
     {
-      for (int8_t i = 0; i < 32; i++) chUpsBuf[i] = (*chPcmBuf * i + (32 >> 1)) >> 5;
+      len += sprintf_s (&row[len], sizeof (row) - len, "%s\"%s\":%u", c > 0 ? "," : "", eaStageNames[c], fs.stageNanoSec[c]);
     }
-    else
+    len += sprintf_s (&row[len], sizeof (row) - len, "},\"channels\":[");
+    for (c = 0; c < fs.numChannels; c++)
     {
-      memcpy (chUpsBuf, &chUpsBuf[inLength], (chLength - inLength) * sizeof (int32_t)); // update memory
+      len += sprintf_s (&row[len], sizeof (row) - len, "%s{\"windowSequence\":%u,\"bits\":%u,\"rdocPasses\":%u,\"tnsFilters\":%u}",
+                        c > 0 ? "," : "", fs.windowSequence[c], fs.channelBits[c], fs.rdocPasses[c], fs.tnsFilters[c]);
     }
-    chUpsBuf += chLength - inLength;
-
-    for (uint16_t i = inLength; i > 0; i--, chPcmBuf += numChannels, chUpsBuf++)
+    len += sprintf_s (&row[len], sizeof (row) - len, "],\"stereoMode\":[");
+    for (c = 0; c < fs.numElements; c++)
     {
-      *chUpsBuf = *chPcmBuf; // deinterleave, store in resampling buffer
+      len += sprintf_s (&row[len], sizeof (row) - len, "%s%u", c > 0 ? "," : "", fs.stereoMode[c]);
     }
+    len += sprintf_s (&row[len], sizeof (row) - len, "]}");
   }
-
-  for (ch = 0; ch < numChannels; ch++) // step 2: upsample, reinterleave, and save to PCM input buffer
+  else // CSV with header line
   {
-    /*in*/int32_t* chPcmBuf = &pcmBuffer[ch];
-    const int32_t* chUpsBuf = &upsampleBuffer[chLength * ch + lookahead];
-
-    for (uint16_t i = frameSize >> 1; i > 0; i--, chUpsBuf++)
+    if (d->rowCount == 0)
+    {
+      len += sprintf_s (&row[len], sizeof (row) - len, "frame,indepFlag,auBytes,rateFactor,cplxLevel");
+      for (c = 0; c < EXHALE_NUM_STAGES; c++) len += sprintf_s (&row[len], sizeof (row) - len, ",%sNs", eaStageNames[c]);
+      for (c = 0; c < fs.numChannels; c++) len += sprintf_s (&row[len], sizeof (row) - len, ",winSeq%u,bits%u,rdoc%u,tns%u", c, c, c, c);
+      for (c = 0; c < fs.numElements; c++) len += sprintf_s (&row[len], sizeof (row) - len, ",stereo%u", c);
+      len += sprintf_s (&row[len], sizeof (row) - len, "\n");
+    }
+    len += sprintf_s (&row[len], sizeof (row) - len, "%u,%u,%u,%u,%u", fs.frameCount, fs.indepFlag, fs.auBytes, fs.rateFactor, fs.cplxLevel);
+    for (c = 0; c < EXHALE_NUM_STAGES; c++) len += sprintf_s (&row[len], sizeof (row) - len, ",%u", fs.stageNanoSec[c]);
+    for (c = 0; c < fs.numChannels; c++)
     {
-      int64_t r = (chUpsBuf[0] + (int64_t) chUpsBuf[1]) * (usfc2x[0] - 2 * SHRT_MIN);
+      len += sprintf_s (&row[len], sizeof (row) - len, ",%u,%u,%u,%u", fs.windowSequence[c], fs.channelBits[c], fs.rdocPasses[c], fs.tnsFilters[c]);
+    }
+    for (c = 0; c < fs.numElements; c++) len += sprintf_s (&row[len], sizeof (row) - len, ",%u", fs.stereoMode[c]);
+    len += sprintf_s (&row[len], sizeof (row) - len, "\n");
+  }
+  d->rowCount++;
 
-      for (int16_t c = lookahead - 1; c > 0; c--)
-      {
-        r += (chUpsBuf[-c] + (int64_t) chUpsBuf[c + 1]) * usfc2x[c];
-      }
-      *chPcmBuf = *chUpsBuf; // no filtering necessary, just copy sample
-      if (*chPcmBuf < MIN_VALUE_AUDIO24) *chPcmBuf = MIN_VALUE_AUDIO24;
-      else
-      if (*chPcmBuf > MAX_VALUE_AUDIO24) *chPcmBuf = MAX_VALUE_AUDIO24;
-      chPcmBuf += numChannels;
+  return (d->fileWriter.write ((const uint8_t*) row, (uint32_t) len) == len);
+}
+#endif // EA_FRAME_STATS
 
-      *chPcmBuf = int32_t ((r - 2 * SHRT_MIN) >> 17);  // interp. sample
-      if (*chPcmBuf < MIN_VALUE_AUDIO24) *chPcmBuf = MIN_VALUE_AUDIO24;
-      else
-      if (*chPcmBuf > MAX_VALUE_AUDIO24) *chPcmBuf = MAX_VALUE_AUDIO24;
-      chPcmBuf += numChannels;
-    }
+// AU size bookkeeping and flush decision, shared by all coding paths
+typedef struct EaAuStats
+{
+  uint32_t  auBytes; // size of last AU
+  uint32_t  auBytesMax; // max. mean size of two consecutive written AUs
+  uint32_t  auBytesTmp; // size of preceding AU, 0: none
+  bool      enableSbrCoding;
+#if EA_FRAME_STATS
+  EaStatsDump* statsDump; // nullptr: off
+#endif
+} EaAuStats;
+
+static unsigned eaEncodeFrame (EaAuStats* const a, ExhaleEncAPI& exhaleEnc, const bool auWritten = true) // 1: writeout, 2: coding error
+{
+  if ((a->auBytes = exhaleEnc.encodeFrame ()) < 3) return 2; // encoding error
+
+  if (auWritten) // the leading look-ahead AU only seeds auBytesTmp
+  {
+    const uint32_t auBytesAvg = (a->enableSbrCoding || (a->auBytesTmp == 0) ? a->auBytes : (a->auBytesTmp + a->auBytes) >> 1u);
+
+    if (a->auBytesMax < auBytesAvg) a->auBytesMax = auBytesAvg;
   }
+  a->auBytesTmp = a->auBytes;
+#if EA_FRAME_STATS
+  if ((a->statsDump != nullptr) && !eaWriteFrameStats (a->statsDump)) return 1; // writeout error
+#endif
+  return 0;
 }
 
-static void eaApplyDownsampler (int32_t* const pcmBuffer, int32_t* const resampleBuffer,
-                                const uint16_t frameSize, const uint16_t numChannels, const bool firstFrame = false)
+static bool eaNeedsFlushFrame (const int64_t inFileLength, const unsigned inPadLength, const unsigned inFrmLength, const unsigned inStartLength,
+                               const unsigned resampDelay, const unsigned inSampleRate, const unsigned sbrEncDelay) // true: code one more frame
+{
+  const unsigned flushLength = (inFileLength - resampDelay + inPadLength) % inFrmLength;
+
+  return (flushLength + inStartLength - inFrmLength + resampDelay - (resampDelay >> 6)/*rnd*/+ inSampleRate / 200 > inFrmLength
+        - ((2 + sbrEncDelay * 3) >> 2)) || (flushLength == 0);
+}
+
+// frame coding pipeline of main ()
+#if EA_PIPE_SLOTS > 1
+typedef struct EaSlotQueue // FIFO of buffer slot indices
+{
+  std::condition_variable slotReady;
+  std::mutex slotMutex;
+  unsigned   slots[EA_PIPE_SLOTS];
+  unsigned   count;
+  unsigned   head;
+  bool       closed;
+} EaSlotQueue;
+#endif
+
+typedef struct EaPipeline
+{
+  // reader stage: input, resampler, loudness
+  BasicWavReader*    wavReader;
+  LoudnessEstimator* loudnessEst;
+  ExhaleResAPI*      pcmResampler;
+  uint16_t* loudMemory;
+  uint16_t  frameLength;
+  uint16_t  inFrmLength;
+  uint16_t  numChannels;
+  bool      enableLufsLevel;
+  bool      enableResampler;
+  bool      enableUpsampler;
+  // encoder stage: AU size statistics
+  EaAuStats auStats;
+  // writer stage: output, progress bar
+  BasicMP4Writer* mp4Writer;
+  uint32_t  byteCount;
+  unsigned  mod3Percent; // 0: no bar
+  uint16_t* progress;
+  uint16_t  progressMax;
+#if ENABLE_STDOUT_LOAS
+  uint8_t*  loasHeader;
+  uint32_t* loasFrames;
+  BasicWriteBuffer* loasWriter;
+  uint16_t  loasMuxOffset;
+  bool      writeStdout;
+#endif
+#if EA_PIPE_SLOTS > 1
+  // recycled frame buffers and queues
+  int32_t*  pcmSlot[EA_PIPE_SLOTS];
+  bool      pcmLast[EA_PIPE_SLOTS];
+  uint8_t*  auSlot[EA_PIPE_SLOTS];
+  uint32_t  auSize[EA_PIPE_SLOTS];
+  EaSlotQueue pcmFree;
+  EaSlotQueue pcmFull;
+  EaSlotQueue auFree;
+  EaSlotQueue auFull;
+  bool      writeError;
+#endif
+} EaPipeline;
+
+static bool eaReadFrame (EaPipeline* const p, int32_t* const pcmBuffer) // returns true for final frame
 {
-  const int16_t lookahead = frameSize >> 4;
-  const uint16_t inLength = ((frameSize * 3u) >> 1) + (firstFrame ? lookahead : 0);
-  const uint16_t chLength = ((frameSize * 3u) >> 1) + (lookahead << 1);
-  uint16_t ch;
+  const bool lastFrame = (p->wavReader->read (pcmBuffer, p->inFrmLength) == 0);
+
+  // resample audio frame if necessary
+  if (p->enableUpsampler || p->enableResampler) exhaleResample (p->pcmResampler, pcmBuffer, p->frameLength, false);
+
+  p->loudnessEst->setInputPcmData (pcmBuffer);
+  p->loudnessEst->addNewPcmData (p->frameLength);
+  if (p->enableLufsLevel) eaApplyLevelNorm (pcmBuffer, p->loudMemory, p->loudnessEst->getStatistics () >> 16, p->frameLength, p->numChannels);
+
+  return lastFrame;
+}
 
-  for (ch = 0; ch < numChannels; ch++) // step 1: add deinterleaved input samples to resampling buffer
+static bool eaWriteFrame (EaPipeline* const p, const uint8_t* const auData, const uint32_t auSize)
+{
+  // write new AU, add frame to header
+#if ENABLE_STDOUT_LOAS
+  if (p->writeStdout)
   {
-    int32_t* chPcmBuf = &pcmBuffer[ch];
-    int32_t* chResBuf = &resampleBuffer[chLength * ch];
+    if (eaWriteLoasFrame (*p->loasWriter, p->loasHeader, p->loasMuxOffset, auData, auSize) != auSize) return false;
+    if (*p->loasFrames < UINT_MAX) (*p->loasFrames)++;
+  }
+  else
+#endif
+  if (p->mp4Writer->addFrameAU (auData, auSize) != (int) auSize) return false;
+
+  p->byteCount += auSize;
 
-    if (firstFrame) // construct leading sample values via extrapolation
+  if ((p->mod3Percent > 0) && !(p->mp4Writer->getFrameCount () % p->mod3Percent))
+  {
+    if (((*p->progress)++) < p->progressMax)
     {
-      memset (chResBuf, 0, (lookahead - 32) * sizeof (int32_t));
-      for (int8_t i = 0; i < 32; i++) chResBuf[lookahead - 32 + i] = (*chPcmBuf * i + (32 >> 1)) >> 5;
+      fprintf_s (stdout, "-");  fflush (stdout);
     }
-    else
+  }
+  return true;
+}
+
+#if EA_PIPE_SLOTS > 1
+static void eaQueueClose (EaSlotQueue* const q)
+{
+  {
+    std::lock_guard<std::mutex> lock (q->slotMutex);
+
+    q->closed = true;
+  }
+  q->slotReady.notify_all ();
+}
+
+static bool eaQueuePop (EaSlotQueue* const q, unsigned* const slot) // false once closed and empty
+{
+  std::unique_lock<std::mutex> lock (q->slotMutex);
+
+  q->slotReady.wait (lock, [&] { return q->closed || (q->count > 0); });
+  if (q->count == 0) return false;
+
+  *slot = q->slots[q->head];
+  q->head = (q->head + 1) % EA_PIPE_SLOTS;
+  q->count--;
+
+  return true;
+}
+
+static void eaQueuePush (EaSlotQueue* const q, const unsigned slot) // never blocks, holds all slots
+{
+  {
+    std::lock_guard<std::mutex> lock (q->slotMutex);
+
+    q->slots[(q->head + q->count++) % EA_PIPE_SLOTS] = slot;
+  }
+  q->slotReady.notify_one ();
+}
+
+static void eaQueueReset (EaSlotQueue* const q)
+{
+  q->count = q->head = 0;
+  q->closed = false;
+}
+
+static void eaReaderLoop (EaPipeline* const p)
+{
+  unsigned s;
+
+  while (eaQueuePop (&p->pcmFree, &s))
+  {
+    const bool lastFrame = eaReadFrame (p, p->pcmSlot[s]);
+
+    p->pcmLast[s] = lastFrame;
+    eaQueuePush (&p->pcmFull, s);
+    if (lastFrame) break;
+  }
+  eaQueueClose (&p->pcmFull);
+}
+
+static void eaWriterLoop (EaPipeline* const p)
+{
+  unsigned s;
+
+  while (eaQueuePop (&p->auFull, &s))
+  {
+    if (!eaWriteFrame (p, p->auSlot[s], p->auSize[s]))
     {
-      memcpy (chResBuf, &chResBuf[inLength], (chLength - inLength) * sizeof (int32_t)); // update memory
+      p->writeError = true; break;
     }
-    chResBuf += chLength - inLength;
+    eaQueuePush (&p->auFree, s);
+  }
+  eaQueueClose (&p->auFree);
+}
+#endif // EA_PIPE_SLOTS > 1
 
-    for (uint16_t i = inLength; i > 0; i--, chPcmBuf += numChannels, chResBuf++)
+static unsigned eaCodeFrames (EaPipeline* const p, ExhaleEncAPI& exhaleEnc, int32_t* const inPcmData, const uint8_t* const outAuData,
+                              const unsigned inFrameSize) // codes all remaining frames, returns 1 on writeout, 2 on coding error
+{
+  unsigned result = 0;
+  bool lastFrame = false;
+#if EA_PIPE_SLOTS > 1
+  const size_t pcmSlotSize = inFrameSize * p->numChannels;
+# ifdef NO_PREROLL_DATA
+  const size_t auSlotSize  = (6144 >> 3) * p->numChannels;
+# else
+  const size_t auSlotSize  = (9984 >> 3) * p->numChannels;
+# endif
+  uint8_t* pcmSlotBuf = (uint8_t*) malloc (pcmSlotSize * EA_PIPE_SLOTS);
+  uint8_t* auSlotBuf  = (uint8_t*) malloc (auSlotSize  * EA_PIPE_SLOTS);
+  std::thread reader, writer;
+  unsigned s;
+
+  eaQueueReset (&p->pcmFree);
+  eaQueueReset (&p->pcmFull);
+  eaQueueReset (&p->auFree);
+  eaQueueReset (&p->auFull);
+  p->writeError = false;
+
+  if ((pcmSlotBuf != nullptr) && (auSlotBuf != nullptr))
+  {
+    try // stages idle until their queues are filled
     {
-      *chResBuf = *chPcmBuf; // deinterleave, store in resampling buffer
+      reader = std::thread (eaReaderLoop, p);
+      writer = std::thread (eaWriterLoop, p);
     }
+    catch (...) { }
   }
 
-  for (ch = 0; ch < numChannels; ch++) // step 2: resample, reinterleave, and save to PCM input buffer
+  if (reader.joinable () && writer.joinable ()) // reader, encoder (this thread), and writer overlap
   {
-    /*in*/int32_t* chPcmBuf = &pcmBuffer[ch];
-    const int32_t* chResBuf = &resampleBuffer[chLength * ch + lookahead];
-
-    for (uint16_t i = frameSize >> 1; i > 0; i--, chResBuf += 3)
+    for (s = 0; s < EA_PIPE_SLOTS; s++)
+    {
+      p->pcmSlot[s] = (int32_t*) (pcmSlotBuf + pcmSlotSize * s);
+      p->auSlot[s]  = auSlotBuf + auSlotSize * s;
+      eaQueuePush (&p->auFree, s);
+      eaQueuePush (&p->pcmFree, s);
+    }
+    while (!lastFrame && eaQueuePop (&p->pcmFull, &s))
     {
-      int64_t r1 = (int64_t) chResBuf[0] * (rsfc3x[0] - 2 * SHRT_MIN) - (chResBuf[-1] + (int64_t) chResBuf[1]) * SHRT_MIN +
-                   (int64_t) chResBuf[-lookahead] + (int64_t) chResBuf[lookahead];
-      int64_t r2 = (chResBuf[1] + (int64_t) chResBuf[2]) * (rsfc3x[1] - 2 * SHRT_MIN);
+      memcpy (inPcmData, p->pcmSlot[s], p->frameLength * p->numChannels * sizeof (int32_t));
+      lastFrame = p->pcmLast[s];
+      eaQueuePush (&p->pcmFree, s);
+
+      if ((result = eaEncodeFrame (&p->auStats, exhaleEnc)) > 0) break;
 
-      for (int16_t c = lookahead - 1; c > 0; c--)
+      if (!eaQueuePop (&p->auFree, &s))
       {
-        r1 += (chResBuf[-c] + (int64_t) chResBuf[c]) * rsfc3x[c << 1];
-        r2 += (chResBuf[1 - c] + (int64_t) chResBuf[c + 2]) * rsfc3x[(c << 1) + 1];
+        result = 1; break; // writeout error
       }
-      *chPcmBuf = int32_t ((r1 - 2 * SHRT_MIN) >> 17); // lowpass sample
-      if (*chPcmBuf < MIN_VALUE_AUDIO24) *chPcmBuf = MIN_VALUE_AUDIO24;
-      else
-      if (*chPcmBuf > MAX_VALUE_AUDIO24) *chPcmBuf = MAX_VALUE_AUDIO24;
-      chPcmBuf += numChannels;
-
-      *chPcmBuf = int32_t ((r2 - 2 * SHRT_MIN) >> 17); // interp. sample
-      if (*chPcmBuf < MIN_VALUE_AUDIO24) *chPcmBuf = MIN_VALUE_AUDIO24;
-      else
-      if (*chPcmBuf > MAX_VALUE_AUDIO24) *chPcmBuf = MAX_VALUE_AUDIO24;
-      chPcmBuf += numChannels;
+      memcpy (p->auSlot[s], outAuData, p->auStats.auBytes);
+      p->auSize[s] = p->auStats.auBytes;
+      eaQueuePush (&p->auFull, s);
     }
   }
-}
+  eaQueueClose (&p->pcmFree);
+  eaQueueClose (&p->auFull);
 
-static uint16_t eaApplyLevelNorm (int32_t* /*o*/ pcmBuffer, uint16_t* oldLoudness, const uint16_t currLoudness,
-                                  const uint16_t frameSize, const uint16_t numChannels)
-{
-  const int64_t gainOld = __min (MAX_VALUE_AUDIO24, int64_t (0.5f + MAX_VALUE_AUDIO24 * pow (10.0f, (77.0f - *oldLoudness / 512.f) / 20.0f)));
-  const int64_t gainNew = __min (MAX_VALUE_AUDIO24, int64_t (0.5f + MAX_VALUE_AUDIO24 * pow (10.0f, (77.0f - currLoudness / 512.f) / 20.0f)));
-  const int64_t gRShift = 32 + __min (3, frameSize >> 10);
-  const int64_t gOffset = (int64_t) 1 << (gRShift - 1);
-  uint16_t ch, i;
+  if (reader.joinable ()) reader.join ();
+  if (writer.joinable ()) writer.join ();
 
-  if ((frameSize & (frameSize - 1)) || !pcmBuffer) return 0;
+  MFREE (pcmSlotBuf);
+  MFREE (auSlotBuf);
+  p->loudnessEst->setInputPcmData (inPcmData);
 
-  for (i = frameSize; i > 0; i--)
+  if (p->writeError && (result == 0)) result = 1;
+
+  if (lastFrame || (result > 0)) return result;
+#else
+  (void) inFrameSize;
+#endif
+  while (!lastFrame) // sequential fallback
   {
-    const int64_t gainI = gainOld * i + gainNew * (frameSize - i);
+    lastFrame = eaReadFrame (p, inPcmData);
 
-    for (ch = numChannels; ch > 0; ch--, pcmBuffer++)
-    {
-      *pcmBuffer = int32_t ((gOffset + *pcmBuffer * gainI) >> gRShift);
-    }
+    if ((result = eaEncodeFrame (&p->auStats, exhaleEnc)) > 0) return result;
+
+    if (!eaWriteFrame (p, outAuData, p->auStats.auBytes)) return 1; // writeout error
   }
-  return (*oldLoudness = currLoudness);
+  return result;
 }
 
-#if ENABLE_STDOUT_LOAS
-static uint16_t eaInitLoasHeader (uint8_t* const loasHeader, // sets up LATM/LOAS header, returns payload offset
-                                  const uint8_t* const ascUcBuf, const uint32_t ascUcSize)
+#if EA_SEG_THREADS > 1
+// coding segment of seekable input file
+typedef struct EaSegment
 {
-  if (ascUcSize == 0) return 0;
+  // coder configuration, same in all segments
+  uint32_t loudStats;
+  uint16_t bitRateMode;
+  uint16_t firstLength;
+  uint16_t inPadLength;
+  uint16_t numChannels;
+  unsigned frameLength;
+  unsigned indepPeriod;
+  unsigned sampleRate; // of input, not coder
+  bool     compatExtension;
+  bool     enableSbrCoding;
+  // segment position and coding result
+  int64_t  skipLength; // in input sample frames
+  unsigned numAUsSkip; // warm-up AUs, discarded
+  unsigned numAUsCode; // 0: code until end of file
+  unsigned errorValue;
+  EaAuStats auStats; // of the kept AUs
+  bool     coded; // set by segment thread
+  std::vector <uint8_t>  auData;
+  std::vector <uint32_t> auSize;
+} EaSegment;
+
+typedef struct EaSegQueue // hands out segments in order, at most numThreads ahead of writeout
+{
+  std::condition_variable segReady;
+  std::mutex segMutex;
+  EaSegment* segments;
+  unsigned   numSegments;
+  unsigned   numThreads;
+  unsigned   nextCode; // next segment to be coded
+  unsigned   nextWrite; // next one to be written
+  bool       aborted;
+} EaSegQueue;
+
+static void eaEncodeSegment (EaSegment* const seg, const int fileHandle) // mirrors the sequential coding in main ()
+{
+  const unsigned frameLength = seg->frameLength;
+  const unsigned startLength = (frameLength * 25) >> 4;
+  const uint16_t numChannels = seg->numChannels;
+  const unsigned sbrEncDelay = (seg->enableSbrCoding ? 962 : 0);
+  BasicWavReader wavReader;
+  int32_t* inPcmData = nullptr;
+  ExhaleResAPI* pcmResampler = nullptr;
+  uint8_t* outAuData = nullptr;
+  const bool enableUpsampler = eaInitUpsampler2x (&pcmResampler, seg->bitRateMode, seg->sampleRate, frameLength, numChannels);
+  const bool enableResampler = (seg->enableSbrCoding ? false : eaInitDownsampler (&pcmResampler, seg->bitRateMode, seg->sampleRate, frameLength, numChannels));
+  const unsigned inFrameSize = (enableResampler ? startLength : frameLength) * sizeof (int32_t);
+  const unsigned resampRatio = (enableResampler ? 3 : 1);
+  const unsigned resampShift = (enableResampler || enableUpsampler ? 1 : 0);
+  const uint16_t inFrmLength = uint16_t ((frameLength * resampRatio) >> resampShift);
+  uint32_t bw = seg->loudStats, auCount = 0;
+
+  seg->errorValue = 1;
+  inPcmData = (int32_t*) malloc (inFrameSize * numChannels);
+#ifdef NO_PREROLL_DATA
+  outAuData = (uint8_t*) malloc ((6144 >> 3) * numChannels);
+#else
+  outAuData = (uint8_t*) malloc ((9984 >> 3) * numChannels);
+#endif
+  if ((inPcmData != nullptr) && (outAuData != nullptr) &&
+#ifdef EXHALE_APP_WIN
+      (wavReader.open (fileHandle, startLength, _filelengthi64 (fileHandle)) == 0) &&
+#else
+      (wavReader.open (fileHandle, startLength, lseek (fileHandle, 0, 2 /*SEEK_END*/)) == 0) &&
+#endif
+      (wavReader.skip (seg->skipLength) == seg->skipLength))
+  {
+    memset (inPcmData, 0, seg->inPadLength * numChannels * sizeof (int32_t)); // padding
 
-  loasHeader[0] = 0x56; // 11-bit sync. word
-  loasHeader[1] = 0xE0; // AudioSyncStream()
-  // audioMuxLengthBytes will be placed here
-  loasHeader[3] = 0x20; // AudioMuxElement()
-  loasHeader[4] = 0x00;
-  memcpy (loasHeader + 5, ascUcBuf, ascUcSize); // 3 trailing bits
-  loasHeader[4 + ascUcSize] &= 0xE0;
-  loasHeader[4 + ascUcSize] |= 0x3; // first 5 bits after ASC + UC
-  loasHeader[5 + ascUcSize] = 0xFC;
+    if (seg->inPadLength + wavReader.read (inPcmData + seg->inPadLength * numChannels, seg->firstLength - seg->inPadLength) == seg->firstLength)
+    {
+#if USE_EXHALELIB_DLL
+      ExhaleEncAPI&  exhaleEnc = *exhaleCreate (inPcmData, outAuData, (seg->sampleRate << resampShift) / resampRatio, numChannels, frameLength,
+#else
+      ExhaleEncoder  exhaleEnc (inPcmData, outAuData, (seg->sampleRate << resampShift) / resampRatio, numChannels, frameLength,
+#endif
+                                seg->indepPeriod, seg->bitRateMode + (enableUpsampler && (seg->bitRateMode < 9) ? 1 : 0)
+#if !RESTRICT_TO_AAC
+                              , true, seg->compatExtension
+#endif
+                                );
+      if (seg->inPadLength > 0) eaExtrapolate (inPcmData, seg->inPadLength, frameLength, numChannels, true); // fade-in
 
-  return uint16_t (6 + ascUcSize);
+      memset (outAuData, 0, 108 * sizeof (uint8_t));
+      outAuData[0] = 1; // 1-frame skip, as in main ()
+
+      if (exhaleEnc.initEncoder (outAuData, &bw) == 0)
+      {
+        // resample initial frame if necessary
+        if (enableUpsampler || enableResampler) exhaleResample (pcmResampler, inPcmData, frameLength, true);
+
+        if (exhaleEnc.encodeLookahead () >= 3)
+        {
+          bool lastFrame = (wavReader.read (inPcmData, inFrmLength) == 0);
+
+          while (true) // leading, regular, and final frames
+          {
+            // resample audio frame if necessary
+            if (enableUpsampler || enableResampler) exhaleResample (pcmResampler, inPcmData, frameLength, false);
+
+            const bool keepAu = (auCount++ >= seg->numAUsSkip);
+
+            if (eaEncodeFrame (&seg->auStats, exhaleEnc, keepAu) > 0) break;
+
+            if (keepAu)
+            {
+              bw = seg->auStats.auBytes;
+              seg->auData.insert (seg->auData.end (), outAuData, outAuData + bw);
+              seg->auSize.push_back (bw);
+            }
+            if ((seg->numAUsCode > 0) && (auCount >= seg->numAUsSkip + seg->numAUsCode))
+            {
+              seg->errorValue = 0; break; // segment complete
+            }
+            if (lastFrame)
+            {
+              seg->errorValue = (seg->numAUsCode > 0 ? 1 : 0); break; // end of file
+            }
+            lastFrame = (wavReader.read (inPcmData, inFrmLength) == 0);
+          }
+        }
+      }
+
+      if ((seg->errorValue == 0) && (seg->numAUsCode == 0)) // last segment, flush as in main ()
+      {
+        const int64_t inFileLength = wavReader.getDataBytesRead () / int64_t ((numChannels * wavReader.getBitDepth ()) >> 3);
+        const unsigned resampDelay = (enableUpsampler ? 32 : (enableResampler ? 64 : 0));
+
+        if (eaNeedsFlushFrame (inFileLength, seg->inPadLength, inFrmLength, (startLength * resampRatio) >> resampShift,
+                               resampDelay, wavReader.getSampleRate (), sbrEncDelay))  // flush last frame
+        {
+          memset (inPcmData, 0, inFrameSize * numChannels);
+
+          // resample flush frame if necessary
+          if (enableUpsampler || enableResampler) exhaleResample (pcmResampler, inPcmData, frameLength, false);
+
+          if (eaEncodeFrame (&seg->auStats, exhaleEnc) > 0) seg->errorValue = 1;
+          else
+          {
+            bw = seg->auStats.auBytes;
+            seg->auData.insert (seg->auData.end (), outAuData, outAuData + bw);
+            seg->auSize.push_back (bw);
+          }
+        }
+      }
+#if USE_EXHALELIB_DLL
+      exhaleDelete (&exhaleEnc);
+#endif
+    }
+  }
+  MFREE (inPcmData);
+  if (pcmResampler != nullptr) exhaleDeleteResampler (pcmResampler);
+  MFREE (outAuData);
 }
 
-static uint32_t eaWriteLoasFrame (const int fileHandle, uint8_t* const loasHeader, const uint16_t payloadOffset,
-                                  const uint8_t* const auBuffer, const uint32_t auSize)
+static void eaSegmentLoop (EaSegQueue* const q, const int fileHandle) // one thread per input handle
 {
-  const uint32_t audioMuxLengthBytes = payloadOffset + 1 + auSize / 255 + auSize;
-  uint32_t size = payloadOffset, tmp = auSize;
+  while (true)
+  {
+    EaSegment* seg;
+    {
+      std::unique_lock<std::mutex> lock (q->segMutex);
 
-  if (audioMuxLengthBytes > 8191) return 0;
+      q->segReady.wait (lock, [&] { return q->aborted || (q->nextCode >= q->numSegments) || (q->nextCode < q->nextWrite + q->numThreads); });
+      if (q->aborted || (q->nextCode >= q->numSegments)) return;
 
-  loasHeader[1] = uint8_t (audioMuxLengthBytes >> 8) | 0xE0; // set AudioSyncStream()
-  loasHeader[2] = uint8_t (audioMuxLengthBytes & UCHAR_MAX);
+      seg = &q->segments[q->nextCode++];
+    }
+    eaEncodeSegment (seg, fileHandle);
+    {
+      std::lock_guard<std::mutex> lock (q->segMutex);
 
-  loasHeader[size++] = (uint8_t) __min (UCHAR_MAX, tmp); // write PayloadLengthInfo()
-  while (tmp >= UCHAR_MAX)
-  {
-    tmp -= UCHAR_MAX;
-    loasHeader[size++] = (uint8_t) __min (UCHAR_MAX, tmp);
+      seg->coded = true;
+    }
+    q->segReady.notify_all ();
   }
-    if ( (uint32_t) _WRITE (fileHandle, loasHeader, size) != size) return 0;
-  return (uint32_t) _WRITE (fileHandle, auBuffer, auSize); // then write PayloadMux()
 }
-#endif // ENABLE_STDOUT_LOAS
+
+static void eaReadFrames (EaPipeline* const p, int32_t* const pcmBuffer) // loudness only, AUs come from the segments
+{
+  while (!eaReadFrame (p, pcmBuffer));
+}
+#endif // EA_SEG_THREADS > 1
 
 // main routine
 #ifdef EXHALE_APP_WCHAR
@@ -327,7 +748,7 @@ int main (const int argc, char* argv[])
   const bool readStdin = (argc == 3 || argc == 5);
   BasicWavReader wavReader;
   int32_t* inPcmData = nullptr;  // 24-bit WAVE audio input buffer
-  int32_t* inPcmRsmp = nullptr;  // temporary buffer for resampler
+  ExhaleResAPI* pcmResampler = nullptr; // 2:1 or 2:3 resampler
   uint8_t* outAuData = nullptr;  // access unit (AU) output buffer
   int   inFileHandle = -1, outFileHandle = -1;
   uint32_t loudStats = EA_LOUD_INIT;  // valid empty loudness data
@@ -351,8 +772,21 @@ int main (const int argc, char* argv[])
   const bool writeStdout = (zeroDelayForSbrEncoding != 0 && argv[1][0] >= 'a' && argv[argc - 1][0] == '-' && argv[argc - 1][1] == 0);
   uint16_t loasMuxOffset = 0;
   uint8_t loasHeader[64] = {0};
+  BasicWriteBuffer loasWriter; // combines LOAS frames
 #endif
   bool  enableLufsLevel = (argc >= 5 && (argv[2][0] == 'l' || argv[2][0] == 'L') && argv[2][1] == 0);
+  const bool fragmentedMp4 = (readStdin || (argc == 6 && (argv[2][0] == 'f' || argv[2][0] == 'F') && argv[2][1] == 0));
+#if EA_FRAME_STATS
+  const bool statsCsv  = (argc == 6 && (argv[2][0] == 'c' || argv[2][0] == 'C') && argv[2][1] == 0);
+  const bool statsJson = (argc == 6 && (argv[2][0] == 'j' || argv[2][0] == 'J') && argv[2][1] == 0);
+  EaStatsDump statsDump;  // frame stats
+  int statsFileHandle = -1;
+#endif
+#if EA_SEG_THREADS > 1
+  const bool segmentCoding = (argc == 6 && (argv[2][0] == 'p' || argv[2][0] == 'P') && argv[2][1] == 0);
+  int      segFileHandle[EA_SEG_THREADS]; // own input handle per segment
+  unsigned numSegHandles = 0;
+#endif
 #ifdef EXHALE_APP_WIN
   const HANDLE hConsole = GetStdHandle (STD_OUTPUT_HANDLE);
   CONSOLE_SCREEN_BUFFER_INFO csbi;
@@ -644,6 +1078,22 @@ int main (const int argc, char* argv[])
 
       goto mainFinish;  // input file error
     }
+#if EA_SEG_THREADS > 1
+    if (segmentCoding) // open more input handles for segment-parallel coding
+    {
+      const unsigned numSegThreads = __min (EA_SEG_THREADS, __max (2u, std::thread::hardware_concurrency ())); // 2 on single core
+
+      while (numSegHandles < numSegThreads)
+      {
+# ifdef EXHALE_APP_WIN
+        if (_SOPENS (&segFileHandle[numSegHandles], inFileName, _O_RDONLY | _O_SEQUENTIAL | _O_BINARY, _SH_DENYWR, _S_IREAD) != 0) break;
+# else
+        if ((segFileHandle[numSegHandles] = ::open (inFileName, O_RDONLY, 0666)) == -1) break;
+# endif
+        numSegHandles++;
+      }
+    }
+#endif
     if (inPathEnd == 0) free ((void*) inFileName);
   }
 
@@ -810,6 +1260,38 @@ int main (const int argc, char* argv[])
 
       goto mainFinish;  // output file error
     }
+#if EA_FRAME_STATS
+    if (statsCsv || statsJson) // write frame stats to output file name plus .csv or .json
+    {
+      const char* const statsExt = (statsJson ? ".json" : ".csv");
+      const size_t nameLength = _STRLEN (outFileName);
+# ifdef EXHALE_APP_WCHAR
+      wchar_t* statsFileName = (wchar_t*) malloc ((nameLength + 6) * sizeof (wchar_t));
+# else
+      char*    statsFileName = (char*) malloc ((nameLength + 6) * sizeof (char));
+# endif
+      if (statsFileName != nullptr)
+      {
+        size_t e = 0;
+
+        memcpy (statsFileName, outFileName, nameLength * sizeof (*statsFileName));
+        do statsFileName[nameLength + e] = statsExt[e]; while (statsExt[e++] != 0);
+# ifdef EXHALE_APP_WIN
+        if (_SOPENS (&statsFileHandle, statsFileName, _O_WRONLY | _O_SEQUENTIAL | _O_CREAT | _O_EXCL | _O_BINARY, _SH_DENYRD, _S_IWRITE) != 0)
+# else
+        if ((statsFileHandle = ::open (statsFileName, O_WRONLY | O_CREAT | O_EXCL, 0666)) == -1)
+# endif
+        {
+          _ERROR2 (" WARNING: Unable to create frame statistics file %s! Does it already exist?\n\n", statsFileName);
+          statsFileHandle = -1;
+        }
+        free ((void*) statsFileName);
+      }
+      statsDump.rowCount  = 0;
+      statsDump.writeJson = statsJson;
+      if (statsFileHandle != -1) statsDump.fileWriter.open (statsFileHandle); // unbuffered if allocation fails
+    }
+#endif
     if (outPathEnd == 0) free ((void*) outFileName);
   }
 
@@ -831,9 +1313,9 @@ int main (const int argc, char* argv[])
     const unsigned numChannels = wavReader.getNumChannels ();
     const unsigned inSampDepth = wavReader.getBitDepth ();
     const unsigned sbrEncDelay = (enableSbrCoding ? 962 : 0);
-    const bool enableUpsampler = eaInitUpsampler2x (&inPcmRsmp, variableCoreBitRateMode, i, frameLength, numChannels);
+    const bool enableUpsampler = eaInitUpsampler2x (&pcmResampler, variableCoreBitRateMode, i, frameLength, numChannels);
     const bool enableResampler = (enableSbrCoding ? false : // no 3:2 downsampling required when encoding in SBR mode
-                                 eaInitDownsampler (&inPcmRsmp, variableCoreBitRateMode, i, frameLength, numChannels));
+                                 eaInitDownsampler (&pcmResampler, variableCoreBitRateMode, i, frameLength, numChannels));
     const uint16_t firstLength = uint16_t (enableUpsampler ? (frameLength >> 1) + 32 : (enableResampler ? startLength : frameLength));
     const unsigned inFrameSize = (enableResampler ? startLength : frameLength) * sizeof (int32_t); // max buffer size
     const unsigned resampRatio = (enableResampler ? 3 : 1); // for resampling ratio
@@ -904,15 +1386,16 @@ int main (const int argc, char* argv[])
       const unsigned indepPeriod = (userIndepPeriod ? 10 * (argv[3][0] - 48) + (argv[3][1] - 48) : (sampleRate < 48000 ? sampleRate - 320u : 50u << 10u) / frameLength);
 #if ENABLE_STDOUT_LOAS
       const unsigned mod3Percent = (writeStdout ? 0 : unsigned ((expectLength * (3 + (coreSbrFrameLengthIndex & 3))) >> 17));
-      uint32_t byteCount = 0, bw = (numChannels < 7 ? loudStats | (writeStdout ? 0x4A0022CB /*-23 LUFS*/ : 0) : 0);
+      uint32_t bw = (numChannels < 7 ? loudStats | (writeStdout ? 0x4A0022CB /*-23 LUFS*/ : 0) : 0);
 #else
       const unsigned mod3Percent = unsigned ((expectLength * (3 + (coreSbrFrameLengthIndex & 3))) >> 17);
-      uint32_t byteCount = 0, bw = (numChannels < 7 ? loudStats : 0);
+      uint32_t bw = (numChannels < 7 ? loudStats : 0);
 #endif
-      uint32_t br, bwMax = 0, bwTmp = 0; // br will hold bytes read and/or bit-rate
-      uint32_t headerRes = 0;
-      // initialize LoudnessEstimator object
-      LoudnessEstimator loudnessEst (inPcmData, 24 /*bit*/, sampleRate, numChannels);
+      uint32_t br, headerRes = 0; // br will hold bytes read and/or bit-rate
+      unsigned frameResult; // of eaEncodeFrame ()
+      bool segmentsCoded = false; // by eaEncodeSegment ()
+      // initialize LoudnessEstimator object, with true-peak metering only when frame statistics are requested
+      LoudnessEstimator loudnessEst (inPcmData, 24 /*bit*/, sampleRate, numChannels, statsCsv || statsJson);
       // open & prepare ExhaleEncoder object
 #if USE_EXHALELIB_DLL
       ExhaleEncAPI&  exhaleEnc = *exhaleCreate (inPcmData, outAuData, sampleRate, numChannels, frameLength, indepPeriod, variableCoreBitRateMode
@@ -934,9 +1417,7 @@ int main (const int argc, char* argv[])
       if (zeroDelayForSbrEncoding)
       {
         // resample PCM priming if necessary
-        if (enableUpsampler) eaApplyUpsampler2x (inPcmData, inPcmRsmp, frameLength, numChannels, true);
-        else
-        if (enableResampler) eaApplyDownsampler (inPcmData, inPcmRsmp, frameLength, numChannels, true);
+        if (enableUpsampler || enableResampler) exhaleResample (pcmResampler, inPcmData, frameLength, true);
       }
       // extrapolate samples in padding region of first frame since exhaleLib can't
       // take over this job when inPadLength > 0. Improves gapless playback.
@@ -944,6 +1425,27 @@ int main (const int argc, char* argv[])
 
       // signal 1-frame skip and PCM priming
       outAuData[0] = 1 | zeroDelayForSbrEncoding * (uint8_t) __min (254, (firstLength - inPadLength) << (resampShift + 1));
+#endif
+#if EA_NUM_THREADS > 1
+      if (numChannels > 2) // use one thread per channel element, output remains bit-exact
+      {
+        const unsigned numThreads = __min (EA_NUM_THREADS, std::thread::hardware_concurrency ());
+# if USE_EXHALELIB_DLL
+        exhaleSetNumThreads (&exhaleEnc, numThreads);
+# else
+        exhaleEnc.setNumThreads (numThreads);
+# endif
+      }
+#endif
+#if EA_FRAME_STATS
+      if (statsFileHandle != -1) // fill statsDump.frameStats on each encodeFrame call
+      {
+# if USE_EXHALELIB_DLL
+        exhaleSetFrameStats (&exhaleEnc, &statsDump.frameStats);
+# else
+        exhaleEnc.setFrameStats (&statsDump.frameStats);
+# endif
+      }
 #endif
       i = exhaleEnc.initEncoder (outAuData, &bw); // bw stores actual ASC + UC size
 #ifdef FULL_FRM_LOOKAHEAD
@@ -959,6 +1461,7 @@ int main (const int argc, char* argv[])
         br = 0; // init frame count & header
         if ((loasMuxOffset = eaInitLoasHeader (loasHeader, outAuData, bw)) == 0) i = 1;
         else enableLufsLevel = true;
+        loasWriter.open (outFileHandle); // unbuffered if allocation fails
       }
       else
 #endif
@@ -971,7 +1474,7 @@ int main (const int argc, char* argv[])
 #ifndef NO_PREROLL_DATA
                                 - frameLength
 #endif
-                              , indepPeriod, outAuData, bw, (time (nullptr) + 2082844800) & UINT_MAX, (char) variableCoreBitRateMode)) != 0)
+                              , indepPeriod, outAuData, bw, eaGetMp4Time (), (char) variableCoreBitRateMode)) != 0)
       {
         _ERROR2 (" ERROR while trying to initialize exhale encoder: error value %d was returned!\n\n", i);
         i <<= 2; // return value
@@ -1011,12 +1514,13 @@ int main (const int argc, char* argv[])
       }
 
 #if ENABLE_STDOUT_LOAS
-      if (!readStdin && !writeStdout) // reserve space required for MP4 file header
-#else
-      if (!readStdin) // reserve space for MP4 file header. TODO: nasty, avoid this
+      if (!writeStdout) // write MP4 init segment or reserve space for MP4 file header
 #endif
       {
-        if ((headerRes = (uint32_t) mp4Writer.initHeader (uint32_t (__min (UINT_MAX - startLength, expectLength)), sbrEncDelay >> 2)) < 666)
+        mp4Writer.setFlushOnIPF (readStdin); // live input, write out each RA period
+
+        if ((headerRes = (uint32_t) (fragmentedMp4 ? mp4Writer.initFragments (sbrEncDelay >> 2) : // stdin: length unknown
+                                     mp4Writer.initHeader (uint32_t (__min (UINT_MAX - startLength, expectLength)), sbrEncDelay >> 2))) < 666)
         {
           _ERROR2 ("\n ERROR while trying to write MPEG-4 bit-stream header: stopped after %d bytes!\n\n", headerRes);
           i = 3; // return value
@@ -1031,10 +1535,164 @@ int main (const int argc, char* argv[])
 #endif
       i = 1; // for progress bar
 
+      // set up the frame coding pipeline
+      EaPipeline pipe;
+
+      pipe.wavReader               = &wavReader;
+      pipe.loudnessEst             = &loudnessEst;
+      pipe.pcmResampler            = pcmResampler;
+      pipe.loudMemory              = &loudMemory;
+      pipe.frameLength             = (uint16_t) frameLength;
+      pipe.inFrmLength             = uint16_t ((frameLength * resampRatio) >> resampShift);
+      pipe.numChannels             = (uint16_t) numChannels;
+      pipe.enableLufsLevel         = enableLufsLevel;
+      pipe.enableResampler         = enableResampler;
+      pipe.enableUpsampler         = enableUpsampler;
+      pipe.auStats.auBytes         = 0;
+      pipe.auStats.auBytesMax      = 0;
+      pipe.auStats.auBytesTmp      = 0;
+      pipe.auStats.enableSbrCoding = enableSbrCoding;
+#if EA_FRAME_STATS
+      pipe.auStats.statsDump       = (statsFileHandle != -1 ? &statsDump : nullptr);
+#endif
+      pipe.mp4Writer               = &mp4Writer;
+      pipe.byteCount               = 0;
+      pipe.mod3Percent             = (readStdin ? 0 : mod3Percent);
+      pipe.progress                = &i;
+      pipe.progressMax             = (enableSbrCoding ? 17 : 34);
+#if ENABLE_STDOUT_LOAS
+      pipe.loasHeader              = loasHeader;
+      pipe.loasFrames              = &br;
+      pipe.loasWriter              = &loasWriter;
+      pipe.loasMuxOffset           = loasMuxOffset;
+      pipe.writeStdout             = writeStdout;
+#endif
+
+#if EA_SEG_THREADS > 1
+      if (segmentCoding && (numSegHandles > 1)) // code IPF-aligned input segments in parallel
+      {
+        const unsigned segPeriod = indepPeriod << 1; // frames from one IPF to the next
+        const int64_t numPeriods = expectLength / (frameLength * (int64_t) segPeriod);
+        const unsigned numSegments = unsigned (__max (__min ((int64_t) numSegHandles, numPeriods / EA_SEG_MIN_IPFS), (numPeriods + EA_SEG_MAX_IPFS - 1) / EA_SEG_MAX_IPFS));
+
+        if (numSegments > 1)
+        {
+          const unsigned segLength = segPeriod * unsigned (numPeriods / numSegments);
+          std::vector <EaSegment> segments (numSegments);
+          std::vector <std::thread> segThreads;
+          std::thread loudThread;
+          EaSegQueue segQueue;
+          unsigned s;
+          size_t n;
+
+          for (s = 0; s < numSegments; s++) // same config, but with pre-roll of one IPF period
+          {
+            EaSegment& seg = segments[s];
+
+            seg.loudStats   = (numChannels < 7 ? loudStats : 0);
+            seg.bitRateMode = variableCoreBitRateMode;
+            seg.firstLength = firstLength;
+            seg.inPadLength = inPadLength;
+            seg.numChannels = (uint16_t) numChannels;
+            seg.frameLength = frameLength;
+            seg.indepPeriod = indepPeriod;
+            seg.sampleRate  = wavReader.getSampleRate ();
+            seg.compatExtension = (compatibleExtensionFlag > 0);
+            seg.enableSbrCoding = enableSbrCoding;
+#ifdef NO_PREROLL_DATA
+            seg.numAUsSkip  = (s > 0 ? segPeriod : 0);
+#else
+            seg.numAUsSkip  = (s > 0 ? segPeriod : 0) + 1; // as leading AU isn't written
+#endif
+            seg.numAUsCode  = (s + 1 < numSegments ? segLength : 0);
+            seg.skipLength  = int64_t (s > 0 ? s * segLength - segPeriod : 0) * ((frameLength * resampRatio) >> resampShift);
+            seg.errorValue  = 0;
+            seg.auStats     = pipe.auStats;
+#if EA_FRAME_STATS
+            seg.auStats.statsDump = nullptr;
+#endif
+            seg.coded       = false;
+          }
+          segQueue.segments    = segments.data ();
+          segQueue.numSegments = numSegments;
+          segQueue.numThreads  = numSegHandles; // bounds the number of segments held in memory
+          segQueue.nextCode    = segQueue.nextWrite = 0;
+          segQueue.aborted     = false;
+          try
+          {
+            for (s = 0; s < numSegHandles; s++) segThreads.push_back (std::thread (eaSegmentLoop, &segQueue, segFileHandle[s]));
+          }
+          catch (...) { } // if no thread started, code all segments on this thread
+
+          // meanwhile, measure program loudness like in sequential coding
+          if (enableUpsampler || enableResampler) exhaleResample (pcmResampler, inPcmData, frameLength, true);
+          try
+          {
+            loudThread = std::thread (eaReadFrames, &pipe, inPcmData);
+          }
+          catch (...) { eaReadFrames (&pipe, inPcmData); }
+
+          for (s = 0; s < numSegments; s++) // write AUs of each segment in order once it's coded
+          {
+            EaSegment& seg = segments[s];
+            const uint8_t* auData;
+
+            if (segThreads.empty ()) eaEncodeSegment (&seg, segFileHandle[0]);
+            else
+            {
+              std::unique_lock<std::mutex> lock (segQueue.segMutex);
+
+              segQueue.segReady.wait (lock, [&] { return seg.coded; });
+            }
+            if (seg.errorValue > 0) break; // encoding error
+
+            for (auData = seg.auData.data (), n = 0; n < seg.auSize.size (); auData += seg.auSize[n++])
+            {
+              if (!eaWriteFrame (&pipe, auData, seg.auSize[n])) break;
+            }
+            if (n < seg.auSize.size ()) break; // writeout error
+
+            if (pipe.auStats.auBytesMax < seg.auStats.auBytesMax) pipe.auStats.auBytesMax = seg.auStats.auBytesMax;
+            std::vector <uint8_t> ().swap (seg.auData); // free memory
+            std::vector <uint32_t> ().swap (seg.auSize);
+            {
+              std::lock_guard<std::mutex> lock (segQueue.segMutex);
+
+              segQueue.nextWrite = s + 1;
+            }
+            segQueue.segReady.notify_all ();
+          }
+          {
+            std::lock_guard<std::mutex> lock (segQueue.segMutex);
+
+            segQueue.aborted = true; // stops threads in case of error
+          }
+          segQueue.segReady.notify_all ();
+
+          for (n = 0; n < segThreads.size (); n++) segThreads[n].join ();
+          if (loudThread.joinable ()) loudThread.join ();
+
+          if (s < numSegments)
+          {
+            if (segments[s].errorValue > 0)
+            {
+              _ERROR2 ("\n ERROR while trying to encode input audio segment %d!\n\n", s);
+              i = 2; // return value
+            }
+# if USE_EXHALELIB_DLL
+            exhaleDelete (&exhaleEnc);
+# endif
+            goto mainFinish; // coding or writeout error
+          }
+          segmentsCoded = true; // incl. flush AU
+
+          goto segmentsDone; // skip sequential coding
+        }
+      }
+#endif
+
       // resample initial frame if necessary
-      if (enableUpsampler) eaApplyUpsampler2x (inPcmData, inPcmRsmp, frameLength, numChannels, !zeroDelayForSbrEncoding);
-      else
-      if (enableResampler) eaApplyDownsampler (inPcmData, inPcmRsmp, frameLength, numChannels, !zeroDelayForSbrEncoding);
+      if (enableUpsampler || enableResampler) exhaleResample (pcmResampler, inPcmData, frameLength, !zeroDelayForSbrEncoding);
 
       // initial frame, encode look-ahead AU
       if ((bw = exhaleEnc.encodeLookahead ()) < 3)
@@ -1060,34 +1718,42 @@ int main (const int argc, char* argv[])
       wavReader.read (inPcmData, (frameLength * resampRatio) >> resampShift); // discard the initial look-ahead AU
 
       // resample leading frame if necessary
-      if (enableUpsampler) eaApplyUpsampler2x (inPcmData, inPcmRsmp, frameLength, numChannels);
-      else
-      if (enableResampler) eaApplyDownsampler (inPcmData, inPcmRsmp, frameLength, numChannels);
+      if (enableUpsampler || enableResampler) exhaleResample (pcmResampler, inPcmData, frameLength, false);
 
       // leading frame, actual look-ahead AU
-      if ((bw = exhaleEnc.encodeFrame ()) < 3)
+# ifdef NO_PREROLL_DATA
+      if ((frameResult = eaEncodeFrame (&pipe.auStats, exhaleEnc)) > 0)
+# else
+      if ((frameResult = eaEncodeFrame (&pipe.auStats, exhaleEnc, false /*AU not written*/)) > 0)
+# endif
       {
-        _ERROR2 ("\n ERROR while trying to create first audio frame: error value %d was returned!\n\n", bw);
-        i = 2; // return value
+        if (frameResult == 2)
+        {
+          _ERROR2 ("\n ERROR while trying to create first audio frame: error value %d was returned!\n\n", pipe.auStats.auBytes);
+          i = 2; // return value
+        }
 # if USE_EXHALELIB_DLL
         exhaleDelete (&exhaleEnc);
 # endif
-        goto mainFinish; // coder-time error
+        goto mainFinish; // coder-time or writeout error
       }
+      bw = pipe.auStats.auBytes;
+#else
+      pipe.auStats.auBytes = pipe.auStats.auBytesTmp = bw; // look-ahead AU
+# ifdef NO_PREROLL_DATA
+      pipe.auStats.auBytesMax = bw;
+# endif
 #endif
-      bwTmp = bw;
 #ifdef NO_PREROLL_DATA
-      if (bwMax < bw) bwMax = bw;
 
       // write first AU, add frame to header
-      if ((mp4Writer.addFrameAU (outAuData, bw) != (int) bw) || loudnessEst.addNewPcmData (frameLength))
+      if (!eaWriteFrame (&pipe, outAuData, bw) || loudnessEst.addNewPcmData (frameLength))
       {
 # if USE_EXHALELIB_DLL
         exhaleDelete (&exhaleEnc);
 # endif
         goto mainFinish;   // writeout error
       }
-      byteCount += bw;
 #else
       if (loudnessEst.addNewPcmData (frameLength))
       {
@@ -1098,205 +1764,76 @@ int main (const int argc, char* argv[])
       }
 #endif
 
-      while (wavReader.read (inPcmData, (frameLength * resampRatio) >> resampShift) > 0) // read a new audio frame
+      // frame coding loop, encode all AUs
+      if ((frameResult = eaCodeFrames (&pipe, exhaleEnc, inPcmData, outAuData, inFrameSize)) > 0)
       {
-        // resample audio frame if necessary
-        if (enableUpsampler) eaApplyUpsampler2x (inPcmData, inPcmRsmp, frameLength, numChannels);
-        else
-        if (enableResampler) eaApplyDownsampler (inPcmData, inPcmRsmp, frameLength, numChannels);
-
-        // frame coding loop, encode next AU
-        loudnessEst.addNewPcmData (frameLength);
-        if (enableLufsLevel) eaApplyLevelNorm (inPcmData, &loudMemory, loudnessEst.getStatistics () >> 16, frameLength, numChannels);
-
-        if ((bw = exhaleEnc.encodeFrame ()) < 3)
+        if (frameResult == 2)
         {
-          _ERROR2 ("\n ERROR while trying to create audio frame: error value %d was returned!\n\n", bw);
+          _ERROR2 ("\n ERROR while trying to create audio frame: error value %d was returned!\n\n", pipe.auStats.auBytes);
           i = 2; // return value
-#if USE_EXHALELIB_DLL
-          exhaleDelete (&exhaleEnc);
-#endif
-          goto mainFinish; // encoding error
-        }
-        bwTmp = (enableSbrCoding ? bw : (bwTmp + bw) >> 1u);
-        if (bwMax < bwTmp) bwMax = bwTmp;
-        bwTmp = bw;
-
-        // write new AU, add frame to header
-#if ENABLE_STDOUT_LOAS
-        if (writeStdout)
-        {
-          if (eaWriteLoasFrame (outFileHandle, loasHeader, loasMuxOffset, outAuData, bw) != bw)
-          {
-# if USE_EXHALELIB_DLL
-            exhaleDelete (&exhaleEnc);
-# endif
-            goto mainFinish; // writer error
-          }
-          if (br < UINT_MAX) br++;
         }
-        else
-#endif
-        if (mp4Writer.addFrameAU (outAuData, bw) != (int) bw)
-        {
 #if USE_EXHALELIB_DLL
-          exhaleDelete (&exhaleEnc);
+        exhaleDelete (&exhaleEnc);
 #endif
-          goto mainFinish; // writeout error
-        }
-        byteCount += bw;
-
-        if (!readStdin && (mod3Percent > 0) && !(mp4Writer.getFrameCount () % mod3Percent))
-        {
-          if ((i++) < (enableSbrCoding ? 17 : 34))
-          {
-            fprintf_s (stdout, "-");  fflush (stdout);
-          }
-        }
+        goto mainFinish; // coding or writeout error
       } // frame loop
 
-      // resample the last frame if necessary
-      if (enableUpsampler) eaApplyUpsampler2x (inPcmData, inPcmRsmp, frameLength, numChannels);
-      else
-      if (enableResampler) eaApplyDownsampler (inPcmData, inPcmRsmp, frameLength, numChannels);
-
-      // end of coding loop, encode final AU
-      loudnessEst.addNewPcmData (frameLength);
-      if (enableLufsLevel) eaApplyLevelNorm (inPcmData, &loudMemory, loudnessEst.getStatistics () >> 16, frameLength, numChannels);
-
-      if ((bw = exhaleEnc.encodeFrame ()) < 3)
-      {
-        _ERROR2 ("\n ERROR while trying to create audio frame: error value %d was returned!\n\n", bw);
-        i = 2; // return value
-#if USE_EXHALELIB_DLL
-        exhaleDelete (&exhaleEnc);
+#if EA_SEG_THREADS > 1
+segmentsDone:
 #endif
-        goto mainFinish; // coder-time error
-      }
-      bwTmp = (enableSbrCoding ? bw : (bwTmp + bw) >> 1u);
-      if (bwMax < bwTmp) bwMax = bwTmp;
-      bwTmp = bw;
-
-      // write final AU, add frame to header
-#if ENABLE_STDOUT_LOAS
-      if (writeStdout)
-      {
-        if (eaWriteLoasFrame (outFileHandle, loasHeader, loasMuxOffset, outAuData, bw) != bw)
-        {
-# if USE_EXHALELIB_DLL
-          exhaleDelete (&exhaleEnc);
-# endif
-          goto mainFinish; // writeout error
-        }
-        if (br < UINT_MAX) br++;
-      }
-      else
-#endif
-      if (mp4Writer.addFrameAU (outAuData, bw) != (int) bw)
-      {
-#if USE_EXHALELIB_DLL
-        exhaleDelete (&exhaleEnc);
-#endif
-        goto mainFinish;   // writeout error
-      }
-      byteCount += bw;
-
       const int64_t actualLength = (wavReader.getDataBytesRead () << resampShift) / int64_t ((numChannels * inSampDepth * resampRatio) >> 3);
       const int64_t inFileLength = wavReader.getDataBytesRead () / int64_t ((numChannels * inSampDepth) >> 3);
       const unsigned inFrmLength = (frameLength * resampRatio) >> resampShift;
       const unsigned resampDelay = (enableUpsampler ? 32 : (enableResampler ? 64 : 0));
+
 #ifdef FULL_FRM_LOOKAHEAD
-      const unsigned flushLength = (inFileLength - resampDelay + inPadLength) % inFrmLength;
+      if (!segmentsCoded && eaNeedsFlushFrame (inFileLength, inPadLength, inFrmLength, (startLength * resampRatio) >> resampShift,
 #else
-      const unsigned flushLength = (inFileLength - resampDelay) % inFrmLength;
+      if (!segmentsCoded && eaNeedsFlushFrame (inFileLength, 0, inFrmLength, (startLength * resampRatio) >> resampShift,
 #endif
-      if ((flushLength + ((startLength * resampRatio) >> resampShift) - inFrmLength + resampDelay
-        - (resampDelay >> 6)/*rnd*/+ wavReader.getSampleRate () / 200 > inFrmLength
-        - ((2 + sbrEncDelay * 3) >> 2)) || (flushLength == 0))  // flush last frame
+                                               resampDelay, wavReader.getSampleRate (), sbrEncDelay))  // flush last frame
       {
         memset (inPcmData, 0, inFrameSize * numChannels);
 
         // resample flush frame if necessary
-        if (enableUpsampler) eaApplyUpsampler2x (inPcmData, inPcmRsmp, frameLength, numChannels);
-        else
-        if (enableResampler) eaApplyDownsampler (inPcmData, inPcmRsmp, frameLength, numChannels);
+        if (enableUpsampler || enableResampler) exhaleResample (pcmResampler, inPcmData, frameLength, false);
 
         // flush remaining audio into new AU
         // no loudnessEst.addNewPcmData call
         if (enableLufsLevel) eaApplyLevelNorm (inPcmData, &loudMemory, loudnessEst.getStatistics () >> 16, frameLength, numChannels);
 
-        if ((bw = exhaleEnc.encodeFrame ()) < 3)
+        if ((frameResult = eaEncodeFrame (&pipe.auStats, exhaleEnc)) > 0)
         {
-          _ERROR2 ("\n ERROR while trying to create last audio frame: error value %d was returned!\n\n", bw);
-          i = 2; // return value
+          if (frameResult == 2)
+          {
+            _ERROR2 ("\n ERROR while trying to create last audio frame: error value %d was returned!\n\n", pipe.auStats.auBytes);
+            i = 2; // return value
+          }
 #if USE_EXHALELIB_DLL
           exhaleDelete (&exhaleEnc);
 #endif
-          goto mainFinish; // encoding error
+          goto mainFinish; // encoding or writeout error
         }
-        bwTmp = (enableSbrCoding ? bw : (bwTmp + bw) >> 1u);
-        if (bwMax < bwTmp) bwMax = bwTmp;
-        bwTmp = bw;
 
         // the flush AU, add frame to header
-#if ENABLE_STDOUT_LOAS
-        if (writeStdout)
-        {
-          if (eaWriteLoasFrame (outFileHandle, loasHeader, loasMuxOffset, outAuData, bw) != bw)
-          {
-# if USE_EXHALELIB_DLL
-            exhaleDelete (&exhaleEnc);
-# endif
-            goto mainFinish; // writer error
-          }
-          if (br < UINT_MAX) br++;
-        }
-        else
-#endif
-        if (mp4Writer.addFrameAU (outAuData, bw) != (int) bw)
+        if (!eaWriteFrame (&pipe, outAuData, pipe.auStats.auBytes))
         {
 #if USE_EXHALELIB_DLL
           exhaleDelete (&exhaleEnc);
 #endif
           goto mainFinish; // writeout error
         }
-        byteCount += bw;
       } // trailing frame
-
 #if ENABLE_STDOUT_LOAS
-      if (readStdin && !writeStdout) // reserve space necessary for MP4 file header
-#else
-      if (readStdin) // reserve space for MP4 file header (is there an easier way?)
-#endif
+      if (writeStdout && (loasWriter.flush () > 0))
       {
-        int64_t pos = _SEEK (outFileHandle, 0, 1 /*SEEK_CUR*/);
-
-        if ((headerRes = (uint32_t) mp4Writer.initHeader (uint32_t (__min (UINT_MAX - startLength, actualLength)), sbrEncDelay >> 2)) < 666)
-        {
-          _ERROR2 ("\n ERROR while trying to write MPEG-4 bit-stream header: stopped after %d bytes!\n\n", headerRes);
-          i = 3; // return value
-#if USE_EXHALELIB_DLL
-          exhaleDelete (&exhaleEnc);
-#endif
-          goto mainFinish; // writeout error
-        }
-        // move AU data forward to make room for actual MP4 header at start of file
-        br = inFrameSize * numChannels;
-        while ((pos -= br) > 0) // move loop
-        {
-          _SEEK (outFileHandle, pos, 0 /*SEEK_SET*/);
-          bw = _READ (outFileHandle, inPcmData, br);
-          _SEEK (outFileHandle, pos + headerRes, 0 /*SEEK_SET*/);
-          bw = _WRITE(outFileHandle, inPcmData, br);
-        }
-        if ((br = (uint32_t) __max (0, pos + br)) > 0) // remainder of data to move
-        {
-          _SEEK (outFileHandle, 0, 0 /*SEEK_SET*/);
-          bw = _READ (outFileHandle, inPcmData, br);
-          _SEEK (outFileHandle, headerRes, 0 /*SEEK_SET*/);
-          bw = _WRITE(outFileHandle, inPcmData, br);
-        }
+# if USE_EXHALELIB_DLL
+        exhaleDelete (&exhaleEnc);
+# endif
+        goto mainFinish; // writeout error
       }
+#endif
+
       i = 0; // no errors
 
       // loudness and sample peak of program
@@ -1330,7 +1867,7 @@ int main (const int argc, char* argv[])
 #if ENABLE_STDOUT_LOAS
       if (writeStdout)
       {
-        br = uint32_t (((actualLength >> 1) + 8 * (byteCount + loasMuxOffset * (int64_t) br) * sampleRate) / actualLength);
+        br = uint32_t (((actualLength >> 1) + 8 * (pipe.byteCount + loasMuxOffset * (int64_t) br) * sampleRate) / actualLength);
         bw = 0; // print encoding statistics
 
         _ERROR2 (" Done, actual average %.1f kbit/s,", (float) br * 0.001f);
@@ -1339,9 +1876,9 @@ int main (const int argc, char* argv[])
       else
       {
 #endif
-      br = uint32_t (((actualLength >> 1) + 8 * (byteCount + 4 * (int64_t) mp4Writer.getFrameCount ()) * sampleRate) / actualLength);
-      bw = uint32_t (((frameLength  >> 1) + 8 * (bwMax + 4u /* max. 2048 AU size + stsz as bit-rate */) * sampleRate) / frameLength);
-      bw = mp4Writer.finishFile (br, bw, uint32_t (__min (UINT_MAX - startLength, actualLength)), (time (nullptr) + 2082844800) & UINT_MAX,
+      br = uint32_t (((actualLength >> 1) + 8 * (pipe.byteCount + 4 * (int64_t) mp4Writer.getFrameCount ()) * sampleRate) / actualLength);
+      bw = uint32_t (((frameLength  >> 1) + 8 * (pipe.auStats.auBytesMax + 4u /* max. 2048 AU size + stsz as bit-rate */) * sampleRate) / frameLength);
+      bw = mp4Writer.finishFile (br, bw, uint32_t (__min (UINT_MAX - startLength, actualLength)), eaGetMp4Time (),
                                  (i == 0) && (numChannels < 7) ? outAuData : nullptr);
       // print out collected file statistics
       if (enableSbrCoding)
@@ -1354,14 +1891,18 @@ int main (const int argc, char* argv[])
       }
       if (numChannels < 7)
       {
-        fprintf_s (stdout, " Input statistics:  File loudness %.2f LUFS,\tsample peak level %.2f dBFS\n\n",
+        const uint16_t truePeak = loudnessEst.getTruePeakLevel (); // 0 if metering is off
+
+        fprintf_s (stdout, " Input statistics:  File loudness %.2f LUFS,\tsample peak level %.2f dBFS",
                    __max (3u, loudStats >> 16) / 512.f - 100.0f, 20.0f * log10 (__max (EA_PEAK_MIN, float (loudStats & USHRT_MAX))) + EA_PEAK_NORM);
+        if (truePeak > 0) fprintf_s (stdout, ",\ttrue peak level %.2f dBTP", truePeak / 512.f - 100.0f);
+        fprintf_s (stdout, "\n\n");
       }
 #if ENABLE_STDOUT_LOAS
       } // writeStdout
 #endif
 
-      if (!readStdin && (actualLength != expectLength || bw != headerRes))
+      if (!readStdin && (actualLength != expectLength || (!fragmentedMp4 && bw != headerRes)))
       {
         if (actualLength != expectLength)
 #ifdef EXHALE_APP_WCHAR
@@ -1369,7 +1910,7 @@ int main (const int argc, char* argv[])
 #else
         fprintf_s (stderr, " WARNING: %lld sample frames read but %lld sample frames expected!\n", (long long) actualLength, (long long) expectLength);
 #endif
-        if (bw != headerRes) _ERROR1 (" WARNING: The encoded MPEG-4 bit-stream is likely to be unreadable!\n");
+        if (!fragmentedMp4 && bw != headerRes) _ERROR1 (" WARNING: The encoded MPEG-4 bit-stream is likely to be unreadable!\n");
         _ERROR1 ("\n");
       }
 #if USE_EXHALELIB_DLL
@@ -1382,12 +1923,15 @@ mainFinish:
 
   // free all dynamic memory
   MFREE (inPcmData);
-  MFREE (inPcmRsmp);
+  if (pcmResampler != nullptr) exhaleDeleteResampler (pcmResampler);
 #if EA_USE_WORK_DIR
   MFREE (currPath);
 #endif
   MFREE (outAuData);
 
+#if EA_SEG_THREADS > 1
+  while (numSegHandles > 0) _CLOSE (segFileHandle[--numSegHandles]);
+#endif
   // close input file
   if (inFileHandle != -1)
   {
@@ -1416,6 +1960,18 @@ mainFinish:
     }
     outFileHandle = 0;
   }
+#if EA_FRAME_STATS
+  // close frame statistics file
+  if (statsFileHandle != -1)
+  {
+    if (statsDump.writeJson) statsDump.fileWriter.write ((const uint8_t*) (statsDump.rowCount > 0 ? "\n]\n" : "[]\n"), 3);
+    if ((statsDump.fileWriter.flush () | (_CLOSE (statsFileHandle) != 0 ? 1u : 0u)) > 0)
+    {
+      _ERROR1 (" ERROR while trying to write frame statistics file!\n\n");
+    }
+    statsFileHandle = -1;
+  }
+#endif
 
   return (inFileHandle | outFileHandle | i);
 }
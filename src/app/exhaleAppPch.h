@@ -1,5 +1,5 @@
 /* exhaleAppPch.h - pre-compiled header file for source code of exhale application
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -13,6 +13,7 @@
 
 #include <limits.h> // for .._MAX, .._MIN
 #include <math.h>   // for log, pow, sqrt
+#include <stdio.h>  // for fprintf, snprintf
 #include <stdint.h> // for (u)int8_t, (u)int16_t, (u)int32_t, (u)int64_t
 #include <stdlib.h> // for abs, div, calloc, malloc, free, (__)max, (__)min, (s)rand
 #include <string.h> // for memcpy, memset
@@ -45,6 +46,9 @@
 #if !defined (fwprintf_s) && !defined (__MINGW32__)
 # define fwprintf_s            fwprintf
 #endif
+#if !defined (sprintf_s) && !defined (_MSC_VER) && !defined (__MINGW32__)
+# define sprintf_s             snprintf
+#endif
 #ifndef MFREE
 # define MFREE(x)              if (x != nullptr) { free ((void*) x); x = nullptr; }
 #endif
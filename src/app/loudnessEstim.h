@@ -1,5 +1,5 @@
 /* loudnessEstim.h - header file for class with ITU-R BS.1770-4 loudness level estimation
- * written by C. R. Helmrich, last modified in 2020 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -12,6 +12,7 @@
 #define _LOUDNESS_ESTIM_H_
 
 #include "exhaleAppPch.h"
+#include "../lib/exhaleLibPch.h" // for SIMD_X86, CPU feature checks
 
 // constants, experimental macros
 #define LE_ACCURATE_CALC       1 // correct filter order, no 500-Hz pre-high-pass
@@ -23,6 +24,12 @@
 #define LE_THRESH_ABS   (15.0f / 268435456.0f) // absolute threshold for -70 LUFS
 #define LE_LUFS_OFFSET  2.53125f // to get -3.01 LUFS for mono 997-Hz 0-dBFS sine
 #endif
+#define LE_HIST_RES           64 // gating histogram resolution, bins per dB
+#define LE_HIST_BINS (96 * LE_HIST_RES) // -70 LUFS up to above full-scale
+#define LE_NUM_WARM_UP         3 // gating blocks excluded from statistics
+#define LE_SHORT_TERM         30 // 100-msec quarters in 3-sec short-term window
+#define LE_TP_TAPS            12 // taps per phase of 4x true-peak interpolator
+#define LE_FILTER_AVX2         (LE_ACCURATE_CALC && SIMD_X86) // 1: channel-parallel K-filter if CPU supports AVX2
 
 // ITU-R loudness estimator class
 class LoudnessEstimator
@@ -39,31 +46,51 @@ private:
   int32_t  m_filterMemoryO[8]; // channel-wise previous K-weighting filter output
 #endif
   uint64_t m_powerValue[4][8]; // channel-wise power in each gating block quarter
+  uint64_t m_quarterPower[LE_SHORT_TERM]; // G_i weighted power of recent quarters
+  double   m_histPower[LE_HIST_BINS]; // sum of block powers in each histogram bin
+  uint32_t m_histCount[LE_HIST_BINS]; // number of gating blocks in histogram bin
+  double   m_warmUpPower[LE_NUM_WARM_UP]; // block powers of first gated blocks
+  double   m_momentaryPower; // power of last gating block, for momentary level
   float    m_gbNormFactor; // 64-sample normalization factor, 1/(4*m_gbHopSize64)
 #if LE_ACCURATE_CALC
   int8_t   m_filterFactor; // sampling rate dependent K-weighting filter constant
 #else
   uint8_t  m_filterFactor; // sampling rate dependent K-weighting filter constant
 #endif
+  bool     m_filterSimdPath; // runtime-dispatched channel-parallel K-filter
   uint8_t  m_gbHopLength64;  // number of 64-sample units in gating block quarter
   uint8_t  m_gbHopSize64;  // hop-size between gating blocks, 25% of block length
   uint8_t  m_inputChannels;
   uint32_t m_inputMaxValue;
   uint32_t m_inputPeakValue;
   int32_t* m_inputPcmData;
-  std::vector <uint32_t> m_gbRmsValues; // sqrt of power average per gating block
+  uint32_t m_numGbValues; // number of gating blocks above absolute threshold
+  uint32_t m_numQuarters; // number of completed quarters, for short-term level
+  float    m_tpHistory[2 * LE_TP_TAPS][8]; // interpolator input, doubled ring
+  uint8_t  m_tpHistPos; // index of newest sample in m_tpHistory
+  bool     m_tpMetering; // 1: measure 4x oversampled true-peak level
+  float    m_truePeakValue; // maximum of interpolated input magnitudes
+
+  // helper functions
+  uint16_t toLevel16Bits (const double meanPower) const; // L = i/512-100, 0: none
+  void     updateTruePeak (const int32_t* const pcmData, const unsigned numSamples);
 
 public:
 
   // constructor
   LoudnessEstimator (int32_t* const inputPcmData,       const unsigned bitDepth = 24,
-                     const unsigned sampleRate = 44100, const unsigned numChannels = 2);
+                     const unsigned sampleRate = 44100, const unsigned numChannels = 2,
+                     const bool truePeakMetering = false);
   // destructor
-  ~LoudnessEstimator () { reset (); }
+  ~LoudnessEstimator () { }
   // public functions
   uint32_t addNewPcmData (const unsigned samplesPerChannel);
-  uint32_t getStatistics (const bool includeWarmUp = false);
-  void     reset () { m_gbHopLength64 = m_inputPeakValue = 0; m_gbRmsValues.clear (); memset (m_powerValue, 0, sizeof (m_powerValue)); }
+  uint16_t getMomentaryLevel () const; // 400-msec level, same mapping as below
+  uint16_t getShortTermLevel () const; // 3-sec level, same mapping as below
+  uint32_t getStatistics (const bool includeWarmUp = false); // O(LE_HIST_BINS)
+  uint16_t getTruePeakLevel () const; // in dBTP = i/512-100, 0: none or not enabled
+  void     reset ();
+  void     setInputPcmData (int32_t* const inputPcmData) { m_inputPcmData = inputPcmData; }
 
 }; // LoudnessEstimator
 
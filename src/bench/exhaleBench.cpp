@@ -0,0 +1,856 @@
+/* exhaleBench.cpp - source file with main() routine for exhale kernel micro-benchmark executable
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#include "../lib/exhaleEnc.h"
+#include "../lib/polyphaseResampler.h"
+#include "../app/loudnessEstim.h"
+#include "version.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+// constants, experimental macros
+#define EB_FRAME_LENGTH   1024  // core-coder frame length of all kernels
+#define EB_NUM_RUNS          7  // runs per benchmark, median is reported
+#define EB_NUM_SIGNALS       4  // see ebSignalNames
+#define EB_NUM_SWB          51  // 32, 44.1, and 48 kHz long-window bands
+#define EB_MAX_SFB          47  // coded bands, around 16.5 kHz at 44.1 kHz
+#define EB_RTF_SECONDS      20  // length of full-encoder test signal
+#define EB_SAMPLE_RATE   44100
+
+static const char* const ebSignalNames[EB_NUM_SIGNALS] = {"noise", "tonal", "transient", "silence"};
+
+static const uint16_t ebSwbOffsets[EB_NUM_SWB + 1] = { // as sfbOffsetL2 in exhaleEnc.cpp
+    0,   4,   8,  12,  16,  20,  24,  28,  32,  36,  40,  48,  56,  64,  72,  80,  88,  96, 108, 120, 132, 144, 160, 176, 196, 216, 240,
+  264, 292, 320, 352, 384, 416, 448, 480, 512, 544, 576, 608, 640, 672, 704, 736, 768, 800, 832, 864, 896, 928, 960, 992, 1024
+};
+
+// static helper functions
+static void ebCreateSignal (int32_t* const signal, const unsigned numSamples, const unsigned numChannels, const unsigned signalType,
+                            const unsigned sampleRate) // channel-interleaved 24-bit synthetic test signal, same for every call
+{
+  std::minstd_rand randomInt32 (0x1234567u); // fixed seed for reproducibility
+  const double freqNorm = 6.283185307179586 / sampleRate;
+
+  for (unsigned s = 0; s < numSamples; s++)
+  {
+    for (unsigned ch = 0; ch < numChannels; ch++)
+    {
+      const int32_t noise = int32_t (randomInt32 () & 0xFFFFFF) - (1 << 23);
+      double d = 0.0;
+
+      switch (signalType)
+      {
+        case 0: // white noise at -6 dBFS
+          d = noise * 0.5;
+          break;
+        case 1: // harmonic tone at 220 Hz with slight stereo detuning, plus -90 dBFS noise
+          for (unsigned h = 1; h <= 12; h++) d += sin (freqNorm * 220.0 * h * (1.0 + 0.001 * ch) * s) * (1 << 21) / h;
+          d += noise * 3.2e-5;
+          break;
+        case 2: // decaying noise bursts every 8192 samples on -60 dBFS background noise
+          d = noise * (0.5 * exp (-double (s & 8191) / 256.0) + 0.001);
+          break;
+        default: // digital silence
+          break;
+      }
+      signal[s * numChannels + ch] = int32_t (__max (-8388608.0, __min (8388607.0, d)));
+    }
+  }
+}
+
+static void ebDeinterleave (int32_t* const output, const int32_t* const input, const unsigned numSamples, const unsigned numChannels,
+                            const unsigned channelIndex)
+{
+  for (unsigned s = 0; s < numSamples; s++) output[s] = input[s * numChannels + channelIndex];
+}
+
+static double ebMedian (std::vector <double>& values)
+{
+  std::sort (values.begin (), values.end ());
+
+  return values[values.size () >> 1];
+}
+
+static void ebPrintResult (const char* const benchName, const char* const signalName, const double nsPerCall, const double nsPerSample)
+{
+  fprintf (stdout, " %-42s %-10s %10.0f ns/call %8.2f ns/sample\n", benchName, signalName, nsPerCall, nsPerSample);
+}
+
+static bool ebSelected (const char* const benchName, const char* const filter)
+{
+  return (filter == nullptr) || (strstr (benchName, filter) != nullptr);
+}
+
+// benchmark context, holds all kernel classes and signal buffers
+class BenchContext
+{
+public:
+
+  // member variables
+  BitAllocator    bitAllocator;
+  EntropyCoder    entropyCoder;
+  LinearPredictor linPredictor;
+  SfbQuantizer    sfbQuantizer;
+  SpecAnalyzer    specAnalyzer;
+  StereoProcessor stereoCoder;
+  TempAnalyzer    tempAnalyzer;
+  LappedTransform transform;
+  SharedTables*   sharedTables;
+  std::vector <int32_t> coreSignals[2];
+  std::vector <int32_t> mdctSignals[2];
+  std::vector <int32_t> mdstSignals[2];
+  std::vector <uint8_t> quantMagn;
+  std::vector <int32_t> tempIntBuf;
+  std::vector <int32_t> timeSignals[2]; // at 2x rate for SBR
+  std::vector <int32_t> pcmSignal; // interleaved, for loudness
+  SfbGroupData    groupingData[2];
+  uint8_t         initScaleFacs[2][EB_NUM_SWB];
+  uint32_t        stepSizes[2][MAX_NUM_SWB_SHORT * NUM_WINDOW_GROUPS];
+
+  // constructor
+  BenchContext () { sharedTables = nullptr; }
+  // destructor
+  ~BenchContext () { SharedTables::release (sharedTables); }
+  // public functions
+  unsigned init (const unsigned signalType, const uint8_t bitRateMode);
+};
+
+unsigned BenchContext::init (const unsigned signalType, const uint8_t bitRateMode)
+{
+  const unsigned timeLength = (EB_FRAME_LENGTH * 41) >> 3; // 2 * temporalProcessing buffer length
+  std::vector <int32_t> interleaved (timeLength * 2);
+
+  if ((sharedTables == nullptr) && (sharedTables = SharedTables::acquire (EB_FRAME_LENGTH)) == nullptr) return 2;
+
+  ebCreateSignal (&interleaved.front (), timeLength, 2, signalType, EB_SAMPLE_RATE << 1);
+  pcmSignal.assign (interleaved.begin (), interleaved.begin () + EB_FRAME_LENGTH * 2);
+  quantMagn.assign (EB_FRAME_LENGTH, 0);
+  tempIntBuf.assign (EB_FRAME_LENGTH, 0);
+
+  for (unsigned ch = 0; ch < 2; ch++)
+  {
+    coreSignals[ch].assign (timeLength >> 1, 0);
+    mdctSignals[ch].assign (EB_FRAME_LENGTH, 0);
+    mdstSignals[ch].assign (EB_FRAME_LENGTH, 0);
+    timeSignals[ch].resize (timeLength);
+    ebDeinterleave (&timeSignals[ch].front (), &interleaved.front (), timeLength, 2, ch);
+  }
+
+  if ((entropyCoder.initCodingMemory (EB_FRAME_LENGTH) > 0) ||
+#if EC_TRELLIS_OPT_CODING
+      (sfbQuantizer.initQuantMemory (sharedTables, EB_FRAME_LENGTH, EB_NUM_SWB, bitRateMode, EB_SAMPLE_RATE) > 0) ||
+#else
+      (sfbQuantizer.initQuantMemory (sharedTables, EB_FRAME_LENGTH) > 0) ||
+#endif
+      (specAnalyzer.initSigAnaMemory (&linPredictor, 2, EB_FRAME_LENGTH) > 0) ||
+      (transform.initConstants (&tempIntBuf.front (), sharedTables) > 0))
+  {
+    return 1;
+  }
+
+  // long-window MCLT spectra and SFB statistics of both channels, as in spectralProcessing()
+  for (unsigned ch = 0; ch < 2; ch++)
+  {
+    SfbGroupData& grpData = groupingData[ch];
+
+    memset (&grpData, 0, sizeof (SfbGroupData));
+    grpData.numWindowGroups = 1;
+    grpData.sfbsPerGroup = EB_MAX_SFB;
+    grpData.windowGroupLength[0] = 1;
+    memcpy (grpData.sfbOffsets, ebSwbOffsets, (EB_NUM_SWB + 1) * sizeof (uint16_t));
+
+    if (transform.applyMCLT (&timeSignals[ch][EB_FRAME_LENGTH], false, false, false, false, false,
+                             &mdctSignals[ch].front (), &mdstSignals[ch].front ()) > 0 ||
+        specAnalyzer.getMeanAbsValues (&mdctSignals[ch].front (), &mdstSignals[ch].front (), EB_FRAME_LENGTH, ch,
+                                       ebSwbOffsets, EB_NUM_SWB, grpData.sfbRmsValues) > 0)
+    {
+      return 1;
+    }
+    for (unsigned b = 0; b < EB_NUM_SWB; b++) // step-sizes around 18 dB below band RMS
+    {
+      stepSizes[ch][b] = __max (BA_EPS, grpData.sfbRmsValues[b] >> 3);
+      initScaleFacs[ch][b] = bitAllocator.getScaleFac (stepSizes[ch][b], &mdctSignals[ch][ebSwbOffsets[b]],
+                                                       uint8_t (ebSwbOffsets[b + 1] - ebSwbOffsets[b]), grpData.sfbRmsValues[b]);
+    }
+  }
+  return 0; // no error
+}
+
+// quantization of all coded bands of one channel, as in elementQuantCoding()
+static uint32_t ebQuantizeSfbs (SfbQuantizer& sfbQuantizer, EntropyCoder& entropyCoder, const int32_t* const mdctSignal,
+                                const uint8_t* const initScaleFacs, uint32_t* const grpRms, uint8_t* const scaleFacs, uint8_t* const quantMagn)
+{
+  char* const arithTuples = entropyCoder.arithGetTuplePtr ();
+  uint32_t estimBitCount = 0;
+  uint8_t  sfIdxPred = UCHAR_MAX;
+  unsigned s = 0;
+
+  entropyCoder.initWindowCoding (true, false);
+  memset (quantMagn, 0, EB_FRAME_LENGTH * sizeof (uint8_t));
+
+  for (unsigned b = 0; b < EB_MAX_SFB; b++)
+  {
+    const uint8_t* const swbMagn = &quantMagn[ebSwbOffsets[b]];
+
+    scaleFacs[b] = sfbQuantizer.quantizeSpecSfb (entropyCoder, mdctSignal, 1, ebSwbOffsets, grpRms, b, initScaleFacs[b], sfIdxPred, quantMagn);
+    sfIdxPred = scaleFacs[b];
+    estimBitCount += grpRms[b] & USHRT_MAX;
+
+    for (uint16_t i = 0; i < ebSwbOffsets[b + 1] - ebSwbOffsets[b]; i += 2) // entropy coding 2-tuples for next SFB
+    {
+      arithTuples[s++] = __min (0xF, swbMagn[i] + swbMagn[i + 1] + 1);
+    }
+  }
+  return estimBitCount;
+}
+
+static uint32_t ebQuantizeSfbs (BenchContext& c, uint8_t* const scaleFacs) // channel 0
+{
+  return ebQuantizeSfbs (c.sfbQuantizer, c.entropyCoder, &c.mdctSignals[0].front (), c.initScaleFacs[0], c.groupingData[0].sfbRmsValues,
+                         scaleFacs, &c.quantMagn.front ());
+}
+
+static void ebRunKernels (BenchContext& c, const unsigned signalType, const unsigned numCalls, const char* const filter)
+{
+  const char* const signalName = ebSignalNames[signalType];
+  std::vector <char> tupleMemory (EB_FRAME_LENGTH >> 1);
+  std::vector <double> nsPerCall;
+  std::vector <int32_t> mdctBackup[2], mdstBackup[2];
+  SfbGroupData grpBackup[2];
+  uint8_t scaleFacs[EB_NUM_SWB];
+  std::chrono::steady_clock::time_point t0;
+  unsigned r, n;
+
+#define EB_TIME_KERNEL(prepare, kernel) \
+  nsPerCall.clear (); \
+  for (r = 0; r < EB_NUM_RUNS; r++) \
+  { \
+    double ns = 0.0; \
+    for (n = 0; n < numCalls; n++) \
+    { \
+      prepare; \
+      t0 = std::chrono::steady_clock::now (); \
+      kernel; \
+      ns += (double) std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - t0).count (); \
+    } \
+    nsPerCall.push_back (ns / numCalls); \
+  }
+
+  if (ebSelected ("LappedTransform::applyMCLT/long", filter))
+  {
+    EB_TIME_KERNEL ((void) 0, c.transform.applyMCLT (&c.timeSignals[0][EB_FRAME_LENGTH], false, false, false, false, false,
+                                                      &c.mdctSignals[1].front (), &c.mdstSignals[1].front ()));
+    ebPrintResult ("LappedTransform::applyMCLT/long", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / EB_FRAME_LENGTH);
+  }
+  if (ebSelected ("LappedTransform::applyMCLT/short", filter))
+  {
+    EB_TIME_KERNEL ((void) 0, c.transform.applyMCLT (&c.timeSignals[0][EB_FRAME_LENGTH], true, false, false, true, true,
+                                                      &c.mdctSignals[1].front (), &c.mdstSignals[1].front ()));
+    ebPrintResult ("LappedTransform::applyMCLT/short", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / EB_FRAME_LENGTH);
+  }
+  // restore channel 1 spectra overwritten above
+  c.transform.applyMCLT (&c.timeSignals[1][EB_FRAME_LENGTH], false, false, false, false, false, &c.mdctSignals[1].front (), &c.mdstSignals[1].front ());
+
+  memcpy (&tupleMemory.front (), c.entropyCoder.arithGetTuplePtr (), tupleMemory.size ());
+  grpBackup[0] = c.groupingData[0];
+
+  if (ebSelected ("SfbQuantizer::quantizeSpecSfb", filter))
+  {
+    EB_TIME_KERNEL (c.groupingData[0] = grpBackup[0], ebQuantizeSfbs (c, scaleFacs));
+    ebPrintResult ("SfbQuantizer::quantizeSpecSfb", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / ebSwbOffsets[EB_MAX_SFB]);
+  }
+#if EC_TRELLIS_OPT_CODING
+  if (ebSelected ("SfbQuantizer::quantizeSpecRDOC", filter))
+  {
+    uint32_t estimBitCount = 0;
+
+    EB_TIME_KERNEL (c.groupingData[0] = grpBackup[0]; estimBitCount = ebQuantizeSfbs (c, scaleFacs),
+                    c.sfbQuantizer.quantizeSpecRDOC (c.entropyCoder, scaleFacs, estimBitCount + 2u, ebSwbOffsets, c.groupingData[0].sfbRmsValues,
+                                                     EB_MAX_SFB, &c.quantMagn.front ()));
+    ebPrintResult ("SfbQuantizer::quantizeSpecRDOC", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / ebSwbOffsets[EB_MAX_SFB]);
+  }
+#endif
+  c.groupingData[0] = grpBackup[0];
+  ebQuantizeSfbs (c, scaleFacs); // quantized spectrum for arithmetic coding
+  memcpy (c.entropyCoder.arithGetTuplePtr (), &tupleMemory.front (), tupleMemory.size ());
+
+  if (ebSelected ("EntropyCoder::arithCodeSigMagn", filter))
+  {
+    EB_TIME_KERNEL (c.entropyCoder.initWindowCoding (true, false), c.entropyCoder.arithCodeSigMagn (&c.quantMagn.front (), 0, ebSwbOffsets[EB_MAX_SFB]));
+    ebPrintResult ("EntropyCoder::arithCodeSigMagn", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / ebSwbOffsets[EB_MAX_SFB]);
+  }
+  if (ebSelected ("TempAnalyzer::temporalAnalysis", filter))
+  {
+    const int32_t* const timeSigs[USAC_MAX_NUM_CHANNELS] = {&c.timeSignals[0].front (), &c.timeSignals[1].front ()};
+
+    EB_TIME_KERNEL ((void) 0, c.tempAnalyzer.temporalAnalysis (timeSigs, 2, EB_FRAME_LENGTH, (EB_FRAME_LENGTH * 25) >> 4, 0));
+    ebPrintResult ("TempAnalyzer::temporalAnalysis", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / (EB_FRAME_LENGTH * 2));
+  }
+  if (ebSelected ("TempAnalyzer::temporalAnalysis/sbr", filter))
+  {
+    const int32_t* const timeSigs[USAC_MAX_NUM_CHANNELS] = {&c.timeSignals[0].front (), &c.timeSignals[1].front ()};
+    int32_t* const       coreSigs[USAC_MAX_NUM_CHANNELS] = {&c.coreSignals[0].front (), &c.coreSignals[1].front ()};
+
+    EB_TIME_KERNEL ((void) 0, c.tempAnalyzer.temporalAnalysis (timeSigs, 2, EB_FRAME_LENGTH << 1, (EB_FRAME_LENGTH * 25) >> 3, 1, coreSigs));
+    ebPrintResult ("TempAnalyzer::temporalAnalysis/sbr", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / (EB_FRAME_LENGTH * 4));
+  }
+  if (ebSelected ("SpecAnalyzer::spectralAnalysis", filter))
+  {
+    const int32_t* const mdctSigs[USAC_MAX_NUM_CHANNELS] = {&c.mdctSignals[0].front (), &c.mdctSignals[1].front ()};
+    const int32_t* const mdstSigs[USAC_MAX_NUM_CHANNELS] = {&c.mdstSignals[0].front (), &c.mdstSignals[1].front ()};
+
+    EB_TIME_KERNEL ((void) 0, c.specAnalyzer.spectralAnalysis (mdctSigs, mdstSigs, 2, EB_FRAME_LENGTH, EB_SAMPLE_RATE));
+    ebPrintResult ("SpecAnalyzer::spectralAnalysis", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / (EB_FRAME_LENGTH * 2));
+  }
+  if (ebSelected ("StereoProcessor::applyPredJointStereo", filter))
+  {
+    const TnsData noTnsData = TnsData ();
+    uint32_t stepSizes[2][MAX_NUM_SWB_SHORT * NUM_WINDOW_GROUPS];
+    uint8_t  stereoData[MAX_NUM_SWB_SHORT * NUM_WINDOW_GROUPS];
+
+    for (unsigned ch = 0; ch < 2; ch++)
+    {
+      mdctBackup[ch] = c.mdctSignals[ch];
+      mdstBackup[ch] = c.mdstSignals[ch];
+      grpBackup[ch]  = c.groupingData[ch];
+    }
+    EB_TIME_KERNEL (for (unsigned ch = 0; ch < 2; ch++)
+                    {
+                      memcpy (&c.mdctSignals[ch].front (), &mdctBackup[ch].front (), EB_FRAME_LENGTH * sizeof (int32_t));
+                      memcpy (&c.mdstSignals[ch].front (), &mdstBackup[ch].front (), EB_FRAME_LENGTH * sizeof (int32_t));
+                      memcpy (stepSizes[ch], c.stepSizes[ch], sizeof (stepSizes[ch]));
+                      c.groupingData[ch] = grpBackup[ch];
+                    },
+                    c.stereoCoder.applyPredJointStereo (&c.mdctSignals[0].front (), &c.mdctSignals[1].front (),
+                                                        &c.mdstSignals[0].front (), &c.mdstSignals[1].front (),
+                                                        c.groupingData[0], c.groupingData[1], noTnsData, noTnsData,
+                                                        EB_MAX_SFB, stereoData, 5, false, false, EB_MAX_SFB, stepSizes[0], stepSizes[1]));
+    ebPrintResult ("StereoProcessor::applyPredJointStereo", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / (EB_FRAME_LENGTH * 2));
+
+    for (unsigned ch = 0; ch < 2; ch++)
+    {
+      c.mdctSignals[ch]  = mdctBackup[ch];
+      c.mdstSignals[ch]  = mdstBackup[ch];
+      c.groupingData[ch] = grpBackup[ch];
+    }
+  }
+  if (ebSelected ("LoudnessEstimator::addNewPcmData", filter))
+  {
+    LoudnessEstimator loudnessEst (&c.pcmSignal.front (), 24, EB_SAMPLE_RATE, 2);
+
+    EB_TIME_KERNEL (if ((n & 255) == 0) loudnessEst.reset (), loudnessEst.addNewPcmData (EB_FRAME_LENGTH));
+    ebPrintResult ("LoudnessEstimator::addNewPcmData", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / (EB_FRAME_LENGTH * 2));
+  }
+  if (ebSelected ("LoudnessEstimator::addNewPcmData/truepeak", filter))
+  {
+    LoudnessEstimator loudnessEst (&c.pcmSignal.front (), 24, EB_SAMPLE_RATE, 2, true);
+
+    EB_TIME_KERNEL (if ((n & 255) == 0) loudnessEst.reset (), loudnessEst.addNewPcmData (EB_FRAME_LENGTH));
+    ebPrintResult ("LoudnessEstimator::addNewPcmData/truepeak", signalName, ebMedian (nsPerCall), ebMedian (nsPerCall) / (EB_FRAME_LENGTH * 2));
+  }
+#undef EB_TIME_KERNEL
+}
+
+// full-encoder real-time factor of one preset, in percent of the signal duration
+static double ebEncoderRtf (const char preset, const int32_t* const signal, const unsigned numSamples, const unsigned sampleRate)
+{
+  const bool     sbrPreset   = (preset >= 'a');
+  const unsigned frameLength = (sbrPreset ? EB_FRAME_LENGTH << 1 : EB_FRAME_LENGTH);
+  const unsigned bitRateMode = (sbrPreset ? preset - 'a' : preset - '0');
+  std::vector <int32_t> pcmFrame (frameLength * 2, 0);
+  std::vector <uint8_t> auBuffer (EE_MAX_AU_BYTES * 2);
+  unsigned char audioConfig[108] = {0};
+  uint32_t audioConfigBytes = 0;
+  ExhaleEncoder exhaleEnc (&pcmFrame.front (), &auBuffer.front (), sampleRate, 2, frameLength, 45, bitRateMode
+#if !RESTRICT_TO_AAC
+                         , true, sbrPreset
+#endif
+                           );
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now ();
+
+  if ((exhaleEnc.initEncoder (audioConfig, &audioConfigBytes) > 0) || (exhaleEnc.encodeLookahead () < 3)) return -1.0;
+
+  for (unsigned s = 0; s + frameLength <= numSamples; s += frameLength)
+  {
+    memcpy (&pcmFrame.front (), &signal[s * 2], frameLength * 2 * sizeof (int32_t));
+
+    if (exhaleEnc.encodeFrame () < 3) return -1.0;
+  }
+  return (100.0 * std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - t0).count ()) /
+         (1.0e9 * numSamples / sampleRate);
+}
+
+// kernel consistency checks, mostly SIMD vs. scalar paths, each returns the number of differing output values or UINT_MAX on error
+template <typename T> static unsigned ebNumDiffs (const T* const a, const T* const b, const unsigned n)
+{
+  unsigned numDiffs = 0;
+
+  for (unsigned i = 0; i < n; i++) if (a[i] != b[i]) numDiffs++;
+
+  return numDiffs;
+}
+
+static int32_t ebRandomSample (std::minstd_rand& randomInt32, const bool fullScale) // 24-bit
+{
+  const int32_t noise = int32_t (randomInt32 () & 0xFFFFFF) - (1 << 23);
+
+  return (fullScale ? (noise < 0 ? -8388608 : 8388607) : noise);
+}
+
+static unsigned ebCheckHalfBandFilter ()
+{
+  const int margin = 2 * HB_PHASE_OFFSET; // filter history and look-ahead
+  std::vector <int32_t> hrSig (2 * (HB_MAX_OUT_LENGTH + margin));
+  std::minstd_rand randomInt32 (0x1234567u);
+  HalfBandFilter simdFilter; // path selected in constructor
+  unsigned numDiffs = 0;
+
+  setScalarOnly (true);
+  HalfBandFilter scalarFilter;
+  setScalarOnly (false);
+
+  for (unsigned t = 0; t < 64; t++)
+  {
+    const int nOutSamples = (t < 2 ? HB_MAX_OUT_LENGTH : 1 + int (randomInt32 () % HB_MAX_OUT_LENGTH));
+    const int bandPassPhase = t & 1;
+    const int64_t* bpSimd = simdFilter.getBandPassOutput ();
+    const int64_t* bpScal = scalarFilter.getBandPassOutput ();
+
+    for (size_t s = 0; s < hrSig.size (); s++) hrSig[s] = ebRandomSample (randomInt32, (t & 4) && (randomInt32 () & 1));
+
+    if ((simdFilter.applyFilter   (&hrSig[margin], nOutSamples, bandPassPhase) > 0) ||
+        (scalarFilter.applyFilter (&hrSig[margin], nOutSamples, bandPassPhase) > 0)) return UINT_MAX;
+
+    numDiffs += ebNumDiffs (simdFilter.getLowPassOutput (), scalarFilter.getLowPassOutput (), nOutSamples);
+
+    for (int j = bandPassPhase; j < nOutSamples; j += 2) if (bpSimd[j] != bpScal[j]) numDiffs++;
+  }
+  return numDiffs;
+}
+
+static unsigned ebCheckPlanarInput (const ExhalePcmFormat pcmFormat, const unsigned inputFlags)
+{
+  const unsigned numSamples = EB_FRAME_LENGTH * 16;
+  const size_t   bytesPerS  = (pcmFormat == EXHALE_PCM_S16 ? sizeof (int16_t) : sizeof (int32_t));
+  std::vector <uint8_t> planar (numSamples * bytesPerS);
+  std::vector <int32_t> int24Data[2];
+  std::minstd_rand randomInt32 (0x1234567u);
+  const void* channelData[2] = {&planar.front (), &planar.front ()};
+  unsigned char auBuffer[1] = {0}; // not used
+  unsigned s, t;
+
+  for (s = 0; s < numSamples; s++) // 24-bit samples at decreasing levels, partly at or beyond full scale
+  {
+    const int32_t i24 = ebRandomSample (randomInt32, ((s >> 12) & 1) && (randomInt32 () & 1)) >> ((s >> 10) & 3) * 4;
+    uint8_t* const sample = &planar[s * bytesPerS];
+
+    if (pcmFormat == EXHALE_PCM_S16)
+    {
+      const int16_t i16 = int16_t (i24 >> 8);
+
+      memcpy (sample, &i16, sizeof (int16_t));
+    }
+    else if (pcmFormat == EXHALE_PCM_F32) // plus sub-LSB offsets, 3% above full scale in some blocks
+    {
+      const float f32 = float (i24) * ((s >> 12) & 1 ? 1.03125f : 1.0f) / 8388608.0f + float ((randomInt32 () & 1023) / 1048576.0);
+
+      memcpy (sample, &f32, sizeof (float));
+    }
+    else // EXHALE_PCM_S24, twice the range in some blocks if clipped
+    {
+      const int32_t i32 = ((inputFlags & EXHALE_INPUT_CLIP) && ((s >> 12) & 1) ? i24 * 2 : i24);
+
+      memcpy (sample, &i32, sizeof (int32_t));
+    }
+  }
+
+  for (t = 0; t < 2; t++) // same input in chunks of random length, so remainders and dither state are tested
+  {
+    std::minstd_rand randomChunk (0x7654321u);
+
+    setScalarOnly (t > 0);
+    ExhaleEncoder exhaleEnc (nullptr, auBuffer, 48000, 2); // selects conversion path
+    setScalarOnly (false);
+
+    if (exhaleEnc.setPlanarInput (channelData, pcmFormat, inputFlags) > 0) return UINT_MAX;
+
+    int24Data[t].assign (numSamples, 0);
+
+    for (s = 0; s < numSamples; )
+    {
+      const unsigned chunkLength = __min (numSamples - s, 1 + randomChunk () % (EB_FRAME_LENGTH + 8));
+
+      if (exhaleEnc.convertPlanarInput (&planar[s * bytesPerS], &int24Data[t][s], chunkLength) > 0) return UINT_MAX;
+      s += chunkLength;
+    }
+  }
+  return ebNumDiffs (&int24Data[0].front (), &int24Data[1].front (), numSamples);
+}
+
+static unsigned ebCheckResampler ()
+{
+  const unsigned rates[][2] = {{32000, 64000}, {48000, 32000}, {44100, 48000}, {48000, 44100}, {96000, 48000}, {8000, 48000},
+                               {88200, 32000}, {192000, 44100}}; // tuned 2:1 and 2:3 filters, designed windowed-sinc filters
+  const unsigned numChannels = 2, maxOutLength = 1024;
+  std::minstd_rand randomInt32 (0x1234567u);
+  unsigned numDiffs = 0;
+
+  for (unsigned r = 0; r < sizeof (rates) / sizeof (rates[0]); r++)
+  {
+    PolyphaseResampler simdResampler; // path selected in constructor
+    std::vector <int32_t> pcm[2];
+
+    setScalarOnly (true);
+    PolyphaseResampler scalarResampler;
+    setScalarOnly (false);
+
+    if ((simdResampler.initResampler   (rates[r][0], rates[r][1], numChannels, maxOutLength) > 0) ||
+        (scalarResampler.initResampler (rates[r][0], rates[r][1], numChannels, maxOutLength) > 0)) return UINT_MAX;
+
+    for (unsigned c = 0; c < 24; c++) // calls of random length, restart in the middle
+    {
+      const unsigned numOutSamples = (c == 0 ? maxOutLength : 1 + randomInt32 () % maxOutLength);
+      const bool     restart = (c == 12);
+      const unsigned inLength = simdResampler.getInputLength (numOutSamples, restart);
+
+      if (inLength != scalarResampler.getInputLength (numOutSamples, restart)) return UINT_MAX;
+
+      pcm[0].resize (__max (inLength, numOutSamples) * numChannels);
+
+      for (unsigned s = 0; s < inLength * numChannels; s++) pcm[0][s] = ebRandomSample (randomInt32, (c & 4) && (randomInt32 () & 1));
+      pcm[1] = pcm[0]; // works in-place
+
+      if ((simdResampler.applyResampler   (&pcm[0].front (), numOutSamples, restart) > 0) ||
+          (scalarResampler.applyResampler (&pcm[1].front (), numOutSamples, restart) > 0)) return UINT_MAX;
+
+      numDiffs += ebNumDiffs (&pcm[0].front (), &pcm[1].front (), numOutSamples * numChannels);
+    }
+  }
+  return numDiffs;
+}
+
+static unsigned ebCheckTransform ()
+{
+  std::minstd_rand randomInt32 (0x1234567u);
+  unsigned numDiffs = 0;
+
+  for (unsigned frameLength = 128; frameLength <= 8192; frameLength <<= 1) // all FFT lengths, long and eight short
+  {
+    SharedTables* const sharedTables = SharedTables::acquire (frameLength);
+    std::vector <int32_t> timeSignal (frameLength * 2);
+    std::vector <int32_t> mdctSignals[2], mdstSignals[2], tempIntBufs[2];
+    LappedTransform transforms[2]; // path selected in initConstants
+    unsigned t;
+
+    for (t = 0; t < 2; t++)
+    {
+      mdctSignals[t].assign (frameLength, 0);
+      mdstSignals[t].assign (frameLength, 0);
+      tempIntBufs[t].assign (frameLength, 0);
+      setScalarOnly (t > 0);
+
+      if (transforms[t].initConstants (&tempIntBufs[t].front (), sharedTables) > 0) numDiffs = UINT_MAX;
+    }
+    setScalarOnly (false);
+
+    for (unsigned w = 0; (w < 16) && (numDiffs != UINT_MAX); w++) // all window shapes, short windows in odd calls
+    {
+      for (size_t s = 0; s < timeSignal.size (); s++) timeSignal[s] = ebRandomSample (randomInt32, (w & 8) && (randomInt32 () & 1));
+
+      for (t = 0; t < 2; t++)
+      {
+        transforms[t].applyMCLT (&timeSignal.front (), w & 1, (w & 2) != 0, (w & 4) != 0, (w & 4) != 0, (w & 2) != 0,
+                                 &mdctSignals[t].front (), &mdstSignals[t].front ());
+      }
+      numDiffs += ebNumDiffs (&mdctSignals[0].front (), &mdctSignals[1].front (), frameLength) +
+                  ebNumDiffs (&mdstSignals[0].front (), &mdstSignals[1].front (), frameLength);
+    }
+    SharedTables::release (sharedTables);
+
+    if (numDiffs == UINT_MAX) break;
+  }
+  return numDiffs;
+}
+
+static unsigned ebCheckQuantizer ()
+{
+  SharedTables* const sharedTables = SharedTables::acquire (EB_FRAME_LENGTH);
+  std::vector <int32_t> mdctSignal (EB_FRAME_LENGTH);
+  std::vector <uint8_t> quantMagn[2];
+  std::minstd_rand randomInt32 (0x1234567u);
+  EntropyCoder entropyCoder[2];
+  SfbQuantizer sfbQuantizer[2]; // path selected in initQuantMemory
+  uint32_t grpStats[2][EB_NUM_SWB];
+  uint8_t  scaleFacs[2][EB_NUM_SWB], initScaleFacs[EB_NUM_SWB];
+  unsigned numDiffs = 0, b, i, t;
+
+  for (t = 0; t < 2; t++)
+  {
+    quantMagn[t].assign (EB_FRAME_LENGTH, 0);
+    setScalarOnly (t > 0);
+
+    if ((entropyCoder[t].initCodingMemory (EB_FRAME_LENGTH) > 0) ||
+#if EC_TRELLIS_OPT_CODING
+        (sfbQuantizer[t].initQuantMemory (sharedTables, EB_FRAME_LENGTH, EB_NUM_SWB, 5, EB_SAMPLE_RATE) > 0))
+#else
+        (sfbQuantizer[t].initQuantMemory (sharedTables, EB_FRAME_LENGTH) > 0))
+#endif
+    {
+      setScalarOnly (false);
+      SharedTables::release (sharedTables);
+      return UINT_MAX;
+    }
+  }
+  setScalarOnly (false);
+
+  for (unsigned f = 0; f < 64; f++) // random spectra, levels, and start scale factors per band
+  {
+    uint32_t estimBitCount[2];
+
+    for (b = 0; b < EB_MAX_SFB; b++)
+    {
+      const unsigned magnBits = randomInt32 () % 24; // 0: zero band
+      const int sfOffset = int (randomInt32 () % 48); // up to 36 dB finer than max. magnitude, which needs pow ()
+      int32_t maxAbs = 0;
+
+      for (i = ebSwbOffsets[b]; i < ebSwbOffsets[b + 1]; i++)
+      {
+        mdctSignal[i] = (magnBits == 0 ? 0 : int32_t (randomInt32 () & ((2u << magnBits) - 1)) - (1 << magnBits));
+        maxAbs = __max (maxAbs, abs (mdctSignal[i]));
+      }
+      initScaleFacs[b] = (uint8_t) __max (0, __min (SCHAR_MAX, int (sfbQuantizer[0].getScaleFacOffset (maxAbs)) - sfOffset));
+    }
+    for (t = 0; t < 2; t++)
+    {
+      estimBitCount[t] = ebQuantizeSfbs (sfbQuantizer[t], entropyCoder[t], &mdctSignal.front (), initScaleFacs, grpStats[t],
+                                         scaleFacs[t], &quantMagn[t].front ());
+    }
+    numDiffs += ebNumDiffs (scaleFacs[0], scaleFacs[1], EB_MAX_SFB) + ebNumDiffs (grpStats[0], grpStats[1], EB_MAX_SFB) +
+                ebNumDiffs (&quantMagn[0].front (), &quantMagn[1].front (), EB_FRAME_LENGTH) + (estimBitCount[0] != estimBitCount[1] ? 1 : 0);
+#if EC_TRELLIS_OPT_CODING
+    for (t = 0; t < 2; t++)
+    {
+      estimBitCount[t] = sfbQuantizer[t].quantizeSpecRDOC (entropyCoder[t], scaleFacs[t], estimBitCount[t] + 2u, ebSwbOffsets,
+                                                           grpStats[t], EB_MAX_SFB, &quantMagn[t].front ());
+    }
+    numDiffs += ebNumDiffs (scaleFacs[0], scaleFacs[1], EB_MAX_SFB) + (estimBitCount[0] != estimBitCount[1] ? 1 : 0) +
+                ebNumDiffs (&quantMagn[0].front (), &quantMagn[1].front (), EB_FRAME_LENGTH);
+#endif
+  }
+  SharedTables::release (sharedTables);
+
+  return numDiffs;
+}
+
+// reference bit writer, OutputStream as it was before the 64-bit accumulator, for ebCheckBitWriter ()
+struct EbRefOutputStream
+{
+  uint8_t heldBitChunk; // bits not yet flushed to buffer
+  uint8_t heldBitCount; // number of bits not yet flushed
+  std::vector <uint8_t> stream; // FIFO bit-stream buffer
+  // constructor
+  EbRefOutputStream () { heldBitChunk = heldBitCount = 0; }
+  // public functions
+  void byteAlign () { if (heldBitCount > 0) stream.push_back (heldBitChunk); heldBitChunk = heldBitCount = 0; }
+  void write (const uint32_t bitChunk, const uint8_t bitCount)
+  {
+    if (bitCount == 0) return; // nothing to do for length 0, max. length is 32
+
+    const uint8_t totalBitCount   = bitCount + heldBitCount;
+    const uint8_t totalByteCount  = totalBitCount >> 3;  // to be written
+    const uint8_t newHeldBitCount = totalBitCount & 7; // not yet written
+    const uint8_t newHeldBitChunk = (bitChunk << (8 - newHeldBitCount)) & UCHAR_MAX;
+
+    if (totalByteCount == 0) // not enough bits to write, only update held bits
+    {
+      heldBitChunk |= newHeldBitChunk;
+    }
+    else // write bits
+    {
+      const uint32_t writtenChunk = (heldBitChunk << uint32_t ((bitCount - newHeldBitCount) & ~7)) | (bitChunk >> newHeldBitCount);
+      switch (totalByteCount)
+      {
+        case 4: stream.push_back (writtenChunk >> 24);
+        case 3: stream.push_back (writtenChunk >> 16);
+        case 2: stream.push_back (writtenChunk >> 8);
+        case 1: stream.push_back (writtenChunk);
+      }
+      heldBitChunk = newHeldBitChunk;
+    }
+    heldBitCount = newHeldBitCount;
+  }
+}; // EbRefOutputStream
+
+static void ebWriteSymbols (std::minstd_rand& randomInt32, const unsigned numSymbols, EbRefOutputStream& refStream, OutputStream& stream)
+{
+  for (unsigned i = 0; i < numSymbols; i++) // random values of random bit count, 0-31 bits (reference shifts by 32 for 32)
+  {
+    const uint8_t  bitCount = uint8_t (randomInt32 () % 32);
+    const uint32_t bitChunk = (randomInt32 () ^ (randomInt32 () << 16)) & ((uint64_t (1) << bitCount) - 1u);
+
+    refStream.write (bitChunk, bitCount);
+    stream.write (bitChunk, bitCount);
+  }
+}
+
+static unsigned ebCheckBitWriter ()
+{
+  std::minstd_rand randomInt32 (0x1234567u);
+  std::vector <uint8_t> accessUnit (6144 >> 3), preRollAu (768); // 1-channel AU limit, pre-roll AU buffer
+  unsigned numDiffs = 0;
+
+  for (unsigned t = 0; t < 256; t++)
+  {
+    const uint32_t byteLimit = (t & 3 ? (uint32_t) accessUnit.size () : 1 + randomInt32 () % accessUnit.size ()); // some AUs truncated
+    EbRefOutputStream refStream, refPreRoll;
+    OutputStream stream, preRoll;
+    uint32_t auBitCount, byteCount;
+    uint8_t  ipfAuState[3];
+
+    stream.reset (&accessUnit.front (), byteLimit);
+    ebWriteSymbols (randomInt32, 1 + randomInt32 () % 150, refStream, stream);
+
+    // IPF state of AU, as in writeFDChannelStream (): completed bytes, held bits, and MSB-aligned held bit chunk
+    auBitCount    = stream.getBitCount ();
+    ipfAuState[0] = uint8_t (auBitCount & 7);
+    ipfAuState[1] = uint8_t (stream.heldBitChunk << (8 - (auBitCount & 7)));
+    if ((auBitCount >> 3 != refStream.stream.size ()) || (ipfAuState[0] != refStream.heldBitCount) || (ipfAuState[1] != refStream.heldBitChunk))
+    {
+      numDiffs++;
+    }
+    ebWriteSymbols (randomInt32, randomInt32 () % 400, refStream, stream);
+    refStream.byteAlign ();
+    stream.byteAlign ();
+
+    byteCount = (uint32_t) refStream.stream.size ();
+    numDiffs += (stream.byteCount != byteCount ? 1 : 0) + ebNumDiffs (&accessUnit.front (), &refStream.stream.front (), __min (byteCount, byteLimit));
+
+    // low-rate pre-roll AU, as in getLowRatePreRollAU (): restart from the IPF state, add new bits
+    refPreRoll.stream.assign (refStream.stream.begin (), refStream.stream.begin () + (auBitCount >> 3));
+    refPreRoll.heldBitCount = ipfAuState[0];
+    refPreRoll.heldBitChunk = ipfAuState[1];
+
+    preRoll.reset (&preRollAu.front (), (uint32_t) preRollAu.size ());
+    for (byteCount = 0; byteCount < auBitCount >> 3; byteCount++) preRoll.write (refStream.stream[byteCount], 8);
+    preRoll.write (ipfAuState[1] >> (8 - ipfAuState[0]), ipfAuState[0]);
+
+    ebWriteSymbols (randomInt32, 1 + randomInt32 () % 20, refPreRoll, preRoll);
+    refPreRoll.byteAlign ();
+    preRoll.byteAlign ();
+
+    byteCount = (uint32_t) refPreRoll.stream.size ();
+    numDiffs += (preRoll.byteCount != byteCount ? 1 : 0) + ebNumDiffs (&preRollAu.front (), &refPreRoll.stream.front (), __min (byteCount, 768u));
+  }
+  return numDiffs;
+}
+
+static unsigned ebRunChecks (const char* const filter)
+{
+  unsigned numChecks = 0, numFailed = 0;
+
+#define EB_CHECK_KERNEL(checkName, check) \
+  if (ebSelected (checkName, filter)) \
+  { \
+    const unsigned numDiffs = check; \
+    if (numDiffs == UINT_MAX) fprintf (stdout, " %-42s ERROR\n", checkName); \
+    else if (numDiffs > 0) fprintf (stdout, " %-42s MISMATCH, %u values differ\n", checkName, numDiffs); \
+    else fprintf (stdout, " %-42s bit-exact\n", checkName); \
+    if (numDiffs > 0) numFailed++; \
+    numChecks++; \
+  }
+
+  EB_CHECK_KERNEL ("HalfBandFilter::applyFilter", ebCheckHalfBandFilter ());
+  EB_CHECK_KERNEL ("LappedTransform::applyMCLT", ebCheckTransform ());
+  EB_CHECK_KERNEL ("ExhaleEncoder::convertPlanarInput/int16",  ebCheckPlanarInput (EXHALE_PCM_S16, 0));
+  EB_CHECK_KERNEL ("ExhaleEncoder::convertPlanarInput/int24",  ebCheckPlanarInput (EXHALE_PCM_S24, 0));
+  EB_CHECK_KERNEL ("ExhaleEncoder::convertPlanarInput/clip",   ebCheckPlanarInput (EXHALE_PCM_S24, EXHALE_INPUT_CLIP));
+  EB_CHECK_KERNEL ("ExhaleEncoder::convertPlanarInput/float",  ebCheckPlanarInput (EXHALE_PCM_F32, 0));
+  EB_CHECK_KERNEL ("ExhaleEncoder::convertPlanarInput/dither", ebCheckPlanarInput (EXHALE_PCM_F32, EXHALE_INPUT_DITHER));
+  EB_CHECK_KERNEL ("PolyphaseResampler::applyResampler", ebCheckResampler ());
+  EB_CHECK_KERNEL ("SfbQuantizer::quantizeSpecSfb", ebCheckQuantizer ());
+  EB_CHECK_KERNEL ("OutputStream::write", ebCheckBitWriter ());
+#undef EB_CHECK_KERNEL
+
+  if (numChecks == 0) fprintf (stderr, " ERROR: no consistency check matches %s!\n", filter);
+
+  return (numChecks == 0 ? 1 : numFailed);
+}
+
+// main routine
+int main (const int argc, char* argv[])
+{
+  const char* const filter = (argc > 1 && strcmp (argv[1], "all") != 0 ? argv[1] : nullptr);
+  const unsigned   numCalls = (argc > 2 ? __max (1, atoi (argv[2])) : 200);
+  const char presets[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f', 'g'};
+  unsigned t;
+
+  if ((argc > 1) && (strcmp (argv[1], "check") == 0)) // bit-exact kernel outputs
+  {
+    const bool simd = isAvx2Supported () || isSse41Supported ();
+
+    fprintf (stdout, "\n exhaleBench %s.%s%s - kernel consistency checks, SIMD vs. scalar paths%s\n\n", EXHALELIB_VERSION_MAJOR,
+             EXHALELIB_VERSION_MINOR, EXHALELIB_VERSION_BUGFIX, simd ? "" : " (no SIMD support, scalar paths only)");
+    t = ebRunChecks (argc > 2 && strcmp (argv[2], "all") != 0 ? argv[2] : nullptr);
+    fprintf (stdout, "\n");
+
+    return (t > 0 ? 1 : 0);
+  }
+
+  fprintf (stdout, "\n exhaleBench %s.%s%s - kernel micro-benchmarks, median of %d runs of %u calls each\n\n",
+           EXHALELIB_VERSION_MAJOR, EXHALELIB_VERSION_MINOR, EXHALELIB_VERSION_BUGFIX, EB_NUM_RUNS, numCalls);
+
+  if ((argc > 1) && (argv[1][0] == '-'))
+  {
+    fprintf (stdout, " Usage:\t%s [benchmark name filter | all] [calls per run]\n", argv[0]);
+    fprintf (stdout, "   or\t%s check [kernel name filter | all]\n\n", argv[0]);
+    fprintf (stdout, " e.g.\t%s applyMCLT 1000,  or  %s encoder,  or  %s check\n\n", argv[0], argv[0], argv[0]);
+    return 0;
+  }
+
+  for (t = 0; t < EB_NUM_SIGNALS; t++) // kernels on each synthetic signal
+  {
+    BenchContext context;
+
+    if (context.init (t, 5) > 0)
+    {
+      fprintf (stderr, " ERROR while trying to initialize %s benchmark context!\n\n", ebSignalNames[t]);
+      return 1;
+    }
+    ebRunKernels (context, t, numCalls, filter);
+  }
+
+  if (ebSelected ("ExhaleEncoder::encodeFrame", filter) || ebSelected ("encoder", filter))
+  {
+    const unsigned segLength = EB_RTF_SECONDS * 48000 / EB_NUM_SIGNALS;
+    std::vector <int32_t> signal (segLength * EB_NUM_SIGNALS * 2);
+
+    fprintf (stdout, "\n Full encoder, %d-second stereo signal of all %d signal types, real-time factor in %%\n\n", EB_RTF_SECONDS, EB_NUM_SIGNALS);
+
+    for (t = 0; t < EB_NUM_SIGNALS; t++) ebCreateSignal (&signal[segLength * 2 * t], segLength, 2, t, 48000);
+
+    for (t = 0; t < sizeof (presets); t++)
+    {
+      const unsigned sampleRate = (presets[t] <= '1' ? 32000 : (presets[t] < 'a' ? EB_SAMPLE_RATE : 48000)); // exhaleApp caps presets 0, 1 at 32 kHz
+      const double rtf = ebEncoderRtf (presets[t], &signal.front (), segLength * EB_NUM_SIGNALS, sampleRate);
+
+      if (rtf < 0.0)
+      {
+        fprintf (stderr, " ERROR while trying to encode with preset %c!\n\n", presets[t]);
+        return 1;
+      }
+      fprintf (stdout, " %-42s preset %c %5u Hz %8.3f %% RTF\n", "ExhaleEncoder::encodeFrame", presets[t], sampleRate, rtf);
+    }
+  }
+  fprintf (stdout, "\n");
+
+  return 0;
+}
@@ -1,5 +1,5 @@
 /* bitAllocation.cpp - source file for class needed for psychoacoustic bit-allocation
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -168,8 +168,11 @@ uint8_t BitAllocator::getScaleFac (const uint32_t sfbStepSize, const int32_t* co
   return __min (SCHAR_MAX, sf);
 }
 
-unsigned BitAllocator::initAllocMemory (LinearPredictor* const linPredictor, const uint8_t numSwb, const uint8_t bitRateMode)
+unsigned BitAllocator::initAllocMemory (LinearPredictor* const linPredictor, const uint8_t numSwb, const uint8_t bitRateMode,
+                                        MemoryArena* const arena /*= nullptr*/)
 {
+  MemoryArena& memArena = (arena != nullptr ? *arena : m_memArena);
+
   if (linPredictor == nullptr)
   {
     return 1; // invalid arguments error
@@ -177,7 +180,8 @@ unsigned BitAllocator::initAllocMemory (LinearPredictor* const linPredictor, con
   m_rateIndex    = bitRateMode;
   m_tnsPredictor = linPredictor;
 
-  if ((m_tempSfbValue = (uint8_t*) malloc (__max (MAX_PREDICTION_ORDER * sizeof (short), numSwb) * sizeof (uint8_t))) == nullptr)
+  if ((arena == nullptr && m_memArena.allocate (getAllocMemSize (numSwb)) > 0) ||
+      (m_tempSfbValue = (uint8_t*) memArena.take (__max (MAX_PREDICTION_ORDER * sizeof (short), numSwb) * sizeof (uint8_t))) == nullptr)
   {
     return 2; // memory allocation error
   }
@@ -207,6 +211,8 @@ unsigned BitAllocator::initSfbStepSizes (const SfbGroupData* const groupData[USA
   {
     return 1; // invalid arguments error
   }
+  // unused or skipped bands must not depend on prior buffer content, e.g. left-over transform data
+  memset (sfbStepSizes, 0, nChannels * numSwbShort * NUM_WINDOW_GROUPS * sizeof (uint32_t));
 
   for (unsigned ch = 0; ch < nChannels; ch++)
   {
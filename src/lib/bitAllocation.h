@@ -1,5 +1,5 @@
 /* bitAllocation.h - header file for class needed for psychoacoustic bit-allocation
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -30,13 +30,14 @@ private:
   uint8_t  m_rateIndex; // preset
   uint8_t* m_tempSfbValue;
   LinearPredictor* m_tnsPredictor;
+  MemoryArena m_memArena; // owns m_tempSfbValue if no arena was given
 
 public:
 
   // constructor
   BitAllocator ();
   // destructor
-  ~BitAllocator () { MFREE (m_tempSfbValue); }
+  ~BitAllocator () { }
   // public functions
   void getChAverageSpecFlat (uint8_t meanSpecFlatInCh[USAC_MAX_NUM_CHANNELS], const unsigned nChannels);
   void getChAverageTempFlat (uint8_t meanTempFlatInCh[USAC_MAX_NUM_CHANNELS], const unsigned nChannels);
@@ -44,7 +45,9 @@ public:
                              const bool prevEightShorts = false);
   uint8_t       getScaleFac (const uint32_t sfbStepSize, const int32_t* const sfbSignal, const uint8_t sfbWidth,
                              const uint32_t sfbRmsValue);
-  unsigned initAllocMemory  (LinearPredictor* const linPredictor, const uint8_t numSwb, const uint8_t bitRateMode);
+  static size_t getAllocMemSize (const uint8_t numSwb) { return MEM_ALIGN_SIZE (__max (MAX_PREDICTION_ORDER * sizeof (short), numSwb) * sizeof (uint8_t)); }
+  unsigned initAllocMemory  (LinearPredictor* const linPredictor, const uint8_t numSwb, const uint8_t bitRateMode,
+                             MemoryArena* const arena = nullptr);
   unsigned initSfbStepSizes (const SfbGroupData* const groupData[USAC_MAX_NUM_CHANNELS], const uint8_t numSwbShort,
                              const uint32_t specAnaStats[USAC_MAX_NUM_CHANNELS],
                              const uint32_t tempAnaStats[USAC_MAX_NUM_CHANNELS],
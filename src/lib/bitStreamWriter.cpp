@@ -1,5 +1,5 @@
 /* bitStreamWriter.cpp - source file for class with basic bit-stream writing capability
- * written by C. R. Helmrich, last modified in 2023 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -105,13 +105,15 @@ static unsigned getLowRatePreRollAU (uint8_t* const byteBuffer, const CoreCoderD
   }
   else // complete AU with only 1 non-zero MDCT line
   {
+    const uint8_t heldBitCount = ipfAuState[1] & SCHAR_MAX;
+    uint8_t auBuffer[768]; // single-channel AU limit
     OutputStream au;
     unsigned ci = 0;
 
+    au.reset (auBuffer, sizeof (auBuffer));
     byteCount = ((unsigned) ipfAuState[0] << 1) | (ipfAuState[1] >> 7);
     while (ci < byteCount) au.write (byteBuffer[ci++], 8);
-    au.heldBitCount = ipfAuState[1] & SCHAR_MAX;
-    au.heldBitChunk = ipfAuState[2];
+    au.write (ipfAuState[2] >> (8 - heldBitCount), heldBitCount);
 
     if (ipfAuState[3] > 0)
     {
@@ -137,9 +139,9 @@ static unsigned getLowRatePreRollAU (uint8_t* const byteBuffer, const CoreCoderD
 # endif
     }
 
-    if (au.heldBitCount > 0) au.stream.push_back (au.heldBitChunk);
-    byteCount = (unsigned) au.stream.size ();
-    memcpy (byteBuffer, &au.stream.front (), byteCount);
+    au.byteAlign ();
+    byteCount = au.byteCount;
+    memcpy (byteBuffer, auBuffer, __min (byteCount, sizeof (auBuffer)));
   }
 
   return byteCount;
@@ -170,12 +172,7 @@ static uint8_t getOptMsMaskModeValue (const uint8_t* const msUsed, const unsigne
 // private helper functions
 void BitStreamWriter::writeByteAlignment () // write '0' bits until stream is byte-aligned
 {
-  if (m_auBitStream.heldBitCount > 0)
-  {
-    m_auBitStream.stream.push_back (m_auBitStream.heldBitChunk);
-    m_auBitStream.heldBitChunk = 0;
-    m_auBitStream.heldBitCount = 0;
-  }
+  m_auBitStream.byteAlign ();
 }
 
 unsigned BitStreamWriter::writeChannelWiseIcsInfo (const IcsInfo& icsInfo)   // ics_info()
@@ -563,7 +560,9 @@ unsigned BitStreamWriter::writeFDChannelStream (const CoreCoderData& elData, Ent
 #ifndef NO_PREROLL_DATA
       if (ipfAuState && (w == 0))
       {
-        b = (unsigned) m_auBitStream.stream.size ();
+        const uint32_t auBitCount = m_auBitStream.getBitCount ();
+
+        b = auBitCount >> 3; // bytes completed so far
 
         if (eightShorts || (b > 511) || !indepFlag)
         {
@@ -575,8 +574,8 @@ unsigned BitStreamWriter::writeFDChannelStream (const CoreCoderData& elData, Ent
           int32_t sigPk = 0;
 
           ipfAuState[0] = uint8_t (b >> 1);
-          ipfAuState[1] = uint8_t ((b & 1) << 7) | m_auBitStream.heldBitCount;
-          ipfAuState[2] = m_auBitStream.heldBitChunk;
+          ipfAuState[1] = uint8_t ((b & 1) << 7) | (auBitCount & 7);
+          ipfAuState[2] = uint8_t (m_auBitStream.heldBitChunk << (8 - (auBitCount & 7))); // MSB-aligned
           ipfAuState[3] = CLIP_UCHAR (lg >> 2);
 
           for (b = i = 0; i < __min (256u, lg); i++)
@@ -831,7 +830,7 @@ unsigned BitStreamWriter::createAudioConfig (const char samplingFrequencyIndex,
     return 0; // invalid arguments error
   }
 
-  m_auBitStream.reset ();
+  m_auBitStream.reset (audioConfig, 18u + fli); // see auLen
 // --- AudioSpecificConfig(): https://wiki.multimedia.cx/index.php/MPEG-4_Audio/
   m_auBitStream.write (0x7CA, 11); // audio object type (AOT) 32 (esc) + 10 = 42
   if (samplingFrequencyIndex < AAC_NUM_SAMPLE_RATES)
@@ -926,14 +925,13 @@ unsigned BitStreamWriter::createAudioConfig (const char samplingFrequencyIndex,
     if (methodValueBits >= 3) m_auBitStream.write (0, 10 - methodValueBits);
   }
 
-  bitCount += (8 - m_auBitStream.heldBitCount) & 7;
+  bitCount += (8 - (m_auBitStream.getBitCount () & 7)) & 7;
   writeByteAlignment ();  // flush bytes
   auLen = __min (18u + fli, bitCount >> 3);
 #ifndef NO_PREROLL_DATA
   m_usacConfigLen = uint16_t (__max (15, auLen - ucOffset)); // excl ASC payload
-  memcpy (m_usacConfig, &m_auBitStream.stream.at (ucOffset), auLen - ucOffset);
+  memcpy (m_usacConfig, &audioConfig[ucOffset], auLen - ucOffset);
 #endif
-  memcpy (audioConfig,  &m_auBitStream.stream.front (), auLen);
 
   return (bitCount >> 3);  // byte count
 }
@@ -955,7 +953,7 @@ unsigned BitStreamWriter::createAudioFrame (CoreCoderData** const elementData,
 #if !RESTRICT_TO_AAC
   uint8_t* ipfState = (frameCount > 0 && (frameCount % (indepPeriod << 1)) == 0 && numElements == 1 ? m_usacIpfState : nullptr);
 #endif
-  unsigned bitCount = 1, ci = 0;
+  unsigned bitCount = 1, ci = 0, numChannels = 0;
 
   if ((elementData == nullptr) || (entropyCoder == nullptr) || (tempBuffer == nullptr) || (sbrInfoAndData == nullptr) ||
       (mdctSignals == nullptr) || (mdctQuantMag == nullptr) || (accessUnit == nullptr) || (nSamplesInFrame > 2048) ||
@@ -969,16 +967,25 @@ unsigned BitStreamWriter::createAudioFrame (CoreCoderData** const elementData,
   {
     return 0; // invalid arguments error
   }
+  for (unsigned el = 0; el < numElements; el++) // channel count for AU size limit
+  {
+    if (elementData[el] == nullptr) return 0; // internal memory error
+
+    numChannels += (elementData[el]->elementType == ID_USAC_CPE ? 2 : (elementData[el]->elementType >= ID_USAC_SCE &&
+                                                                       elementData[el]->elementType <= ID_USAC_LFE ? 1 : 0));
+  }
 #ifndef NO_PREROLL_DATA
   if (ipf)
   {
     bitCount = ((ipf == 2) || (ipf == 1 && (numElements > 1 || !noiseFilling[0]))
-                ? __min (nSamplesInFrame << 2, (unsigned) m_auBitStream.stream.size ())
-                : ((unsigned) m_usacIpfState[0] << 1) | (m_usacIpfState[1] >> 7));
-    memcpy (tempBuffer, &m_auBitStream.stream.front (), bitCount); // prev fr AU
+                ? __min (nSamplesInFrame << 2, (unsigned) m_ipfPrevAu.size ())
+                : __min (((unsigned) m_usacIpfState[0] << 1) | (m_usacIpfState[1] >> 7), (unsigned) m_ipfPrevAu.size ()));
+    if (bitCount > 0) memcpy (tempBuffer, &m_ipfPrevAu.front (), bitCount); // prev fr AU
   }
+  m_auBitStream.reset (accessUnit, numChannels * (ipf ? 1248 : 768)); // write AU in place
+#else
+  m_auBitStream.reset (accessUnit, numChannels * 768);
 #endif
-  m_auBitStream.reset ();
   m_numSwbShort = numSwbShort;
   m_uCharBuffer = tempBuffer;
   m_auBitStream.write (usacIndependencyFlag ? 1 : 0, 1);
@@ -1031,12 +1038,13 @@ unsigned BitStreamWriter::createAudioFrame (CoreCoderData** const elementData,
         m_auBitStream.write (CORE_MODE_FD, 1);
         m_auBitStream.write (elData->tnsActive ? 1 : 0, 1);  // tns_data_present
         bitCount += 2;
-        bitCount += writeFDChannelStream (*elData, entropyCoder[ci], 0,
-                                          mdctSignals[ci], mdctQuantMag[ci],
+        m_chBitCount[ci] = (uint16_t) writeFDChannelStream (*elData, entropyCoder[ci], 0,
+                                                            mdctSignals[ci], mdctQuantMag[ci],
 #if !RESTRICT_TO_AAC
-                                          tw_mdct[el], noiseFilling[el], ipfState,
+                                                            tw_mdct[el], noiseFilling[el], ipfState,
 #endif
-                                          usacIndependencyFlag);
+                                                            usacIndependencyFlag);
+        bitCount += m_chBitCount[ci];
         if (sbrRatioShiftValue > 0) // UsacSbrData()
         {
           if (usacIndependencyFlag)
@@ -1066,19 +1074,20 @@ unsigned BitStreamWriter::createAudioFrame (CoreCoderData** const elementData,
                                              tw_mdct[el], &elementData[el]->commonTnsData,
 #endif
                                              usacIndependencyFlag);
-        bitCount += writeFDChannelStream (*elData, entropyCoder[ci], 0, // L
-                                          mdctSignals[ci], mdctQuantMag[ci],
+        m_chBitCount[ci] = (uint16_t) writeFDChannelStream (*elData, entropyCoder[ci], 0, // L
+                                                            mdctSignals[ci], mdctQuantMag[ci],
 #if !RESTRICT_TO_AAC
-                                          tw_mdct[el], noiseFilling[el], nullptr,
+                                                            tw_mdct[el], noiseFilling[el], nullptr,
 #endif
-                                          usacIndependencyFlag);
-        ci++;
-        bitCount += writeFDChannelStream (*elData, entropyCoder[ci], 1, // R
-                                          mdctSignals[ci], mdctQuantMag[ci],
+                                                            usacIndependencyFlag);
+        bitCount += m_chBitCount[ci++];
+        m_chBitCount[ci] = (uint16_t) writeFDChannelStream (*elData, entropyCoder[ci], 1, // R
+                                                            mdctSignals[ci], mdctQuantMag[ci],
 #if !RESTRICT_TO_AAC
-                                          tw_mdct[el], noiseFilling[el], ipfState,
+                                                            tw_mdct[el], noiseFilling[el], ipfState,
 #endif
-                                          usacIndependencyFlag);
+                                                            usacIndependencyFlag);
+        bitCount += m_chBitCount[ci];
         if (sbrRatioShiftValue > 0) // UsacSbrData()
         {
           if (usacIndependencyFlag)
@@ -1100,12 +1109,13 @@ unsigned BitStreamWriter::createAudioFrame (CoreCoderData** const elementData,
       }
       case ID_USAC_LFE: // UsacLfeElement()
       {
-        bitCount += writeFDChannelStream (*elData, entropyCoder[ci], 0,
-                                          mdctSignals[ci], mdctQuantMag[ci],
+        m_chBitCount[ci] = (uint16_t) writeFDChannelStream (*elData, entropyCoder[ci], 0,
+                                                            mdctSignals[ci], mdctQuantMag[ci],
 #if !RESTRICT_TO_AAC
-                                          false, false, ipfState,
+                                                            false, false, ipfState,
 #endif
-                                          usacIndependencyFlag);
+                                                            usacIndependencyFlag);
+        bitCount += m_chBitCount[ci];
         ci++;
         break;
       }
@@ -1113,12 +1123,10 @@ unsigned BitStreamWriter::createAudioFrame (CoreCoderData** const elementData,
     }
   } // for el
 
-  bitCount += (8 - m_auBitStream.heldBitCount) & 7;
+  bitCount += (8 - (m_auBitStream.getBitCount () & 7)) & 7;
   writeByteAlignment ();  // flush bytes
 
-#if RESTRICT_TO_AAC || defined (NO_PREROLL_DATA)
-  memcpy (accessUnit, &m_auBitStream.stream.front (), __min (768 * ci, bitCount >> 3));
-#else
+#if !RESTRICT_TO_AAC && !defined (NO_PREROLL_DATA)
   m_auByteCount += bitCount >> 3;
   if (rate != nullptr)  // sampling rate
   {
@@ -1135,7 +1143,10 @@ unsigned BitStreamWriter::createAudioFrame (CoreCoderData** const elementData,
     }
     else *rate = 0; // insufficient data
   }
-  memcpy (accessUnit, &m_auBitStream.stream.front (), __min (ci * (ipf ? 1248 : 768), bitCount >> 3));
+  if ((frameCount % (indepPeriod << 1)) == 0) // next AU is IPF, keep copy of this AU for it
+  {
+    m_ipfPrevAu.assign (accessUnit, accessUnit + __min (m_auBitStream.byteCount, m_auBitStream.byteLimit));
+  }
 #endif
   return (bitCount >> 3);  // byte count
 }
@@ -1,5 +1,5 @@
 /* bitStreamWriter.h - header file for class with basic bit-stream writing capability
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -26,9 +26,11 @@ private:
   // member variables
   OutputStream m_auBitStream; // access unit bit-stream to write
   uint64_t     m_auByteCount;
+  uint16_t     m_chBitCount[USAC_MAX_NUM_CHANNELS]; // stats
   uint8_t      m_numSwbShort; // max. SFB count in short windows
   uint8_t*     m_uCharBuffer; // temporary buffer for ungrouping
 #ifndef NO_PREROLL_DATA
+  std::vector <uint8_t> m_ipfPrevAu; // AU preceding next IPF
   uint8_t      m_usacConfig[20]; // buffer for UsacConfig in IPF
   uint16_t     m_usacConfigLen;
 #endif
@@ -56,14 +58,16 @@ private:
 public:
 
   // constructor
-  BitStreamWriter () { m_auBitStream.reset (); m_auByteCount = m_numSwbShort = 0; m_uCharBuffer = nullptr;
+  BitStreamWriter () { m_auBitStream.reset (nullptr, 0); m_auByteCount = m_numSwbShort = 0; m_uCharBuffer = nullptr;
+                       memset (m_chBitCount, 0, USAC_MAX_NUM_CHANNELS * sizeof (uint16_t));
 #ifndef NO_PREROLL_DATA
                        memset (m_usacConfig, 0, 20); m_usacConfigLen = 0; memset (m_usacIpfState, 0, 4);
 #endif
     }
   // destructor
-  ~BitStreamWriter() { m_auBitStream.reset (); }
+  ~BitStreamWriter() { m_auBitStream.reset (nullptr, 0); }
   // public functions
+  const uint16_t* getChannelBitCounts () const { return m_chBitCount; } // of last AU
   unsigned createAudioConfig (const char samplingFrequencyIndex,  const bool shortFrameLength,
                               const uint8_t chConfigurationIndex, const uint8_t numElements,
                               const ELEM_TYPE* const elementType, const uint32_t loudnessInfo,
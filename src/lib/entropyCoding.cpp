@@ -1,5 +1,5 @@
 /* entropyCoding.cpp - source file for class with lossless entropy coding capability
- * written by C. R. Helmrich, last modified in 2022 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -394,6 +394,15 @@ unsigned EntropyCoder::arithGetContext (const unsigned ctx, const unsigned idx)
   return c;  // updated context ctx
 }
 
+uint8_t EntropyCoder::arithGetPkCache (const unsigned ctx) // arith_get_pk(c) with direct-mapped result cache
+{
+  uint32_t& entry = m_pkCache[(ctx ^ (ctx >> 12)) & (ARITH_PK_CACHE - 1)];
+
+  if ((entry >> 8) != ctx) entry = (ctx << 8) | arithGetPkIndex (ctx); // cache miss, do hash table search
+
+  return entry & UCHAR_MAX; // pki
+}
+
 unsigned EntropyCoder::arithMapContext (const bool arithResetFlag)  // c = arith_map_context(N, arith_reset_flag)
 {
   if (arithResetFlag)
@@ -440,6 +449,7 @@ EntropyCoder::EntropyCoder ()
   // initialize all helper buffers
   m_qcCurr = nullptr;
   m_qcPrev = nullptr;
+  m_pkCache = nullptr;
 
   // initialize encoding variables
   m_acBits = 0;
@@ -455,9 +465,7 @@ EntropyCoder::EntropyCoder ()
 // destructor
 EntropyCoder::~EntropyCoder ()
 {
-  // free allocated helper buffers
-  MFREE (m_qcCurr);
-  MFREE (m_qcPrev);
+  // helper buffers are freed by the arena
 }
 
 // public functions
@@ -498,13 +506,13 @@ unsigned EntropyCoder::arithCodeSigMagn (const uint8_t* const magn, const uint16
     while ((a1 > 3) || (b1 > 3))
     {
       // write escaped codeword value
-      bitCount += arithCodeSymbol (ARITH_ESCAPE, arithCumFreqM[arithGetPkIndex (c | (lev << 17))], stream);
+      bitCount += arithCodeSymbol (ARITH_ESCAPE, arithCumFreqM[arithGetPkCache (c | (lev << 17))], stream);
       // store LSBs in r, right-shift
       r[lev++] = (a1 & 1) | ((b1 & 1) << 1);
       a1 >>= 1; b1 >>= 1;
     }
     // write the m MSB codeword value
-    bitCount += arithCodeSymbol (a1 | (b1 << 2), arithCumFreqM[arithGetPkIndex (c | (lev << 17))], stream);
+    bitCount += arithCodeSymbol (a1 | (b1 << 2), arithCumFreqM[arithGetPkCache (c | (lev << 17))], stream);
 
     // LSB encoding, Table 38, B.25.3
     while (lev--)
@@ -525,8 +533,8 @@ unsigned EntropyCoder::arithCodeSigMagn (const uint8_t* const magn, const uint16
       if (sigEnd < (sigOffset >> 1) + (sigLength >> 1)) // write ARITH_STOP flag to save bits
       {
         c = arithGetContext (c, sigEnd);
-        bitCount += arithCodeSymbol (ARITH_ESCAPE, arithCumFreqM[arithGetPkIndex (c)], stream);
-        bitCount += arithCodeSymbol (0 /*m=STOP*/, arithCumFreqM[arithGetPkIndex (c | (1 << 17))], stream);
+        bitCount += arithCodeSymbol (ARITH_ESCAPE, arithCumFreqM[arithGetPkCache (c)], stream);
+        bitCount += arithCodeSymbol (0 /*m=STOP*/, arithCumFreqM[arithGetPkCache (c | (1 << 17))], stream);
       }
       bitCount += writeSymbol (stream, m_acLow > (SHRT_MAX >> 1), m_acBits + 1);
     }
@@ -572,13 +580,13 @@ unsigned EntropyCoder::arithCodeSigTest (const uint8_t* const magn, const uint16
     while ((a1 > 3) || (b1 > 3))
     {
       // write escaped codeword value
-      bitCount += arithCodeSymbol (ARITH_ESCAPE, arithCumFreqM[arithGetPkIndex (c | (lev << 17))]);
+      bitCount += arithCodeSymbol (ARITH_ESCAPE, arithCumFreqM[arithGetPkCache (c | (lev << 17))]);
       // store LSBs in r, right-shift
       r[lev++] = (a1 & 1) | ((b1 & 1) << 1);
       a1 >>= 1; b1 >>= 1;
     }
     // write the m MSB codeword value
-    bitCount += arithCodeSymbol (a1 | (b1 << 2), arithCumFreqM[arithGetPkIndex (c | (lev << 17))]);
+    bitCount += arithCodeSymbol (a1 | (b1 << 2), arithCumFreqM[arithGetPkCache (c | (lev << 17))]);
 
     // LSB encoding, Table 38, B.25.3
     while (lev--)
@@ -619,13 +627,13 @@ unsigned EntropyCoder::arithCodeTupTest (const uint8_t* const magn, const uint16
   while ((a1 > 3) || (b1 > 3))
   {
     // write escaped codeword value
-    bitCount += arithCodeSymbol (ARITH_ESCAPE, arithCumFreqM[arithGetPkIndex (c | (lev << 17))]);
+    bitCount += arithCodeSymbol (ARITH_ESCAPE, arithCumFreqM[arithGetPkCache (c | (lev << 17))]);
     // store LSBs in r, right-shift
     r[lev++] = (a1 & 1) | ((b1 & 1) << 1);
     a1 >>= 1; b1 >>= 1;
   }
   // write the m MSB codeword value
-  bitCount += arithCodeSymbol (a1 | (b1 << 2), arithCumFreqM[arithGetPkIndex (c | (lev << 17))]);
+  bitCount += arithCodeSymbol (a1 | (b1 << 2), arithCumFreqM[arithGetPkCache (c | (lev << 17))]);
 
   // LSB encoding, Table 38, B.25.3
   while (lev--)
@@ -676,9 +684,18 @@ unsigned EntropyCoder::indexGetHuffCode (const int scaleFactorDelta) const
   return huffScf[CLIP_PM (scaleFactorDelta, INDEX_OFFSET) + INDEX_OFFSET] >> 8;
 }
 
-unsigned EntropyCoder::initCodingMemory (const unsigned maxTransfLength)
+size_t EntropyCoder::getCodingMemSize (const unsigned maxTransfLength)
+{
+  const unsigned max2TupleLength = maxTransfLength >> 1;
+
+  return MEM_ALIGN_SIZE (max2TupleLength * sizeof (uint8_t)) + MEM_ALIGN_SIZE ((max2TupleLength + 1) * sizeof (uint8_t)) +
+         MEM_ALIGN_SIZE (ARITH_PK_CACHE * sizeof (uint32_t));
+}
+
+unsigned EntropyCoder::initCodingMemory (const unsigned maxTransfLength, MemoryArena* const arena /*= nullptr*/)
 {
   const unsigned max2TupleLength = maxTransfLength >> 1; // tuple buffer size, maxWinLength/4
+  MemoryArena& memArena = (arena != nullptr ? *arena : m_memArena);
 
   if ((maxTransfLength < 128) || (maxTransfLength > 8192) || (maxTransfLength & 7))
   {
@@ -686,16 +703,17 @@ unsigned EntropyCoder::initCodingMemory (const unsigned maxTransfLength)
   }
 
   m_maxTupleLength = max2TupleLength;
-  MFREE (m_qcCurr);
-  MFREE (m_qcPrev);
 
-  if ((m_qcCurr = (uint8_t*) malloc (max2TupleLength * sizeof (uint8_t))) == nullptr ||
-      (m_qcPrev = (uint8_t*) malloc ((max2TupleLength + 1) * sizeof (uint8_t))) == nullptr)
+  if ((arena == nullptr && m_memArena.allocate (getCodingMemSize (maxTransfLength)) > 0) ||
+      (m_qcCurr = (uint8_t*) memArena.take (max2TupleLength * sizeof (uint8_t))) == nullptr ||
+      (m_qcPrev = (uint8_t*) memArena.take ((max2TupleLength + 1) * sizeof (uint8_t))) == nullptr ||
+      (m_pkCache = (uint32_t*) memArena.take (ARITH_PK_CACHE * sizeof (uint32_t))) == nullptr)
   {
     return 2; // memory allocation error
   }
 
   memset (m_qcCurr, 0, max2TupleLength * sizeof (uint8_t));
+  memset (m_pkCache, UCHAR_MAX, ARITH_PK_CACHE * sizeof (uint32_t)); // invalid contexts
 
   return 0; // no error
 }
@@ -1,5 +1,5 @@
 /* entropyCoding.h - header file for class with lossless entropy coding capability
- * written by C. R. Helmrich, last modified in 2022 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -15,6 +15,7 @@
 
 // constants, experimental macro
 #define ARITH_ESCAPE          16
+#define ARITH_PK_CACHE      4096 // 2^x
 #define ARITH_SIZE           742
 #define INDEX_OFFSET          60
 #define INDEX_SIZE           121
@@ -28,6 +29,8 @@ private:
   // member variables
   uint8_t* m_qcCurr;         // curr. window's quantized context q[1]
   uint8_t* m_qcPrev;         // prev. window's quantized context q[0]
+  uint32_t* m_pkCache;       // context-keyed cache of arith_get_pk()
+  MemoryArena m_memArena;    // owns the above if no arena was given
 
   uint16_t m_acBits;         // bits_to_follow in arith_encode, 0..31
   uint16_t m_acHigh;         // high in arith_encode as in Annex B.25
@@ -41,6 +44,7 @@ private:
   // helper functions
   unsigned arithCodeSymbol (const uint16_t symbol, const uint16_t* table, OutputStream* const stream = nullptr);
   unsigned arithGetContext (const unsigned ctx, const unsigned idx);
+  uint8_t  arithGetPkCache (const unsigned ctx);
   unsigned arithMapContext (const bool arithResetFlag);
 #if EC_TRELLIS_OPT_CODING
   void     arithSetContext (const unsigned newCtxState, const uint16_t sigEnd);
@@ -73,7 +77,8 @@ public:
   unsigned indexGetBitCount (const int scaleFactorDelta) const;
   unsigned indexGetHuffCode (const int scaleFactorDelta) const;
 
-  unsigned initCodingMemory (const unsigned maxTransfLength);
+  static size_t getCodingMemSize (const unsigned maxTransfLength); // for a caller-owned MemoryArena
+  unsigned initCodingMemory (const unsigned maxTransfLength, MemoryArena* const arena = nullptr);
   unsigned initWindowCoding (const bool forceArithReset, const bool shortWin = false);
 
   bool     getIsShortWindow () const                     { return m_shortTrafoCurr; }
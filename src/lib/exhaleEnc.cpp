@@ -1,5 +1,5 @@
 /* exhaleEnc.cpp - source file for class providing Extended HE-AAC encoding capability
- * written by C. R. Helmrich, last modified in 2023 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  * C API corrected and API compilation extended by J. Regan in 2022, see merge request 8
  *
  * The copyright in this software is being made available under the exhale Copyright License
@@ -11,73 +11,125 @@
 
 #include "exhaleLibPch.h"
 #include "exhaleEnc.h"
+#include "polyphaseResampler.h"
+#if EE_INPUT_AVX2
+# include <immintrin.h>
+#endif
 
 // static helper functions
-static double modifiedBesselFunctionOfFirstKind (const double x)
+static void convertToInt24Scalar (const void* const pcmData, const ExhalePcmFormat pcmFormat, const unsigned inputFlags,
+                                  int32_t* const int24Data, const unsigned firstSample, const unsigned numSamples,
+                                  uint32_t* const ditherSeed)
 {
-  const double xOver2 = x * 0.5;
-  double d = 1.0, sum = 1.0;
-  int    i = 0;
+  unsigned s;
+
+  if (pcmFormat == EXHALE_PCM_S16)
+  {
+    const int16_t* i16 = (const int16_t*) pcmData;
 
-  do
+    for (s = firstSample; s < numSamples; s++) int24Data[s] = (int32_t) i16[s] * (1 << 8);
+  }
+  else
+  if (pcmFormat == EXHALE_PCM_S24)
   {
-    const double x2di = xOver2 / double (++i);
+    const int32_t* i32 = (const int32_t*) pcmData;
 
-    d *= (x2di * x2di);
-    sum += d;
+    if (inputFlags & EXHALE_INPUT_CLIP)
+    {
+      for (s = firstSample; s < numSamples; s++) int24Data[s] = __max (-8388608, __min (8388607, i32[s]));
+    }
+    else memcpy (&int24Data[firstSample], &i32[firstSample], (numSamples - firstSample) * sizeof (int32_t));
   }
-  while (d > sum * 1.2e-38); // FLT_MIN
+  else // EXHALE_PCM_F32
+  {
+    const float* f32 = (const float*) pcmData;
+    const bool addDither = (inputFlags & EXHALE_INPUT_DITHER) != 0;
+
+    for (s = firstSample; s < numSamples; s++)
+    {
+      float f = f32[s] * float (1 << 23); // * 2^23
+
+      if (addDither) // TPDF via two draws of a linear congruential generator per lane
+      {
+        uint32_t& seed = ditherSeed[s & 7];
+        const uint32_t r1 = (seed = seed * 1664525u + 1013904223u) >> 16;
+        const uint32_t r2 = (seed = seed * 1664525u + 1013904223u) >> 16;
 
-  return sum;
+        f += float (int32_t (r1 + r2) - 65535) * (1.0f / 65536.0f);
+      }
+      int24Data[s] = (f >= 8388607.0f ? 8388607 : (f <= -8388608.0f ? -8388608 : int32_t (f + (f < 0.0f ? -0.5f : 0.5f))));
+    }
+  }
 }
 
-static int32_t* initWindowHalfCoeffs (const USAC_WSHP windowShape, const unsigned frameLength)
+#if EE_INPUT_AVX2
+static TARGET_AVX2 void convertToInt24AVX2 (const void* const pcmData, const ExhalePcmFormat pcmFormat, const unsigned inputFlags,
+                                            int32_t* const int24Data, const unsigned numSamples, uint32_t* const ditherSeed)
 {
-  int32_t* windowBuf = nullptr;
-  unsigned u;
+  // bit-exact 8-way version of convertToInt24Scalar (), one dither generator lane per vector lane
+  const unsigned numSimd = numSamples & ~7u;
+  unsigned s;
 
-  if ((windowBuf = (int32_t*) malloc (frameLength * sizeof (int32_t))) == nullptr)
+  if (pcmFormat == EXHALE_PCM_S16)
   {
-    return nullptr; // allocation error
-  }
+    const int16_t* i16 = (const int16_t*) pcmData;
 
-  if (windowShape == WINDOW_SINE)
-  {
-    const double dNorm = 3.141592653589793 / (2.0 * frameLength);
-    // MLT sine window half
-    for (u = 0; u < frameLength; u++)
+    for (s = 0; s < numSimd; s += 8)
     {
-      windowBuf[u] = int32_t (sin (dNorm * (u + 0.5)) * WIN_SCALE + 0.5);
+      const __m256i i = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i*) &i16[s]));
+
+      _mm256_storeu_si256 ((__m256i*) &int24Data[s], _mm256_slli_epi32 (i, 8));
     }
   }
-  else  // if windowShape == WINDOW_KBD
+  else
+  if (pcmFormat == EXHALE_PCM_S24)
   {
-    const double alpha = 3.141592653589793 * (frameLength > 256 ? 4.0 : 6.0);
-    const double dBeta = 1.0 / modifiedBesselFunctionOfFirstKind (alpha /*sqrt (1.0)*/);
-    const double dNorm = 4.0 / (2.0 * frameLength);
-    const double iScal = double (1u << 30);
-    const double dScal = 1.0 / iScal;
-    double d, sum = 0.0;
-    // create Kaiser-Bessel window half
-    for (u = 0; u < frameLength; u++)
+    const int32_t* i32 = (const int32_t*) pcmData;
+
+    if ((inputFlags & EXHALE_INPUT_CLIP) == 0)
+    {
+      memcpy (int24Data, i32, numSamples * sizeof (int32_t));
+      return;
+    }
+    for (s = 0; s < numSimd; s += 8)
     {
-      const double du1 = dNorm * u - 1.0;
+      const __m256i i = _mm256_loadu_si256 ((const __m256i*) &i32[s]);
 
-      d = dBeta * modifiedBesselFunctionOfFirstKind (alpha * sqrt (1.0 - du1 * du1));
-      sum += d;
-      windowBuf[u] = int32_t (d * iScal + 0.5);
+      _mm256_storeu_si256 ((__m256i*) &int24Data[s], _mm256_max_epi32 (_mm256_set1_epi32 (-8388608), _mm256_min_epi32 (_mm256_set1_epi32 (8388607), i)));
     }
-    d = 1.0 / sum; // normalized to sum
-    sum = 0.0;
-    // KBD window half
-    for (u = 0; u < frameLength; u++)
+  }
+  else // EXHALE_PCM_F32
+  {
+    const float* f32 = (const float*) pcmData;
+    const bool addDither = (inputFlags & EXHALE_INPUT_DITHER) != 0;
+    const __m256  signMask = _mm256_set1_ps (-0.0f);
+    __m256i seed = _mm256_loadu_si256 ((const __m256i*) ditherSeed);
+
+    for (s = 0; s < numSimd; s += 8)
     {
-      sum += dScal * windowBuf[u];
-      windowBuf[u] = int32_t (sqrt (d * sum /*cumulative sum*/) * WIN_SCALE + 0.5);
+      __m256 f = _mm256_mul_ps (_mm256_loadu_ps (&f32[s]), _mm256_set1_ps (float (1 << 23)));
+
+      if (addDither)
+      {
+        __m256i r1, r2;
+
+        seed = _mm256_add_epi32 (_mm256_mullo_epi32 (seed, _mm256_set1_epi32 (1664525)), _mm256_set1_epi32 (1013904223));
+        r1   = _mm256_srli_epi32 (seed, 16);
+        seed = _mm256_add_epi32 (_mm256_mullo_epi32 (seed, _mm256_set1_epi32 (1664525)), _mm256_set1_epi32 (1013904223));
+        r2   = _mm256_srli_epi32 (seed, 16);
+        r1   = _mm256_sub_epi32 (_mm256_add_epi32 (r1, r2), _mm256_set1_epi32 (65535));
+        f    = _mm256_add_ps (f, _mm256_mul_ps (_mm256_cvtepi32_ps (r1), _mm256_set1_ps (1.0f / 65536.0f)));
+      }
+      f = _mm256_max_ps (_mm256_min_ps (f, _mm256_set1_ps (8388607.0f)), _mm256_set1_ps (-8388608.0f));
+      f = _mm256_add_ps (f, _mm256_or_ps (_mm256_and_ps (f, signMask), _mm256_set1_ps (0.5f))); // round half away from zero
+
+      _mm256_storeu_si256 ((__m256i*) &int24Data[s], _mm256_cvttps_epi32 (f));
     }
+    _mm256_storeu_si256 ((__m256i*) ditherSeed, seed);
   }
-  return windowBuf;
+  convertToInt24Scalar (pcmData, pcmFormat, inputFlags, int24Data, numSimd, numSamples, ditherSeed); // remainder
 }
+#endif // EE_INPUT_AVX2
 
 static uint32_t quantizeSfbWithMinSnr (const unsigned* const coeffMagn, const uint16_t* const sfbOffset, const unsigned b,
                                        const uint8_t groupLength, uint8_t* const quantMagn, char* const arithTuples, const bool nonZeroSnr = false)
@@ -489,6 +541,22 @@ static const USAC_WSEQ windowSequenceSynch[5][5] = {  // 1st: chan index 0, 2nd:
 };
 
 // private helper functions
+void ExhaleEncoder::applyComplexity ()
+{
+#if EC_TRELLIS_OPT_CODING
+  uint8_t numSfbStates = m_rdocStates[0], numTupleStates = m_rdocStates[1];
+
+  if (m_cplxLevel >= 1) numTupleStates = (numTupleStates > 0 ? __min (2, numTupleStates) : 2);
+  if (m_cplxLevel >= 2) numSfbStates = 2;
+  if (m_cplxLevel >= 3) numTupleStates = 1;
+
+  for (unsigned el = 0; el < USAC_MAX_NUM_ELEMENTS; el++) // also workers' quantizers
+  {
+    m_sfbQuantizer[el].setNumRdocStates (numSfbStates, numTupleStates);
+  }
+#endif
+}
+
 unsigned ExhaleEncoder::applyTnsToWinGroup (SfbGroupData& grpData, const uint8_t grpIndex, const uint8_t maxSfb, TnsData& tnsData,
                                             const unsigned channelIndex, const unsigned n, const bool realOnlyCalc)
 {
@@ -630,6 +698,405 @@ unsigned ExhaleEncoder::eightShortGrouping (SfbGroupData& grpData, uint16_t* con
   return 0; // no error
 }
 
+unsigned ExhaleEncoder::elementQuantCoding (const unsigned el) // MDCT quantization of one element
+{
+  const unsigned nSamplesInFrame  = toFrameLength (m_frameLength);
+  const unsigned samplingRate     = toSamplingRate (m_frequencyIdx);
+  const unsigned nSamplesTempAna  = (nSamplesInFrame * 25) >> 4; // pre-delay for look-ahead
+#if !EE_MORE_MSE
+  const bool     useMaxBandwidth  = (samplingRate < 37566 || m_shiftValSBR > 0);
+#endif
+  const unsigned ei = (m_workerPool.getNumWorkers () > 0 ? el : 0); // index of el. helpers
+  SfbQuantizer&  sfbQuantizer     = m_sfbQuantizer[ei];
+#if !RESTRICT_TO_AAC
+  SpecGapFiller& specGapFiller    = m_specGapFiller[ei];
+#endif
+  char* const    tempBuffer       = (char*) m_elemTempBuf[ei];
+  const unsigned* const coeffMagn = sfbQuantizer.getCoeffMagnPtr ();
+  unsigned ci = 0, s; // running index
+  unsigned errorValue = (coeffMagn == nullptr ? 1 : 0);
+
+  for (s = 0; s < el; s++) ci += (m_elementData[s]->elementType & 1) + 1; // first channel
+
+  CoreCoderData& coreConfig = *m_elementData[el];
+  const unsigned nrChannels = (coreConfig.elementType & 1) + 1; // for UsacCoreCoderData()
+
+  if ((coreConfig.elementType < ID_USAC_LFE) && (coreConfig.stereoMode > 0)) // synch SFMs
+  {
+    m_meanSpecCurr[ci] = m_meanSpecCurr[ci + 1] = ((uint16_t) m_meanSpecCurr[ci] + (uint16_t) m_meanSpecCurr[ci + 1]) >> 1;
+    m_meanTempCurr[ci] = m_meanTempCurr[ci + 1] = ((uint16_t) m_meanTempCurr[ci] + (uint16_t) m_meanTempCurr[ci + 1]) >> 1;
+  }
+
+  for (unsigned ch = 0; ch < nrChannels; ch++)   // channel loop
+  {
+    EntropyCoder& entrCoder = m_entropyCoder[ci];
+    SfbGroupData&   grpData = coreConfig.groupingData[ch];
+    const bool shortWinCurr = (coreConfig.icsInfoCurr[ch].windowSequence == EIGHT_SHORT);
+    const bool shortWinPrev = (coreConfig.icsInfoPrev[ch].windowSequence == EIGHT_SHORT);
+    char* const arithTuples = entrCoder.arithGetTuplePtr ();
+    uint8_t sfIdxPred = UCHAR_MAX;
+
+    if ((errorValue > 0) || (arithTuples == nullptr))
+    {
+      return 1; // an internal error
+    }
+
+    // back up entropy coder memory for use by bit-stream writer
+    memcpy (tempBuffer, arithTuples, (nSamplesInFrame >> 1) * sizeof (char));
+    errorValue |= (entrCoder.getIsShortWindow () != shortWinPrev ? 1 : 0); // sanity check
+
+    memset (m_mdctQuantMag[ci], 0, nSamplesInFrame * sizeof (uint8_t));  // initialization
+    m_rdocPasses[ci] = 0;
+
+    for (uint16_t gr = 0; gr < grpData.numWindowGroups; gr++)
+    {
+      const uint8_t grpLength = grpData.windowGroupLength[gr];
+      const uint16_t*  grpOff = &grpData.sfbOffsets[m_numSwbShort * gr];
+      uint32_t* const  grpRms = &grpData.sfbRmsValues[m_numSwbShort * gr]; // coding stats
+      uint8_t*   grpScaleFacs = &grpData.scaleFactors[m_numSwbShort * gr];
+      uint32_t estimBitCount = 0;
+      unsigned lastSfb = 0, lastSOff = 0;
+
+      errorValue |= entrCoder.initWindowCoding (m_indepFlag && (gr == 0), shortWinCurr);
+      s = 0;
+
+      for (uint16_t b = 0; b < grpData.sfbsPerGroup; b++)
+      {
+        // partial SFB ungrouping for entropy coding setup below
+        const uint16_t swbSize = ((grpOff[b + 1] - grpOff[b]) * oneTwentyEightOver[grpLength]) >> 7; // sfbWidth / grpLength
+        uint8_t* const swbMagn = &m_mdctQuantMag[ci][grpOff[b + 1] - swbSize];
+
+        grpScaleFacs[b] = sfbQuantizer.quantizeSpecSfb (entrCoder, m_mdctSignals[ci], grpLength, grpOff, grpRms,
+                                                        b, grpScaleFacs[b], sfIdxPred, m_mdctQuantMag[ci]);
+        if ((b > 0) && (grpScaleFacs[b] < UCHAR_MAX) && (sfIdxPred == UCHAR_MAX))
+        {
+          // back-propagate first nonzero-SFB scale factor index
+          memset (grpScaleFacs, grpScaleFacs[b], b * sizeof (uint8_t));
+        }
+        sfIdxPred = grpScaleFacs[b];
+
+        // correct previous scale factor if the delta exceeds 60
+        if ((b > 0) && (grpScaleFacs[b] > grpScaleFacs[b - 1] + INDEX_OFFSET))
+        {
+          const uint16_t sfbM1Start = grpOff[b - 1];
+          const uint16_t sfbM1Width = grpOff[b] - sfbM1Start;
+          const uint16_t swbM1Size  = (sfbM1Width * oneTwentyEightOver[grpLength]) >> 7; // sfbM1Width / grpLength
+
+          grpScaleFacs[b - 1] = grpScaleFacs[b] - (b > 1 ? INDEX_OFFSET : 0);  // zero-out
+          memset (&m_mdctQuantMag[ci][sfbM1Start], 0, sfbM1Width * sizeof (uint8_t));
+
+          // correct SFB statistics with some bit count estimate
+          grpRms[b - 1] = 1 + (sfbM1Width >> 3) + entrCoder.indexGetBitCount (b > 1 ? (int) grpScaleFacs[b - 1] - grpScaleFacs[b - 2] : 0);
+          // correct entropy coding 2-tuples for the next window
+          memset (&arithTuples[lastSOff], 1, (swbM1Size >> 1) * sizeof (char));
+        }
+        // correct next scale factor if the reduction exceeds 60
+        if ((b + 2u < grpData.sfbsPerGroup) && (sfIdxPred < UCHAR_MAX) && (grpScaleFacs[b + 1]) &&
+            (sfIdxPred > grpScaleFacs[b + 1] + INDEX_OFFSET))
+        {
+          grpScaleFacs[b + 1] = grpScaleFacs[b] - INDEX_OFFSET; // avoid preset-9 zero-out
+        }
+
+        if (b > 0)
+        {
+          if ((grpRms[b - 1] >> 16) > 0) lastSfb = b - 1;
+          estimBitCount += grpRms[b - 1] & USHRT_MAX;
+        }
+        // set up entropy coding 2-tuples for next SFB or window
+        lastSOff = s;
+        for (uint16_t c = 0; c < swbSize; c += 2)
+        {
+          arithTuples[s++] = __min (0xF, swbMagn[c] + swbMagn[c + 1] + 1); // 23003-3, 7.4
+        }
+      } // for b
+
+      if (grpData.sfbsPerGroup > 0) // rate control part 2 to reach constrained VBR (CVBR)
+      {
+#if EE_MORE_MSE
+        const unsigned targetBitCount25 = INT32_MAX;
+#else
+        const uint8_t maxSfbLong  = (useMaxBandwidth ? 54 - (samplingRate >> 13) : brModeAndFsToMaxSfbLong (m_bitRateMode, samplingRate));
+        const uint8_t maxSfbShort = (useMaxBandwidth ? 19 - (samplingRate >> 13) : brModeAndFsToMaxSfbShort(m_bitRateMode, samplingRate));
+        const uint16_t peakIndex  = (shortWinCurr ? 0 : (m_specAnaCurr[ci] >> 5) & 2047);
+        const unsigned sfmBasedSfbStart = (shortWinCurr ? maxSfbShort - 2 + (m_meanSpecCurr[ci] >> 6) : maxSfbLong  - 6 + (m_meanSpecCurr[ci] >> 5)) +
+                                          (shortWinCurr ? -3 + (((1 << 5) + m_meanTempCurr[ci]) >> 6) : -7 + (((1 << 4) + m_meanTempCurr[ci]) >> 5));
+        const unsigned targetBitCount25 = ((60000 + 20000 * ((m_bitRateMode + m_shiftValSBR) >> (m_frameCount <= 1 ? 2 : 0))) * nSamplesInFrame) /
+                                          (samplingRate * ((grpData.numWindowGroups + 1) >> 1));
+#endif
+        unsigned b = grpData.sfbsPerGroup - 1;
+
+        if ((grpRms[b] >> 16) > 0) lastSfb = b;
+        estimBitCount += grpRms[b] & USHRT_MAX;
+
+#if EC_TRELLIS_OPT_CODING
+        if (grpLength == 1) // finalize bit count estimate, RDOC
+        {
+          estimBitCount = sfbQuantizer.quantizeSpecRDOC (entrCoder, grpScaleFacs, estimBitCount + 2u,
+                                                         grpOff, grpRms, grpData.sfbsPerGroup, m_mdctQuantMag[ci]);
+          m_rdocPasses[ci]++;
+          for (b = 1; b < grpData.sfbsPerGroup; b++)
+          {
+            // correct previous scale factor if delta exceeds 60
+            if (grpScaleFacs[b] > grpScaleFacs[b - 1] + INDEX_OFFSET)
+            {
+              const uint16_t sfbM1Start = grpOff[b - 1];
+              const uint16_t sfbM1Width = grpOff[b] - sfbM1Start;
+
+              grpScaleFacs[b - 1] = grpScaleFacs[b] - (b > 1 ? INDEX_OFFSET : 0); // 0-out
+              memset (&m_mdctQuantMag[ci][sfbM1Start], 0, sfbM1Width * sizeof (uint8_t));
+
+              // correct statistics with some bit count estimate
+              grpRms[b - 1] = 1 + (sfbM1Width >> 3) + entrCoder.indexGetBitCount (b > 1 ? (int) grpScaleFacs[b - 1] - grpScaleFacs[b - 2] : 0);
+              // correct entropy coding 2-tuples for next window
+              memset (&arithTuples[(sfbM1Start - grpOff[0]) >> 1], 1, (sfbM1Width >> 1) * sizeof (char));
+            }
+          }
+        }
+#endif
+#if EE_MORE_MSE
+        b = lastSfb;
+#else
+        // coarse-quantize near-Nyquist SFB with SBR @ 48-64 kHz
+        b = 40 + (samplingRate >> 12);
+        if ((m_shiftValSBR == 0) || (samplingRate < 23004) || shortWinCurr || (b > lastSfb)) b = lastSfb;
+
+        while ((b >= sfmBasedSfbStart + (m_bitRateMode >> 1) + (m_bitRateMode / 5)) && (grpOff[b] > peakIndex) && ((grpRms[b] >> 16) <= 1) &&
+               ((estimBitCount * 5 > targetBitCount25 * 2) || (grpLength > 1 /*no accurate bit count estim. available for grouped spectrum*/)))
+        {
+          b--; // search first coarsely quantized high-freq. SFB
+        }
+#endif
+        lastSOff = b;
+
+        for (b++; b <= lastSfb; b++)
+        {
+          if ((grpRms[b] >> 16) > 0) // re-quantize nonzero band
+          {
+#if RESTRICT_TO_AAC
+            uint32_t maxVal = 1;
+#else
+            uint32_t maxVal = (shortWinCurr || !m_noiseFilling[el] ? 1 : (m_specAnaCurr[ci] >> 23) & 1); // 1 or 0
+#endif
+            estimBitCount -= grpRms[b] & USHRT_MAX;
+            grpRms[b] = (maxVal << 16) + maxVal; // bit estimate
+            maxVal = quantizeSfbWithMinSnr (coeffMagn, grpOff, b, grpLength, m_mdctQuantMag[ci], arithTuples, maxVal > 0);
+
+            grpScaleFacs[b] = __min (SCHAR_MAX, sfbQuantizer.getScaleFacOffset ((double) maxVal));
+
+            // correct SFB statistics with estimate of bit count
+            grpRms[b] += 3 + entrCoder.indexGetBitCount ((int) grpScaleFacs[b] - grpScaleFacs[b - 1]);
+            estimBitCount += grpRms[b] & USHRT_MAX;
+          }
+          else // re-repeat scale factor for zero quantized band
+          {
+            grpScaleFacs[b] = grpScaleFacs[b - 1];
+          }
+        }
+
+        if (estimBitCount > targetBitCount25) // too many bits!!
+        {
+          for (b = lastSOff; b > 0; b--)
+          {
+            if ((grpRms[b] >> 16) > 0) // emergency re-quantizer
+            {
+#if RESTRICT_TO_AAC
+              uint32_t maxVal = 1;
+#else
+              uint32_t maxVal = (shortWinCurr || !m_noiseFilling[el] ? 1 : (m_specAnaCurr[ci] >> 23) & 1); // 1 or 0
+#endif
+              estimBitCount -= grpRms[b] & USHRT_MAX;
+              grpRms[b] = (maxVal << 16) + maxVal; // bit estim.
+              maxVal = quantizeSfbWithMinSnr (coeffMagn, grpOff, b, grpLength, m_mdctQuantMag[ci], arithTuples, maxVal > 0);
+
+              grpScaleFacs[b] = __min (SCHAR_MAX, sfbQuantizer.getScaleFacOffset ((double) maxVal));
+
+              // correct SFB statistics with estimated bit count
+              grpRms[b] += 3 + entrCoder.indexGetBitCount ((int) grpScaleFacs[b] - grpScaleFacs[b - 1]);
+              estimBitCount += grpRms[b] & USHRT_MAX;
+            }
+            if (estimBitCount <= targetBitCount25) break;
+          }
+
+          for (b++; b <= lastSfb; b++) // re-repeat scale factor
+          {
+            if ((grpRms[b] >> 16) == 0) // a zero quantized band
+            {
+              grpScaleFacs[b] = grpScaleFacs[b - 1];
+            }
+          }
+        } // if estimBitCount > targetBitCount25
+
+        for (b = lastSfb + 1; b < grpData.sfbsPerGroup; b++)
+        {
+          if ((grpRms[b] >> 16) == 0) // HF zero quantized bands
+          {
+            grpScaleFacs[b] = grpScaleFacs[b - 1];
+          }
+        }
+
+        if ((grpScaleFacs[0] == UCHAR_MAX) &&
+#if !RESTRICT_TO_AAC
+            !m_noiseFilling[el] &&
+#endif
+            (lastSfb == 0))  // ensure all scale factors are set
+        {
+          memset (grpScaleFacs, (gr == 1 ? grpData.scaleFactors[grpData.sfbsPerGroup - 1] : 0), grpData.sfbsPerGroup * sizeof (uint8_t));
+        }
+      }
+    } // for gr
+
+    // restore entropy coder memory for use by bit-stream writer
+    memcpy (arithTuples, tempBuffer, (nSamplesInFrame >> 1) * sizeof (char));
+    entrCoder.setIsShortWindow (shortWinPrev);
+#if !RESTRICT_TO_AAC
+    s = 22050 + 7350 * m_bitRateMode; // compute channel-wise noise_level and noise_offset
+    sfIdxPred = ((m_bitRateMode == 0) && (m_priLength) && (m_shiftValSBR) && ((m_tempAnaCurr[ci] >> 24) || (m_tempAnaNext[ci] >> 24)) && (m_meanSpecCurr[ci] +
+                  __min ((m_tempAnaCurr[ci] >> 16) & UCHAR_MAX, (m_tempAnaNext[ci] >> 16) & UCHAR_MAX) >= 192) ? UCHAR_MAX : m_meanSpecCurr[ci]);
+    coreConfig.specFillData[ch] = (!m_noiseFilling[el] ? 0 : specGapFiller.getSpecGapFillParams (sfbQuantizer, m_mdctQuantMag[ci], m_numSwbShort,
+                                                                                                 grpData, nSamplesInFrame, samplingRate, s,
+                                                                                                 shortWinCurr ? 0 : sfIdxPred));
+    if (coreConfig.specFillData[ch] == 1) errorValue |= 1;
+#endif
+    s = ci + nrChannels - 1 - 2 * ch; // other channel in stereo
+    if ((coreConfig.elementType < ID_USAC_LFE) && (m_shiftValSBR > 0)) // collect SBR data
+    {
+      const uint8_t msfVal = (shortWinPrev ? 31 : __max (2, __max (m_meanSpecPrev[ci], m_meanSpecCurr[ci]) >> 3));
+      const uint8_t msfSte = (coreConfig.stereoMode == 0 ? 0 : (coreConfig.icsInfoPrev[s + ch - ci].windowSequence ==
+                               EIGHT_SHORT ? 31 : __max (2, __max (m_meanSpecPrev[s ], m_meanSpecCurr[s ]) >> 3)));
+      int32_t  tmpValSynch = 0;
+
+      memset (m_coreSignals[ci], 0, 10 * sizeof (int32_t));
+#if ENABLE_INTERTES
+      m_coreSignals[ci][0] = 0x40000000; // bs_interTes = 1 for all frames
+#endif
+      m_coreSignals[ci][0] |= 4 - int32_t (sqrt (0.75 * msfVal)); // filter mode, 0 = none
+
+      if (ch > 0 && coreConfig.stereoMode > 0) // synch. sbr_grid(), sbr_invf() for stereo
+      {
+        tmpValSynch = (m_coreSignals[s][0] >> 21) & 3; // nEnv, bits 23-22
+        m_coreSignals[ci][0] |= m_coreSignals[s][0] & 0x10000F; // bits 21
+        m_coreSignals[s][0] |= m_coreSignals[ci][0] & 0x10000F; // and 4-1
+      }
+      m_coreSignals[ci][0] |= getSbrEnvelopeAndNoise (&m_coreSignals[ci][nSamplesTempAna - 64 + nSamplesInFrame], msfVal,
+                                                      __max (m_meanTempPrev[ci], m_meanTempCurr[ci]) >> 3, m_bitRateMode == 0,
+                                                      m_indepFlag, msfSte, tmpValSynch, nSamplesInFrame, &m_coreSignals[ci][1]);
+      if (ch + 1 == nrChannels) // update the flatness histories
+      {
+        m_meanSpecPrev[ci] = m_meanSpecCurr[ci];  m_meanSpecPrev[s] = m_meanSpecCurr[s];
+        m_meanTempPrev[ci] = m_meanTempCurr[ci];  m_meanTempPrev[s] = m_meanTempCurr[s];
+      }
+    }
+    ci++;
+  }
+
+  return errorValue;
+}
+
+unsigned ExhaleEncoder::elementQuantCodingJob (void* const encoder, const unsigned el)
+{
+  return ((ExhaleEncoder*) encoder)->elementQuantCoding (el);
+}
+
+unsigned ExhaleEncoder::elementTransform (const unsigned el) // MCLT of all channels of one element
+{
+  CoreCoderData& coreConfig = *m_elementData[el];
+  const unsigned nrChannels = (coreConfig.elementType & 1) + 1; // for UsacCoreCoderData()
+  const unsigned nSamplesInFrame = toFrameLength (m_frameLength);
+  LappedTransform& transform = m_transform[m_workerPool.getNumWorkers () > 0 ? el : 0];
+  unsigned ci = 0, errorValue = 0; // no error
+
+  for (unsigned e = 0; e < el; e++) ci += (m_elementData[e]->elementType & 1) + 1; // 1st channel
+
+  for (unsigned ch = 0; ch < nrChannels; ch++) // channel loop
+  {
+    const IcsInfo& icsPrev = coreConfig.icsInfoPrev[ch];
+    const IcsInfo& icsCurr = coreConfig.icsInfoCurr[ch];
+    const int32_t* timeSig = (m_shiftValSBR > 0 ? m_coreSignals[ci] : m_timeSignals[ci]);
+    const USAC_WSEQ wsCurr = icsCurr.windowSequence;
+    const bool eightShorts = (wsCurr == EIGHT_SHORT);
+    SfbGroupData&  grpData = coreConfig.groupingData[ch];
+
+    grpData.numWindowGroups = (eightShorts ? NUM_WINDOW_GROUPS : 1);  // fill groupingData
+    memcpy (grpData.windowGroupLength, windowGroupingTable[icsCurr.windowGrouping], NUM_WINDOW_GROUPS * sizeof (uint8_t));
+
+    if (m_quietElement[el]) // zero spectrum, don't transform
+    {
+      memset (m_mdctSignals[ci], 0, nSamplesInFrame * sizeof (int32_t));
+      memset (m_mdstSignals[ci], 0, nSamplesInFrame * sizeof (int32_t));
+    }
+    else
+    errorValue |= transform.applyMCLT (timeSig, eightShorts, icsPrev.windowShape != WINDOW_SINE, icsCurr.windowShape != WINDOW_SINE,
+                                       wsCurr > LONG_START /*lOL*/, (wsCurr % 3) != ONLY_LONG /*lOR*/, m_mdctSignals[ci], m_mdstSignals[ci]);
+    m_scaleFacData[ci++] = &grpData;
+  }
+
+  return errorValue;
+}
+
+unsigned ExhaleEncoder::elementTransformJob (void* const encoder, const unsigned el)
+{
+  return ((ExhaleEncoder*) encoder)->elementTransform (el);
+}
+
+unsigned ExhaleEncoder::encodeStreamFrame () // encode m_pcm24Data, queue the resulting AU
+{
+  const unsigned bytesWritten = (m_streamFrames == 0 ? encodeLookahead () : encodeFrame ());
+
+  if (bytesWritten < 3) return __max (1u, bytesWritten); // error
+
+  if (m_streamFrames++ > 0) // the look-ahead AU only primes the encoder and is not output
+  {
+    if (m_streamAuNext >= m_streamAuSize.size ()) // all AUs were drained, reuse queue memory
+    {
+      m_streamAuData.clear ();
+      m_streamAuSize.clear ();
+      m_streamAuNext = m_streamAuOffs = 0;
+    }
+    try
+    {
+      m_streamAuData.insert (m_streamAuData.end (), m_outAuData, m_outAuData + bytesWritten);
+      m_streamAuSize.push_back (bytesWritten);
+    }
+    catch (...)
+    {
+      return 2; // memory allocation error
+    }
+  }
+  return 0; // no error
+}
+
+void ExhaleEncoder::fillFrameStats (const unsigned auBytes) // frame statistics, stage times are set separately
+{
+  const uint16_t* const chBitCount = m_outStream.getChannelBitCounts ();
+  unsigned ci = 0;
+
+  m_frameStats->frameCount  = m_frameCount - 1u;
+  m_frameStats->auBytes     = auBytes;
+  m_frameStats->rateFactor  = m_rateFactor;
+  m_frameStats->cplxLevel   = m_cplxLevel;
+  m_frameStats->indepFlag   = (m_indepFlag ? 1 : 0);
+  m_frameStats->numElements = m_numElements;
+
+  for (unsigned el = 0; el < m_numElements; el++)
+  {
+    const CoreCoderData& coreConfig = *m_elementData[el];
+    const unsigned nrChannels = (coreConfig.elementType & 1) + 1;
+
+    m_frameStats->stereoMode[el] = (coreConfig.elementType == ID_USAC_CPE ? coreConfig.stereoMode : 0);
+
+    for (unsigned ch = 0; ch < nrChannels; ch++, ci++)
+    {
+      const TnsData& tnsData = coreConfig.tnsData[ch];
+
+      m_frameStats->channelBits[ci]    = chBitCount[ci];
+      m_frameStats->rdocPasses[ci]     = m_rdocPasses[ci];
+      m_frameStats->tnsFilters[ci]     = (coreConfig.tnsActive ? tnsData.numFilters[0] + tnsData.numFilters[1] + tnsData.numFilters[2] : 0);
+      m_frameStats->windowSequence[ci] = coreConfig.icsInfoCurr[ch].windowSequence;
+    }
+  }
+  m_frameStats->numChannels = (uint8_t) ci;
+}
+
 unsigned ExhaleEncoder::getOptParCorCoeffs (const SfbGroupData& grpData, const uint8_t maxSfb, TnsData& tnsData,
                                             const unsigned channelIndex, const uint8_t firstGroupIndexToTest /*= 0*/)
 {
@@ -764,6 +1231,25 @@ uint32_t ExhaleEncoder::getThr (const unsigned channelIndex, const unsigned sfbI
   return sumSfbLoud * (sumSfbLoud >> (toSamplingRate (m_frequencyIdx) >> 13)); // scaled SMR
 }
 
+unsigned ExhaleEncoder::importPlanarInput (const unsigned inputOffset, const unsigned numSamples, const unsigned timeSigOffset)
+{
+  const unsigned nChannels = toNumChannels (m_channelConf);
+  const size_t   bytesPerS = (m_inputFormat == EXHALE_PCM_S16 ? sizeof (int16_t) : sizeof (int32_t));
+
+  // convert numSamples external per-channel samples straight into internal channel buffers
+  for (unsigned ch = 0; ch < nChannels; ch++)
+  {
+    const char* const chSig = (const char*) m_inputPlanar[ch];
+
+    if ((chSig == nullptr) || convertPlanarInput (chSig + inputOffset * bytesPerS, &m_timeSignals[ch][timeSigOffset], numSamples))
+    {
+      return 1; // missing channel input
+    }
+  }
+
+  return 0; // no error
+}
+
 unsigned ExhaleEncoder::psychBitAllocation () // perceptual bit-allocation via scale factors
 {
   const unsigned nChannels       = toNumChannels (m_channelConf);
@@ -1031,7 +1517,7 @@ unsigned ExhaleEncoder::psychBitAllocation () // perceptual bit-allocation via s
               {
                 const uint32_t*  refRms = &coreConfig.groupingData[1 - ch].sfbRmsValues[m_numSwbShort * gr];
                 uint8_t*  grpStereoData = &coreConfig.stereoDataCurr[m_numSwbShort * gr];
-                const unsigned sfbStart = __max (samplingRate < 18783 ? 17 : 24, m_specGapFiller.getFirstGapFillSfb ());
+                const unsigned sfbStart = __max (samplingRate < 18783 ? 17 : 24, m_specGapFiller[0].getFirstGapFillSfb ());
 
                 for (s = sfbStart; s < maxSfbCh; s++)
                 {
@@ -1044,7 +1530,7 @@ unsigned ExhaleEncoder::psychBitAllocation () // perceptual bit-allocation via s
               }
               else if ((m_bitRateMode <= 4) && (meanSpecFlat[ci] <= (SCHAR_MAX >> 1))) // lo
               {
-                for (s = __max (samplingRate < 27713 ? (samplingRate < 18783 ? 17 : 24) : 22, m_specGapFiller.getFirstGapFillSfb ()); s < maxSfbCh; s++)
+                for (s = __max (samplingRate < 27713 ? (samplingRate < 18783 ? 17 : 24) : 22, m_specGapFiller[0].getFirstGapFillSfb ()); s < maxSfbCh; s++)
                 {
                   if (grpRms[s] < ((3 * TA_EPS) >> 1)) grpData.scaleFactors[s + m_numSwbShort * gr] = 0;
                 }
@@ -1099,304 +1585,42 @@ unsigned ExhaleEncoder::quantizationCoding ()  // apply MDCT quantization and en
   const unsigned nChannels        = toNumChannels (m_channelConf);
   const unsigned nSamplesInFrame  = toFrameLength (m_frameLength);
   const unsigned samplingRate     = toSamplingRate (m_frequencyIdx);
-  const unsigned nSamplesTempAna  = (nSamplesInFrame * 25) >> 4; // pre-delay for look-ahead
-#if !EE_MORE_MSE
-  const bool     useMaxBandwidth  = (samplingRate < 37566 || m_shiftValSBR > 0);
-#endif
-  const unsigned* const coeffMagn = m_sfbQuantizer.getCoeffMagnPtr ();
-  uint8_t  meanSpecFlat[USAC_MAX_NUM_CHANNELS];
-  uint8_t  meanTempFlat[USAC_MAX_NUM_CHANNELS] = {208, 208, 208, 208, 208, 208, 208, 208};
-  unsigned ci = 0, s; // running index
-  unsigned errorValue = (coeffMagn == nullptr ? 1 : 0);
+  unsigned errorValue = 0; // no error
 
   // get means of spectral and temporal flatness for every channel
-  m_bitAllocator.getChAverageSpecFlat (meanSpecFlat, nChannels);
+  m_bitAllocator.getChAverageSpecFlat (m_meanSpecCurr, nChannels);
+  memset (m_meanTempCurr, 208, USAC_MAX_NUM_CHANNELS * sizeof (uint8_t));
   if ((m_bitRateMode < (2u >> m_shiftValSBR)) && (samplingRate >= 23004) && (samplingRate < 37566))
   {
-    m_bitAllocator.getChAverageTempFlat (meanTempFlat, nChannels);
+    m_bitAllocator.getChAverageTempFlat (m_meanTempCurr, nChannels);
   }
 
-  for (unsigned el = 0; el < m_numElements; el++)  // element loop
+  // quantize and entropy code all elements, in parallel if worker threads have been created
+  errorValue |= m_workerPool.runJobs (elementQuantCodingJob, this, m_numElements);
+#if !RESTRICT_TO_AAC
+  if (m_workerPool.getNumWorkers () > 0) // keep noise filling state of last coded element
   {
-    CoreCoderData& coreConfig = *m_elementData[el];
-    const unsigned nrChannels = (coreConfig.elementType & 1) + 1; // for UsacCoreCoderData()
-
-    if ((coreConfig.elementType < ID_USAC_LFE) && (coreConfig.stereoMode > 0)) // synch SFMs
+    for (unsigned el = m_numElements - 1; el > 0; el--)
     {
-      meanSpecFlat[ci] = meanSpecFlat[ci + 1] = ((uint16_t) meanSpecFlat[ci] + (uint16_t) meanSpecFlat[ci + 1]) >> 1;
-      meanTempFlat[ci] = meanTempFlat[ci + 1] = ((uint16_t) meanTempFlat[ci] + (uint16_t) meanTempFlat[ci + 1]) >> 1;
+      if (m_noiseFilling[el]) { m_specGapFiller[0] = m_specGapFiller[el]; break; }
     }
+  }
+  m_rateFactor = samplingRate; // rate ctrl
+#endif
+  if (errorValue > 0) return 0;
 
-    for (unsigned ch = 0; ch < nrChannels; ch++)   // channel loop
-    {
-      EntropyCoder& entrCoder = m_entropyCoder[ci];
-      SfbGroupData&   grpData = coreConfig.groupingData[ch];
-      const bool shortWinCurr = (coreConfig.icsInfoCurr[ch].windowSequence == EIGHT_SHORT);
-      const bool shortWinPrev = (coreConfig.icsInfoPrev[ch].windowSequence == EIGHT_SHORT);
-      char* const arithTuples = entrCoder.arithGetTuplePtr ();
-      uint8_t sfIdxPred = UCHAR_MAX;
-
-      if ((errorValue > 0) || (arithTuples == nullptr))
-      {
-        return 0; // an internal error
-      }
-
-      // back up entropy coder memory for use by bit-stream writer
-      memcpy (m_tempIntBuf, arithTuples, (nSamplesInFrame >> 1) * sizeof (char));
-      errorValue |= (entrCoder.getIsShortWindow () != shortWinPrev ? 1 : 0); // sanity check
-
-      memset (m_mdctQuantMag[ci], 0, nSamplesInFrame * sizeof (uint8_t));  // initialization
-
-      for (uint16_t gr = 0; gr < grpData.numWindowGroups; gr++)
-      {
-        const uint8_t grpLength = grpData.windowGroupLength[gr];
-        const uint16_t*  grpOff = &grpData.sfbOffsets[m_numSwbShort * gr];
-        uint32_t* const  grpRms = &grpData.sfbRmsValues[m_numSwbShort * gr]; // coding stats
-        uint8_t*   grpScaleFacs = &grpData.scaleFactors[m_numSwbShort * gr];
-        uint32_t estimBitCount = 0;
-        unsigned lastSfb = 0, lastSOff = 0;
-
-        errorValue |= entrCoder.initWindowCoding (m_indepFlag && (gr == 0), shortWinCurr);
-        s = 0;
+  if (m_frameStats != nullptr) updateStageTime (EXHALE_STAGE_QUANT);
 
-        for (uint16_t b = 0; b < grpData.sfbsPerGroup; b++)
-        {
-          // partial SFB ungrouping for entropy coding setup below
-          const uint16_t swbSize = ((grpOff[b + 1] - grpOff[b]) * oneTwentyEightOver[grpLength]) >> 7; // sfbWidth / grpLength
-          uint8_t* const swbMagn = &m_mdctQuantMag[ci][grpOff[b + 1] - swbSize];
+  errorValue = m_outStream.createAudioFrame (m_elementData, m_entropyCoder, m_mdctSignals, m_mdctQuantMag, m_indepFlag,
+                                             m_numElements, m_numSwbShort, (uint8_t* const) m_tempIntBuf,
+#if !RESTRICT_TO_AAC
+                                             m_timeWarping, m_noiseFilling, m_frameCount - 1u, m_indepPeriod, &m_rateFactor,
+#endif
+                                             m_shiftValSBR, m_coreSignals, m_outAuData, nSamplesInFrame);
+  if (m_frameStats != nullptr) updateStageTime (EXHALE_STAGE_AU_WRITE);
 
-          grpScaleFacs[b] = m_sfbQuantizer.quantizeSpecSfb (entrCoder, m_mdctSignals[ci], grpLength, grpOff, grpRms,
-                                                            b, grpScaleFacs[b], sfIdxPred, m_mdctQuantMag[ci]);
-          if ((b > 0) && (grpScaleFacs[b] < UCHAR_MAX) && (sfIdxPred == UCHAR_MAX))
-          {
-            // back-propagate first nonzero-SFB scale factor index
-            memset (grpScaleFacs, grpScaleFacs[b], b * sizeof (uint8_t));
-          }
-          sfIdxPred = grpScaleFacs[b];
-
-          // correct previous scale factor if the delta exceeds 60
-          if ((b > 0) && (grpScaleFacs[b] > grpScaleFacs[b - 1] + INDEX_OFFSET))
-          {
-            const uint16_t sfbM1Start = grpOff[b - 1];
-            const uint16_t sfbM1Width = grpOff[b] - sfbM1Start;
-            const uint16_t swbM1Size  = (sfbM1Width * oneTwentyEightOver[grpLength]) >> 7; // sfbM1Width / grpLength
-
-            grpScaleFacs[b - 1] = grpScaleFacs[b] - (b > 1 ? INDEX_OFFSET : 0);  // zero-out
-            memset (&m_mdctQuantMag[ci][sfbM1Start], 0, sfbM1Width * sizeof (uint8_t));
-
-            // correct SFB statistics with some bit count estimate
-            grpRms[b - 1] = 1 + (sfbM1Width >> 3) + entrCoder.indexGetBitCount (b > 1 ? (int) grpScaleFacs[b - 1] - grpScaleFacs[b - 2] : 0);
-            // correct entropy coding 2-tuples for the next window
-            memset (&arithTuples[lastSOff], 1, (swbM1Size >> 1) * sizeof (char));
-          }
-          // correct next scale factor if the reduction exceeds 60
-          if ((b + 2u < grpData.sfbsPerGroup) && (sfIdxPred < UCHAR_MAX) && (grpScaleFacs[b + 1]) &&
-              (sfIdxPred > grpScaleFacs[b + 1] + INDEX_OFFSET))
-          {
-            grpScaleFacs[b + 1] = grpScaleFacs[b] - INDEX_OFFSET; // avoid preset-9 zero-out
-          }
-
-          if (b > 0)
-          {
-            if ((grpRms[b - 1] >> 16) > 0) lastSfb = b - 1;
-            estimBitCount += grpRms[b - 1] & USHRT_MAX;
-          }
-          // set up entropy coding 2-tuples for next SFB or window
-          lastSOff = s;
-          for (uint16_t c = 0; c < swbSize; c += 2)
-          {
-            arithTuples[s++] = __min (0xF, swbMagn[c] + swbMagn[c + 1] + 1); // 23003-3, 7.4
-          }
-        } // for b
-
-        if (grpData.sfbsPerGroup > 0) // rate control part 2 to reach constrained VBR (CVBR)
-        {
-#if EE_MORE_MSE
-          const unsigned targetBitCount25 = INT32_MAX;
-#else
-          const uint8_t maxSfbLong  = (useMaxBandwidth ? 54 - (samplingRate >> 13) : brModeAndFsToMaxSfbLong (m_bitRateMode, samplingRate));
-          const uint8_t maxSfbShort = (useMaxBandwidth ? 19 - (samplingRate >> 13) : brModeAndFsToMaxSfbShort(m_bitRateMode, samplingRate));
-          const uint16_t peakIndex  = (shortWinCurr ? 0 : (m_specAnaCurr[ci] >> 5) & 2047);
-          const unsigned sfmBasedSfbStart = (shortWinCurr ? maxSfbShort - 2 + (meanSpecFlat[ci] >> 6) : maxSfbLong  - 6 + (meanSpecFlat[ci] >> 5)) +
-                                            (shortWinCurr ? -3 + (((1 << 5) + meanTempFlat[ci]) >> 6) : -7 + (((1 << 4) + meanTempFlat[ci]) >> 5));
-          const unsigned targetBitCount25 = ((60000 + 20000 * ((m_bitRateMode + m_shiftValSBR) >> (m_frameCount <= 1 ? 2 : 0))) * nSamplesInFrame) /
-                                            (samplingRate * ((grpData.numWindowGroups + 1) >> 1));
-#endif
-          unsigned b = grpData.sfbsPerGroup - 1;
-
-          if ((grpRms[b] >> 16) > 0) lastSfb = b;
-          estimBitCount += grpRms[b] & USHRT_MAX;
-
-#if EC_TRELLIS_OPT_CODING
-          if (grpLength == 1) // finalize bit count estimate, RDOC
-          {
-            estimBitCount = m_sfbQuantizer.quantizeSpecRDOC (entrCoder, grpScaleFacs, estimBitCount + 2u,
-                                                             grpOff, grpRms, grpData.sfbsPerGroup, m_mdctQuantMag[ci]);
-            for (b = 1; b < grpData.sfbsPerGroup; b++)
-            {
-              // correct previous scale factor if delta exceeds 60
-              if (grpScaleFacs[b] > grpScaleFacs[b - 1] + INDEX_OFFSET)
-              {
-                const uint16_t sfbM1Start = grpOff[b - 1];
-                const uint16_t sfbM1Width = grpOff[b] - sfbM1Start;
-
-                grpScaleFacs[b - 1] = grpScaleFacs[b] - (b > 1 ? INDEX_OFFSET : 0); // 0-out
-                memset (&m_mdctQuantMag[ci][sfbM1Start], 0, sfbM1Width * sizeof (uint8_t));
-
-                // correct statistics with some bit count estimate
-                grpRms[b - 1] = 1 + (sfbM1Width >> 3) + entrCoder.indexGetBitCount (b > 1 ? (int) grpScaleFacs[b - 1] - grpScaleFacs[b - 2] : 0);
-                // correct entropy coding 2-tuples for next window
-                memset (&arithTuples[(sfbM1Start - grpOff[0]) >> 1], 1, (sfbM1Width >> 1) * sizeof (char));
-              }
-            }
-          }
-#endif
-#if EE_MORE_MSE
-          b = lastSfb;
-#else
-          // coarse-quantize near-Nyquist SFB with SBR @ 48-64 kHz
-          b = 40 + (samplingRate >> 12);
-          if ((m_shiftValSBR == 0) || (samplingRate < 23004) || shortWinCurr || (b > lastSfb)) b = lastSfb;
-
-          while ((b >= sfmBasedSfbStart + (m_bitRateMode >> 1) + (m_bitRateMode / 5)) && (grpOff[b] > peakIndex) && ((grpRms[b] >> 16) <= 1) &&
-                 ((estimBitCount * 5 > targetBitCount25 * 2) || (grpLength > 1 /*no accurate bit count estim. available for grouped spectrum*/)))
-          {
-            b--; // search first coarsely quantized high-freq. SFB
-          }
-#endif
-          lastSOff = b;
-
-          for (b++; b <= lastSfb; b++)
-          {
-            if ((grpRms[b] >> 16) > 0) // re-quantize nonzero band
-            {
-#if RESTRICT_TO_AAC
-              uint32_t maxVal = 1;
-#else
-              uint32_t maxVal = (shortWinCurr || !m_noiseFilling[el] ? 1 : (m_specAnaCurr[ci] >> 23) & 1); // 1 or 0
-#endif
-              estimBitCount -= grpRms[b] & USHRT_MAX;
-              grpRms[b] = (maxVal << 16) + maxVal; // bit estimate
-              maxVal = quantizeSfbWithMinSnr (coeffMagn, grpOff, b, grpLength, m_mdctQuantMag[ci], arithTuples, maxVal > 0);
-
-              grpScaleFacs[b] = __min (SCHAR_MAX, m_sfbQuantizer.getScaleFacOffset ((double) maxVal));
-
-              // correct SFB statistics with estimate of bit count
-              grpRms[b] += 3 + entrCoder.indexGetBitCount ((int) grpScaleFacs[b] - grpScaleFacs[b - 1]);
-              estimBitCount += grpRms[b] & USHRT_MAX;
-            }
-            else // re-repeat scale factor for zero quantized band
-            {
-              grpScaleFacs[b] = grpScaleFacs[b - 1];
-            }
-          }
-
-          if (estimBitCount > targetBitCount25) // too many bits!!
-          {
-            for (b = lastSOff; b > 0; b--)
-            {
-              if ((grpRms[b] >> 16) > 0) // emergency re-quantizer
-              {
-#if RESTRICT_TO_AAC
-                uint32_t maxVal = 1;
-#else
-                uint32_t maxVal = (shortWinCurr || !m_noiseFilling[el] ? 1 : (m_specAnaCurr[ci] >> 23) & 1); // 1 or 0
-#endif
-                estimBitCount -= grpRms[b] & USHRT_MAX;
-                grpRms[b] = (maxVal << 16) + maxVal; // bit estim.
-                maxVal = quantizeSfbWithMinSnr (coeffMagn, grpOff, b, grpLength, m_mdctQuantMag[ci], arithTuples, maxVal > 0);
-
-                grpScaleFacs[b] = __min (SCHAR_MAX, m_sfbQuantizer.getScaleFacOffset ((double) maxVal));
-
-                // correct SFB statistics with estimated bit count
-                grpRms[b] += 3 + entrCoder.indexGetBitCount ((int) grpScaleFacs[b] - grpScaleFacs[b - 1]);
-                estimBitCount += grpRms[b] & USHRT_MAX;
-              }
-              if (estimBitCount <= targetBitCount25) break;
-            }
-
-            for (b++; b <= lastSfb; b++) // re-repeat scale factor
-            {
-              if ((grpRms[b] >> 16) == 0) // a zero quantized band
-              {
-                grpScaleFacs[b] = grpScaleFacs[b - 1];
-              }
-            }
-          } // if estimBitCount > targetBitCount25
-
-          for (b = lastSfb + 1; b < grpData.sfbsPerGroup; b++)
-          {
-            if ((grpRms[b] >> 16) == 0) // HF zero quantized bands
-            {
-              grpScaleFacs[b] = grpScaleFacs[b - 1];
-            }
-          }
-
-          if ((grpScaleFacs[0] == UCHAR_MAX) &&
-#if !RESTRICT_TO_AAC
-              !m_noiseFilling[el] &&
-#endif
-              (lastSfb == 0))  // ensure all scale factors are set
-          {
-            memset (grpScaleFacs, (gr == 1 ? grpData.scaleFactors[grpData.sfbsPerGroup - 1] : 0), grpData.sfbsPerGroup * sizeof (uint8_t));
-          }
-        }
-      } // for gr
-
-      // restore entropy coder memory for use by bit-stream writer
-      memcpy (arithTuples, m_tempIntBuf, (nSamplesInFrame >> 1) * sizeof (char));
-      entrCoder.setIsShortWindow (shortWinPrev);
-#if !RESTRICT_TO_AAC
-      s = 22050 + 7350 * m_bitRateMode; // compute channel-wise noise_level and noise_offset
-      sfIdxPred = ((m_bitRateMode == 0) && (m_priLength) && (m_shiftValSBR) && ((m_tempAnaCurr[ci] >> 24) || (m_tempAnaNext[ci] >> 24)) && (meanSpecFlat[ci] +
-                    __min ((m_tempAnaCurr[ci] >> 16) & UCHAR_MAX, (m_tempAnaNext[ci] >> 16) & UCHAR_MAX) >= 192) ? UCHAR_MAX : meanSpecFlat[ci]);
-      coreConfig.specFillData[ch] = (!m_noiseFilling[el] ? 0 : m_specGapFiller.getSpecGapFillParams (m_sfbQuantizer, m_mdctQuantMag[ci], m_numSwbShort,
-                                                                                                     grpData, nSamplesInFrame, samplingRate, s,
-                                                                                                     shortWinCurr ? 0 : sfIdxPred));
-      if (coreConfig.specFillData[ch] == 1) errorValue |= 1;
-#endif
-      s = ci + nrChannels - 1 - 2 * ch; // other channel in stereo
-      if ((coreConfig.elementType < ID_USAC_LFE) && (m_shiftValSBR > 0)) // collect SBR data
-      {
-        const uint8_t msfVal = (shortWinPrev ? 31 : __max (2, __max (m_meanSpecPrev[ci], meanSpecFlat[ci]) >> 3));
-        const uint8_t msfSte = (coreConfig.stereoMode == 0 ? 0 : (coreConfig.icsInfoPrev[s + ch - ci].windowSequence ==
-                                 EIGHT_SHORT ? 31 : __max (2, __max (m_meanSpecPrev[s ], meanSpecFlat[s ]) >> 3)));
-        int32_t  tmpValSynch = 0;
-
-        memset (m_coreSignals[ci], 0, 10 * sizeof (int32_t));
-#if ENABLE_INTERTES
-        m_coreSignals[ci][0] = 0x40000000; // bs_interTes = 1 for all frames
-#endif
-        m_coreSignals[ci][0] |= 4 - int32_t (sqrt (0.75 * msfVal)); // filter mode, 0 = none
-
-        if (ch > 0 && coreConfig.stereoMode > 0) // synch. sbr_grid(), sbr_invf() for stereo
-        {
-          tmpValSynch = (m_coreSignals[s][0] >> 21) & 3; // nEnv, bits 23-22
-          m_coreSignals[ci][0] |= m_coreSignals[s][0] & 0x10000F; // bits 21
-          m_coreSignals[s][0] |= m_coreSignals[ci][0] & 0x10000F; // and 4-1
-        }
-        m_coreSignals[ci][0] |= getSbrEnvelopeAndNoise (&m_coreSignals[ci][nSamplesTempAna - 64 + nSamplesInFrame], msfVal,
-                                                        __max (m_meanTempPrev[ci], meanTempFlat[ci]) >> 3, m_bitRateMode == 0,
-                                                        m_indepFlag, msfSte, tmpValSynch, nSamplesInFrame, &m_coreSignals[ci][1]);
-        if (ch + 1 == nrChannels) // update the flatness histories
-        {
-          m_meanSpecPrev[ci] = meanSpecFlat[ci];  m_meanSpecPrev[s] = meanSpecFlat[s];
-          m_meanTempPrev[ci] = meanTempFlat[ci];  m_meanTempPrev[s] = meanTempFlat[s];
-        }
-      }
-      ci++;
-    }
-  } // for el
-#if !RESTRICT_TO_AAC
-  m_rateFactor = samplingRate; // rate ctrl
-#endif
-  return (errorValue > 0 ? 0 : m_outStream.createAudioFrame (m_elementData, m_entropyCoder, m_mdctSignals, m_mdctQuantMag, m_indepFlag,
-                                                             m_numElements, m_numSwbShort, (uint8_t* const) m_tempIntBuf,
-#if !RESTRICT_TO_AAC
-                                                             m_timeWarping, m_noiseFilling, m_frameCount - 1u, m_indepPeriod, &m_rateFactor,
-#endif
-                                                             m_shiftValSBR, m_coreSignals, m_outAuData, nSamplesInFrame)); // returns AU size
-}
+  return errorValue; // AU size
+}
 
 unsigned ExhaleEncoder::spectralProcessing ()  // complete ics_info(), calc TNS and SFB data
 {
@@ -1447,7 +1671,11 @@ unsigned ExhaleEncoder::spectralProcessing ()  // complete ics_info(), calc TNS
     {
       coreConfig.stereoConfig = coreConfig.stereoMode = 0;
 
-      if (coreConfig.commonWindow && (m_bitRateMode <= 5)) // stereo pre-processing analysis
+      if (coreConfig.commonWindow && (m_bitRateMode <= 5) && m_quietElement[el]) // zero MCLTs
+      {
+        m_perCorrHCurr[el] = m_perCorrLCurr[el] = 0; // transition to silence, as computed below
+      }
+      else if (coreConfig.commonWindow && (m_bitRateMode <= 5)) // stereo pre-processing analysis
       {
         const bool     eightShorts = (coreConfig.icsInfoCurr[0].windowSequence == EIGHT_SHORT);
         const uint8_t meanSpecFlat = (((m_specAnaCurr[ci] >> 16) & UCHAR_MAX) + ((m_specAnaCurr[ci + 1] >> 16) & UCHAR_MAX) + 1) >> 1;
@@ -1542,6 +1770,13 @@ unsigned ExhaleEncoder::spectralProcessing ()  // complete ics_info(), calc TNS
           errorValue |= eightShortGrouping (grpData, grpSO, m_mdctSignals[ci], nChannels < 2 ? nullptr : m_mdstSignals[ci]);
         } // if EIGHT_SHORT
 
+        if (m_quietElement[el]) // no spectral coefficients to code, hence no TNS filtering
+        {
+          icsCurr.maxSfb = 0;
+          m_tempFlatPrev[ci++] = 0;
+          continue;
+        }
+
         // compute and quantize optimal TNS coefficients, then find optimal TNS filter order
         s = getOptParCorCoeffs (grpData, icsCurr.maxSfb, tnsData, ci, (ch > 0 && coreConfig.commonWindow ? coreConfig.tnsData[0].firstTnsWindow : 0));
 
@@ -1697,6 +1932,9 @@ unsigned ExhaleEncoder::temporalProcessing () // determine time-domain aspects o
   const unsigned nSamplesInFrame = toFrameLength (m_frameLength) << m_shiftValSBR;
   const unsigned nSamplesTempAna = (nSamplesInFrame * 25) >> 4;  // pre-delay for look-ahead
   const unsigned lfeChannelIndex = (m_channelConf >= CCI_6_CH ? __max (5, nChannels - 1) : USAC_MAX_NUM_CHANNELS);
+#if EE_QUIET_FRAMES
+  uint8_t quietFlags[USAC_MAX_NUM_CHANNELS];
+#endif
   unsigned ci = 0; // running ch index
   unsigned errorValue = 0; // no error
 
@@ -1710,6 +1948,9 @@ unsigned ExhaleEncoder::temporalProcessing () // determine time-domain aspects o
   // get temporal channel statistics for next frame, used for window length/overlap decision
   m_tempAnalyzer.getTempAnalysisStats (m_tempAnaNext, nChannels);
   m_tempAnalyzer.getTransientAndPitch (m_tranLocNext, nChannels);
+#if EE_QUIET_FRAMES
+  m_tempAnalyzer.getQuietFrameFlags (quietFlags, nChannels);
+#endif
 
 #ifdef NO_PREROLL_DATA
   m_indepFlag = (((m_frameCount++) % m_indepPeriod) == 0); // configure usacIndependencyFlag
@@ -1725,6 +1966,10 @@ unsigned ExhaleEncoder::temporalProcessing () // determine time-domain aspects o
     coreConfig.commonWindow   = false;
     coreConfig.icsInfoPrev[0] = coreConfig.icsInfoCurr[0];
     coreConfig.icsInfoPrev[1] = coreConfig.icsInfoCurr[1];
+#if EE_QUIET_FRAMES
+    // the long MCLT window of this frame spans the last three frames seen by temporalAnalysis
+    m_quietElement[el] = (coreConfig.elementType < ID_USAC_LFE) && ((quietFlags[ci] & quietFlags[ci + nrChannels - 1] & 7) == 7);
+#endif
 
     if (coreConfig.elementType >= ID_USAC_LFE) // LFE/EXT elements
     {
@@ -1878,28 +2123,44 @@ unsigned ExhaleEncoder::temporalProcessing () // determine time-domain aspects o
         coreConfig.stereoDataCurr[0] = (m_bitRateMode <= 1 ? m_tempAnalyzer.stereoPreAnalysis (&m_timeSignals[ci - 2], &m_specFlatPrev[ci - 2], nSamplesInFrame) : 0);
       } // if nrChannels > 1
     }
+  } // for el
 
-    ci -= nrChannels; // modulated complex lapped transform (MCLT) for all channels, windows
+  // modulated complex lapped transform (MCLT) for all channels and windows, maybe in parallel
+  errorValue |= m_workerPool.runJobs (elementTransformJob, this, m_numElements);
 
-    for (unsigned ch = 0; ch < nrChannels; ch++) // channel loop
-    {
-      const IcsInfo& icsPrev = coreConfig.icsInfoPrev[ch];
-      const IcsInfo& icsCurr = coreConfig.icsInfoCurr[ch];
-      const int32_t* timeSig = (m_shiftValSBR > 0 ? m_coreSignals[ci] : m_timeSignals[ci]);
-      const USAC_WSEQ wsCurr = icsCurr.windowSequence;
-      const bool eightShorts = (wsCurr == EIGHT_SHORT);
-      SfbGroupData&  grpData = coreConfig.groupingData[ch];
+  return errorValue;
+}
+
+void ExhaleEncoder::updateComplexity (const unsigned encodingMicroSec)
+{
+  const uint64_t frameMicroSec = (toFrameLength (m_frameLength) * 1000000ull) / toSamplingRate (m_frequencyIdx);
+  const uint32_t rtfCurr = (uint32_t) __min (1u << 20, (encodingMicroSec * 1600ull) / frameMicroSec); // 1/16 %
 
-      grpData.numWindowGroups = (eightShorts ? NUM_WINDOW_GROUPS : 1);  // fill groupingData
-      memcpy (grpData.windowGroupLength, windowGroupingTable[icsCurr.windowGrouping], NUM_WINDOW_GROUPS * sizeof (uint8_t));
+  m_rtfMeasured = (m_rtfMeasured == 0 ? rtfCurr : (m_rtfMeasured * 7 + rtfCurr + 4) >> 3);
 
-      errorValue |= m_transform.applyMCLT (timeSig, eightShorts, icsPrev.windowShape != WINDOW_SINE, icsCurr.windowShape != WINDOW_SINE,
-                                           wsCurr > LONG_START /*lOL*/, (wsCurr % 3) != ONLY_LONG /*lOR*/, m_mdctSignals[ci], m_mdstSignals[ci]);
-      m_scaleFacData[ci++] = &grpData;
+  if ((m_frameCount % EE_RTF_PERIOD) == 0) // lower complexity above target, raise it below half of target
+  {
+    const uint8_t prevLevel = m_cplxLevel;
+
+    if ((m_rtfMeasured > m_rtfTarget * 16u) && (m_cplxLevel < EE_RTF_MAX_LEVEL)) m_cplxLevel++;
+    else
+    if ((m_rtfMeasured < m_rtfTarget * 8u) && (m_cplxLevel > 0)) m_cplxLevel--;
+
+    if (m_cplxLevel != prevLevel)
+    {
+      applyComplexity ();
+      if (m_statsCallback) m_statsCallback (m_statsContext, m_frameCount, (m_rtfMeasured + 8) >> 4, m_cplxLevel);
     }
-  } // for el
+  }
+}
 
-  return errorValue;
+void ExhaleEncoder::updateStageTime (const ExhaleStatsStage stage)
+{
+  const std::chrono::steady_clock::time_point currTime = std::chrono::steady_clock::now ();
+  const int64_t t = std::chrono::duration_cast<std::chrono::nanoseconds> (currTime - m_statsTime).count ();
+
+  m_frameStats->stageNanoSec[stage] = (uint32_t) __min (UINT_MAX, t);
+  m_statsTime = currTime; // start of next stage
 }
 
 // constructor
@@ -1919,6 +2180,7 @@ ExhaleEncoder::ExhaleEncoder (int32_t* const inputPcmData,           unsigned ch
   m_numElements  = elementCountConfig[m_channelConf % USAC_MAX_NUM_ELCONFIGS]; // used in UsacDecoderConfig
   m_shiftValSBR  = (frameLength >= 1536 ? 1 : 0);
   m_frameCount   = m_rateFactor = 0;
+  m_frameStats   = nullptr; // stats off
   m_priLength    = 0;
   m_frameLength  = USAC_CCFL (frameLength >> m_shiftValSBR); // ccfl signaled using coreSbrFrameLengthIndex
   m_frequencyIdx = toSamplingFrequencyIndex (sampleRate >> m_shiftValSBR); // as usacSamplingFrequencyIndex
@@ -1929,11 +2191,38 @@ ExhaleEncoder::ExhaleEncoder (int32_t* const inputPcmData,           unsigned ch
 #else
   m_nonMpegExt   = useEcodisExt;
 #endif
+  m_cplxLevel    = 0;
   m_numSwbLong   = MAX_NUM_SWB_LONG;
   m_numSwbShort  = MAX_NUM_SWB_SHORT;
+  m_numThreads   = 0; // single-threaded
+  m_inputFlags   = 0;
+  m_inputFormat  = EXHALE_PCM_S24;
+  m_inputPlanar  = nullptr; // interleaved
+#if EE_INPUT_AVX2
+  m_inputSimdPath = isAvx2Supported ();
+#else
+  m_inputSimdPath = false;
+#endif
   m_outAuData    = outputAuData;
   m_pcm24Data    = inputPcmData;
+  m_rdocStates[0] = m_rdocStates[1] = 0; // preset defaults
+  m_rtfMeasured  = 0;
+  m_rtfTarget    = 0; // RTF guard off
+  m_sharedTables = nullptr;
+  m_streamAuNext = 0;
+  m_streamAuOffs = 0;
+  m_streamAuTime = 0;
+  m_streamEnded  = false;
+  m_streamFill   = 0;
+  m_streamFrames = 0;
+  m_streamInput  = 0;
+  m_streamMode   = ((inputPcmData == nullptr) && (outputAuData == nullptr));
+  m_statsCallback = nullptr;
+  m_statsContext = nullptr;
   m_tempIntBuf   = nullptr;
+  m_timeSigOffset = 0;
+
+  for (unsigned u = 0; u < 8; u++) m_ditherSeed[u] = 0x9E3779B9u * (u + 1); // decorrelated dither lanes
 
   // initialize all helper structs
   for (unsigned el = 0; el < USAC_MAX_NUM_ELEMENTS; el++)
@@ -1941,8 +2230,10 @@ ExhaleEncoder::ExhaleEncoder (int32_t* const inputPcmData,           unsigned ch
     const ELEM_TYPE et = elementTypeConfig[m_channelConf % USAC_MAX_NUM_ELCONFIGS][el];  // usacElementType
 
     m_elementData[el]  = nullptr;
+    m_elemTempBuf[el]  = nullptr;
     m_perCorrHCurr[el] = 0;
     m_perCorrLCurr[el] = 0;
+    m_quietElement[el] = false;
 #if !RESTRICT_TO_AAC
     m_noiseFilling[el] = (useNoiseFilling && (et < ID_USAC_LFE));
     m_timeWarping[el]  = (false /* N/A */ && (et < ID_USAC_LFE));
@@ -1957,8 +2248,11 @@ ExhaleEncoder::ExhaleEncoder (int32_t* const inputPcmData,           unsigned ch
     m_mdctQuantMag[ch] = nullptr;
     m_mdctSignals[ch]  = nullptr;
     m_mdstSignals[ch]  = nullptr;
+    m_meanSpecCurr[ch] = 0;
     m_meanSpecPrev[ch] = 0;
+    m_meanTempCurr[ch] = 0;
     m_meanTempPrev[ch] = 0;
+    m_rdocPasses[ch]   = 0;
     m_scaleFacData[ch] = nullptr;
     m_specAnaCurr[ch]  = 0;
     m_specFlatPrev[ch] = 0;
@@ -1969,37 +2263,19 @@ ExhaleEncoder::ExhaleEncoder (int32_t* const inputPcmData,           unsigned ch
     m_tranLocCurr[ch]  = -1;
     m_tranLocNext[ch]  = -1;
   }
-  // initialize all window buffers
-  for (unsigned ws = WINDOW_SINE; ws <= WINDOW_KBD; ws++)
-  {
-    m_timeWindowL[ws] = nullptr;
-    m_timeWindowS[ws] = nullptr;
-  }
 }
 
 // destructor
 ExhaleEncoder::~ExhaleEncoder ()
 {
-  // free allocated helper structs
-  for (unsigned el = 0; el < USAC_MAX_NUM_ELEMENTS; el++)
-  {
-    MFREE (m_elementData[el]);
-  }
-  // free allocated signal buffers
-  for (unsigned ch = 0; ch < USAC_MAX_NUM_CHANNELS; ch++)
-  {
-    if (m_shiftValSBR > 0) MFREE (m_coreSignals[ch]);
-    MFREE (m_mdctQuantMag[ch]);
-    MFREE (m_mdctSignals[ch]);
-    MFREE (m_mdstSignals[ch]);
-    MFREE (m_timeSignals[ch]);
-  }
-  // free allocated window buffers
-  for (unsigned ws = WINDOW_SINE; ws <= WINDOW_KBD; ws++)
+  // helper structs and signal buffers are freed by m_memArena
+  if (m_streamMode) // free own PCM and AU buffers
   {
-    MFREE (m_timeWindowL[ws]);
-    MFREE (m_timeWindowS[ws]);
+    MFREE (m_outAuData);
+    MFREE (m_pcm24Data);
   }
+  // release shared window buffers
+  SharedTables::release (m_sharedTables);
   // execute sub-class destructors
 }
 
@@ -2012,7 +2288,11 @@ unsigned ExhaleEncoder::encodeLookahead ()
   const int32_t* chSig           = m_pcm24Data;
   unsigned ch, s;
 
-  // copy nSamplesInFrame external channel-interleaved samples into internal channel buffers
+  if (m_inputPlanar != nullptr) // convert nSamplesInFrame external planar samples in place
+  {
+    if (importPlanarInput (0, nSamplesInFrame, nSamplesTempAna)) return 1; // missing input
+  }
+  else // copy nSamplesInFrame external channel-interleaved samples into internal channel buffers
   for (s = 0; s < nSamplesInFrame; s++) // sample loop
   {
     for (ch = 0; ch < nChannels; ch++) m_timeSignals[ch][nSamplesTempAna + s] = *(chSig++);
@@ -2061,44 +2341,89 @@ unsigned ExhaleEncoder::encodeFrame ()
   const unsigned nChannels       = toNumChannels (m_channelConf);
   const unsigned nSamplesInFrame = toFrameLength (m_frameLength) << m_shiftValSBR;
   const unsigned nSamplesTempAna = (nSamplesInFrame * 25) >> 4;  // pre-delay for look-ahead
+  const unsigned nSmpInFrame     = toFrameLength (m_frameLength); // core coder frame length
+  const unsigned nSmpCoreSig     = (nSamplesInFrame * 41) >> (4 + m_shiftValSBR);
   const int32_t* chSig           = m_pcm24Data;
+  const std::chrono::steady_clock::time_point startTime = (m_rtfTarget > 0 ? std::chrono::steady_clock::now () : std::chrono::steady_clock::time_point ());
   unsigned ch, s;
 
-  // move internal channel buffers nSamplesInFrame to the past to make room for next samples
-  for (ch = 0; ch < nChannels; ch++)
+  // slide internal channel buffers nSamplesInFrame to the past to make room for next samples
+  if (m_timeSigOffset < EE_TIME_SIG_FRAMES * nSamplesInFrame) // advance the buffer windows
   {
-    memcpy (&m_timeSignals[ch][0], &m_timeSignals[ch][nSamplesInFrame], nSamplesInFrame * sizeof (int32_t));
-    memcpy (&m_timeSignals[ch][nSamplesInFrame], &m_timeSignals[ch][2 * nSamplesInFrame], (nSamplesTempAna - nSamplesInFrame) * sizeof (int32_t));
+    for (ch = 0; ch < nChannels; ch++)
+    {
+      m_timeSignals[ch] += nSamplesInFrame;
 
-    if (m_shiftValSBR > 0)
+      if (m_shiftValSBR > 0) // carry SBR level delay line at end of window
+      {
+        m_coreSignals[ch] += nSmpInFrame;
+        memcpy (&m_coreSignals[ch][nSmpCoreSig - 64], &m_coreSignals[ch][nSmpCoreSig - 64 - nSmpInFrame], 64 * sizeof (int32_t));
+      }
+    }
+    m_timeSigOffset += nSamplesInFrame;
+  }
+  else // end of buffers reached, move the history to the buffer starts
+  {
+    for (ch = 0; ch < nChannels; ch++)
     {
-      const unsigned nSmpInFrame = toFrameLength (m_frameLength); // core coder frame length
+      int32_t* const timeSigBuf = m_timeSignals[ch] - m_timeSigOffset;
+
+      memmove (timeSigBuf, &m_timeSignals[ch][nSamplesInFrame], nSamplesTempAna * sizeof (int32_t));
+      m_timeSignals[ch] = timeSigBuf;
+
+      if (m_shiftValSBR > 0)
+      {
+        int32_t* const coreSigBuf = m_coreSignals[ch] - (m_timeSigOffset >> m_shiftValSBR);
 
-      memcpy (&m_coreSignals[ch][0], &m_coreSignals[ch][nSmpInFrame], nSmpInFrame * sizeof (int32_t));
-      memcpy (&m_coreSignals[ch][nSmpInFrame], &m_coreSignals[ch][2 * nSmpInFrame], (nSamplesInFrame >> 2) * sizeof (int32_t));
+        memmove (coreSigBuf, &m_coreSignals[ch][nSmpInFrame], (nSmpInFrame + (nSamplesInFrame >> 2)) * sizeof (int32_t));
+        memmove (&coreSigBuf[nSmpCoreSig - 64], &m_coreSignals[ch][nSmpCoreSig - 64], 64 * sizeof (int32_t));
+        m_coreSignals[ch] = coreSigBuf;
+      }
     }
+    m_timeSigOffset = 0;
   }
 
-  // copy nSamplesInFrame external channel-interleaved samples into internal channel buffers
+  if (m_inputPlanar != nullptr) // convert nSamplesInFrame external planar samples in place
+  {
+    if (importPlanarInput (0, nSamplesInFrame, nSamplesTempAna)) return 1; // missing input
+  }
+  else // copy nSamplesInFrame external channel-interleaved samples into internal channel buffers
   for (s = 0; s < nSamplesInFrame; s++) // sample loop
   {
     for (ch = 0; ch < nChannels; ch++) m_timeSignals[ch][nSamplesTempAna + s] = *(chSig++);
   }
 
+  if (m_frameStats != nullptr) m_statsTime = std::chrono::steady_clock::now ();
+
   if (temporalProcessing ()) // time domain: window length, overlap, grouping, and transform
   {
     return 2; // internal error in temporal processing
   }
+  if (m_frameStats != nullptr) updateStageTime (EXHALE_STAGE_TEMPORAL);
+
   if (spectralProcessing ()) // MCLT domain: (common_)max_sfb, grouping 2, TNS, and SFB data
   {
     return 2; // internal error in spectral processing
   }
+  if (m_frameStats != nullptr) updateStageTime (EXHALE_STAGE_SPECTRAL);
+
   if (psychBitAllocation ()) // SFB domain: psychoacoustic model and scale factor estimation
   {
     return 1; // internal error in bit-allocation code
   }
+  if (m_frameStats != nullptr) updateStageTime (EXHALE_STAGE_PSYCH);
 
-  return quantizationCoding (); // max(3, coded bytes)
+  s = quantizationCoding (); // max(3, coded bytes)
+
+  if ((m_frameStats != nullptr) && (s >= 3)) fillFrameStats (s);
+
+  if (m_rtfTarget > 0) // real-time factor guard, see setTargetRtf()
+  {
+    const int64_t t = std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now () - startTime).count ();
+
+    updateComplexity ((unsigned) __min (UINT_MAX, t));
+  }
+  return s;
 }
 
 unsigned ExhaleEncoder::initEncoder (unsigned char* const audioConfigBuffer, uint32_t* const audioConfigBytes /*= nullptr*/)
@@ -2106,7 +2431,7 @@ unsigned ExhaleEncoder::initEncoder (unsigned char* const audioConfigBuffer, uin
   const unsigned nChannels       = toNumChannels (m_channelConf);
   const unsigned nSamplesInFrame = toFrameLength (m_frameLength);
   const unsigned specSigBufSize  = nSamplesInFrame * sizeof (int32_t);
-  const unsigned timeSigBufSize  = (((nSamplesInFrame << m_shiftValSBR) * 41) >> 4) * sizeof (int32_t); // core-codec delay*4
+  const unsigned timeSigBufSize  = (((nSamplesInFrame << m_shiftValSBR) * (41 + 16 * EE_TIME_SIG_FRAMES)) >> 4) * sizeof (int32_t); // delay*4 + spare
   const unsigned char chConf     = m_channelConf;
   unsigned ch, errorValue = 0; // no error
 
@@ -2131,7 +2456,12 @@ unsigned ExhaleEncoder::initEncoder (unsigned char* const audioConfigBuffer, uin
   {
     errorValue |=  32;
   }
-  if ((m_outAuData == nullptr) || (m_pcm24Data == nullptr))
+  if (m_streamMode && (errorValue == 0) && (m_pcm24Data == nullptr)) // allocate internal frame buffers
+  {
+    m_outAuData = (unsigned char*) malloc (EE_MAX_AU_BYTES * nChannels);
+    m_pcm24Data = (int32_t*) calloc ((nSamplesInFrame << m_shiftValSBR) * nChannels, sizeof (int32_t));
+  }
+  if ((m_outAuData == nullptr) || ((m_pcm24Data == nullptr) && (m_inputPlanar == nullptr)))
   {
     errorValue |=  16;
   }
@@ -2162,69 +2492,101 @@ unsigned ExhaleEncoder::initEncoder (unsigned char* const audioConfigBuffer, uin
     return errorValue;
   }
 
-  // allocate all helper structs
+  if (m_shiftValSBR > 1) return 4; // no 8:3, 4:1
+
+  // size and allocate one arena for all helper structs and signal buffers
+  {
+    const unsigned numSwb     = numSwbOffsetL[m_swbTableIdx] - 1;
+    const unsigned numElemBuf = ((m_numThreads > 1) && (m_numElements > 1) ? m_numElements - 1 : 0);
+#if EC_TRELLIS_OPT_CODING
+    const size_t quantMemSize = SfbQuantizer::getQuantMemSize (nSamplesInFrame, numSwb, toSamplingRate (m_frequencyIdx));
+#else
+    const size_t quantMemSize = SfbQuantizer::getQuantMemSize (nSamplesInFrame);
+#endif
+    const size_t chanMemSize  = MEM_ALIGN_SIZE (timeSigBufSize) + (m_shiftValSBR > 0 ? MEM_ALIGN_SIZE (timeSigBufSize >> m_shiftValSBR) : 0) +
+                                2 * MEM_ALIGN_SIZE (specSigBufSize) + MEM_ALIGN_SIZE (nSamplesInFrame * sizeof (uint8_t)) +
+                                EntropyCoder::getCodingMemSize (nSamplesInFrame);
+
+    if (m_memArena.allocate (m_numElements * MEM_ALIGN_SIZE (sizeof (CoreCoderData)) + nChannels * chanMemSize +
+                             BitAllocator::getAllocMemSize (numSwb) + quantMemSize +
+                             SpecAnalyzer::getSigAnaMemSize (m_bitRateMode <= 5 ? nChannels : 0, nSamplesInFrame) +
+                             numElemBuf * (MEM_ALIGN_SIZE (specSigBufSize) + quantMemSize)) > 0)
+    {
+      return 8; // memory allocation error
+    }
+  }
+
+  // carve out all helper structs
   for (unsigned el = 0; el < m_numElements; el++)  // element loop
   {
-    if ((m_elementData[el] = (CoreCoderData*) malloc (sizeof (CoreCoderData))) == nullptr)
+    if ((m_elementData[el] = (CoreCoderData*) m_memArena.take (sizeof (CoreCoderData))) == nullptr)
     {
       errorValue |= 8;
     }
-    else
+    else // arena is zero-initialized
     {
-      memset (m_elementData[el], 0, sizeof (CoreCoderData));
       m_elementData[el]->elementType = elementTypeConfig[chConf][el]; // usacElementType[el]
     }
   }
   memset (m_sfbLoudMem, 1, 2 * 26 * 32 * sizeof (uint16_t));
 
-  // allocate all signal buffers
-  if (m_shiftValSBR > 0)
-  {
-    if (m_shiftValSBR > 1) return (errorValue | 4); // no 8:3, 4:1
-
-    for (ch = 0; ch < nChannels; ch++)
-    {
-      if ((m_coreSignals[ch] = (int32_t*) malloc (timeSigBufSize >> m_shiftValSBR)) == nullptr)
-      {
-        errorValue |= 4;
-      }
-    }
-  }
+  // carve out all signal buffers, channel by channel for locality
   for (ch = 0; ch < nChannels; ch++)
   {
-    if ((m_entropyCoder[ch].initCodingMemory (nSamplesInFrame) > 0) ||
-        (m_mdctQuantMag[ch]= (uint8_t*) malloc (nSamplesInFrame * sizeof (uint8_t))) == nullptr ||
-        (m_mdctSignals[ch] = (int32_t*) malloc (specSigBufSize)) == nullptr ||
-        (m_mdstSignals[ch] = (int32_t*) malloc (specSigBufSize)) == nullptr ||
-        (m_timeSignals[ch] = (int32_t*) malloc (timeSigBufSize)) == nullptr)
+    if ((m_timeSignals[ch] = (int32_t*) m_memArena.take (timeSigBufSize)) == nullptr ||
+        (m_shiftValSBR > 0 && (m_coreSignals[ch] = (int32_t*) m_memArena.take (timeSigBufSize >> m_shiftValSBR)) == nullptr) ||
+        (m_mdctSignals[ch] = (int32_t*) m_memArena.take (specSigBufSize)) == nullptr ||
+        (m_mdstSignals[ch] = (int32_t*) m_memArena.take (specSigBufSize)) == nullptr ||
+        (m_mdctQuantMag[ch]= (uint8_t*) m_memArena.take (nSamplesInFrame * sizeof (uint8_t))) == nullptr ||
+        (m_entropyCoder[ch].initCodingMemory (nSamplesInFrame, &m_memArena) > 0))
     {
       errorValue |= 4;
     }
   }
-  // allocate all window buffers
-  for (unsigned ws = WINDOW_SINE; ws <= WINDOW_KBD; ws++)
+  // obtain window buffers and LUTs
+  if ((m_sharedTables = SharedTables::acquire (nSamplesInFrame)) == nullptr)
   {
-    if ((m_timeWindowL[ws] = initWindowHalfCoeffs ((USAC_WSHP) ws, nSamplesInFrame)) == nullptr ||
-        (m_timeWindowS[ws] = initWindowHalfCoeffs ((USAC_WSHP) ws, nSamplesInFrame >> 3)) == nullptr)
-    {
-      errorValue |= 2;
-    }
+    errorValue |= 2;
   }
   if (errorValue > 0) return errorValue;
 
   // initialize coder class memory
-  m_tempIntBuf = m_timeSignals[0];
-  if (m_bitAllocator.initAllocMemory (&m_linPredictor, numSwbOffsetL[m_swbTableIdx] - 1, m_bitRateMode >> ((nChannels - 1) >> 2)) > 0 ||
+  m_tempIntBuf = m_timeSignals[0]; // oldest frame or below window, unused after MCLT
+  if (m_bitAllocator.initAllocMemory (&m_linPredictor, numSwbOffsetL[m_swbTableIdx] - 1, m_bitRateMode >> ((nChannels - 1) >> 2), &m_memArena) > 0 ||
 #if EC_TRELLIS_OPT_CODING
-      m_sfbQuantizer.initQuantMemory (nSamplesInFrame, numSwbOffsetL[m_swbTableIdx] - 1, m_bitRateMode, toSamplingRate (m_frequencyIdx)) > 0 ||
+      m_sfbQuantizer[0].initQuantMemory (m_sharedTables, nSamplesInFrame, numSwbOffsetL[m_swbTableIdx] - 1, m_bitRateMode, toSamplingRate (m_frequencyIdx),
+                                         SCHAR_MAX, &m_memArena) > 0 ||
 #else
-      m_sfbQuantizer.initQuantMemory (nSamplesInFrame) > 0 ||
+      m_sfbQuantizer[0].initQuantMemory (m_sharedTables, nSamplesInFrame, SCHAR_MAX, &m_memArena) > 0 ||
 #endif
-      m_specAnalyzer.initSigAnaMemory (&m_linPredictor, m_bitRateMode <= 5 ? nChannels : 0, nSamplesInFrame) > 0 ||
-      m_transform.initConstants (m_tempIntBuf, m_timeWindowL, m_timeWindowS, nSamplesInFrame) > 0)
+      m_specAnalyzer.initSigAnaMemory (&m_linPredictor, m_bitRateMode <= 5 ? nChannels : 0, nSamplesInFrame, &m_memArena) > 0 ||
+      m_transform[0].initConstants (m_tempIntBuf, m_sharedTables) > 0)
   {
     errorValue |= 1;
   }
+  m_elemTempBuf[0] = m_tempIntBuf;
+
+  if ((errorValue == 0) && (m_numThreads > 1) && (m_numElements > 1)) // element-parallel coding
+  {
+    if (m_workerPool.initWorkers (__min (m_numThreads, m_numElements) - 1u) > 0) errorValue |= 1;
+
+    for (unsigned el = 1; el < m_numElements; el++) // separate helpers for each worker
+    {
+      if ((m_elemTempBuf[el] = (int32_t*) m_memArena.take (specSigBufSize)) == nullptr ||
+#if EC_TRELLIS_OPT_CODING
+          m_sfbQuantizer[el].initQuantMemory (m_sharedTables, nSamplesInFrame, numSwbOffsetL[m_swbTableIdx] - 1, m_bitRateMode, toSamplingRate (m_frequencyIdx),
+                                              SCHAR_MAX, &m_memArena) > 0 ||
+#else
+          m_sfbQuantizer[el].initQuantMemory (m_sharedTables, nSamplesInFrame, SCHAR_MAX, &m_memArena) > 0 ||
+#endif
+          m_transform[el].initConstants (m_elemTempBuf[el], m_sharedTables) > 0)
+      {
+        errorValue |= 1;
+      }
+    }
+  }
+
+  applyComplexity (); // see setComplexity() and setTargetRtf()
 
   if ((errorValue == 0) && (audioConfigBuffer != nullptr)) // save UsacConfig() for writeout
   {
@@ -2246,7 +2608,13 @@ unsigned ExhaleEncoder::initEncoder (unsigned char* const audioConfigBuffer, uin
     // it reminds developers to apply short-term R128 normalization of the incoming samples.
     if ((m_frameCount == 0) && (loudnessInfo & 16383)) errorValue |= 256;
   }
-  if (m_priLength)
+  if (m_priLength && (m_inputPlanar != nullptr))
+  {
+    const unsigned nSamplesTempAna = (nSamplesInFrame * 25) >> (4 - m_shiftValSBR);
+
+    if (importPlanarInput ((nSamplesInFrame << m_shiftValSBR) - m_priLength, m_priLength, nSamplesTempAna - m_priLength)) errorValue |= 16;
+  }
+  else if (m_priLength)
   {
     const unsigned nSamplesTempAna = (nSamplesInFrame * 25) >> (4 - m_shiftValSBR);
     const int32_t* chSig = &m_pcm24Data[nChannels * ((nSamplesInFrame << m_shiftValSBR) - m_priLength)];
@@ -2260,6 +2628,211 @@ unsigned ExhaleEncoder::initEncoder (unsigned char* const audioConfigBuffer, uin
   return errorValue;
 }
 
+unsigned ExhaleEncoder::drainAuData (unsigned char* const auBuffer, const unsigned auBufferSize, uint32_t* const auBytes,
+                                     int64_t* const auTimestamp /*= nullptr*/)
+{
+  const unsigned nSamplesInFrame = toFrameLength (m_frameLength) << m_shiftValSBR;
+
+  if (!m_streamMode || (auBytes == nullptr))
+  {
+    return 1; // invalid arguments error
+  }
+  *auBytes = 0;
+  if (m_streamAuNext >= m_streamAuSize.size ()) return 0; // no AU pending
+
+  *auBytes = m_streamAuSize[m_streamAuNext];
+  if ((auBuffer == nullptr) || (auBufferSize < *auBytes))
+  {
+    return 2; // buffer too small, *auBytes holds required size
+  }
+  memcpy (auBuffer, &m_streamAuData[m_streamAuOffs], *auBytes);
+  // presentation time of the first output sample decoded from the AU
+  if (auTimestamp) *auTimestamp = int64_t (m_streamAuTime * nSamplesInFrame) - getStreamDelay ();
+
+  m_streamAuOffs += *auBytes;
+  m_streamAuNext++;
+  m_streamAuTime++;
+
+  return 0; // no error
+}
+
+unsigned ExhaleEncoder::flushPcmData ()
+{
+  const unsigned nChannels       = toNumChannels (m_channelConf);
+  const unsigned nSamplesInFrame = toFrameLength (m_frameLength) << m_shiftValSBR;
+  const uint64_t numFramesToCode = (m_streamInput + getStreamDelay () + nSamplesInFrame - 1) / nSamplesInFrame + 1; // incl. look-ahead
+  unsigned errorValue = 0;
+
+  if (!m_streamMode || (m_elementData[0] == nullptr))
+  {
+    return 1; // invalid arguments error, or initEncoder was not called before
+  }
+  if (m_streamEnded) return 0;
+
+  while ((errorValue == 0) && (m_streamFrames < numFramesToCode)) // pad with zeros until last input sample is coded
+  {
+    memset (&m_pcm24Data[m_streamFill * nChannels], 0, (nSamplesInFrame - m_streamFill) * nChannels * sizeof (int32_t));
+    m_streamFill = 0;
+    errorValue = encodeStreamFrame ();
+  }
+  m_streamEnded = true;
+
+  return errorValue;
+}
+
+unsigned ExhaleEncoder::getStreamDelay () const
+{
+  const unsigned nSamplesInFrame = toFrameLength (m_frameLength) << m_shiftValSBR;
+
+  return ((nSamplesInFrame * 25) >> 4) - nSamplesInFrame + (m_shiftValSBR > 0 ? 962 : 0); // look-ahead, SBR delay
+}
+
+unsigned ExhaleEncoder::pushPcmData (const void* const pcmData, const unsigned numSamples, const ExhalePcmFormat pcmFormat,
+                                     const bool planar /*= false*/)
+{
+  const unsigned nChannels       = toNumChannels (m_channelConf);
+  const unsigned nSamplesInFrame = toFrameLength (m_frameLength) << m_shiftValSBR;
+  unsigned ch, s, n = 0, errorValue;
+
+  if (!m_streamMode || (m_elementData[0] == nullptr) || m_streamEnded || ((pcmData == nullptr) && (numSamples > 0)) || (pcmFormat > EXHALE_PCM_F32))
+  {
+    return 1; // invalid arguments error, initEncoder was not called before, or flushPcmData was called
+  }
+
+  while (n < numSamples) // fill up the frame buffer, encode it when full
+  {
+    const unsigned count = __min (numSamples - n, nSamplesInFrame - m_streamFill);
+    int32_t* frameBuf = &m_pcm24Data[m_streamFill * nChannels];
+
+    for (ch = 0; ch < nChannels; ch++) // convert to channel-interleaved 24-bit samples
+    {
+      const size_t offset = (planar ? (size_t) ch * numSamples + n : (size_t) n * nChannels + ch);
+      const size_t stride = (planar ? 1 : nChannels);
+
+      if (pcmFormat == EXHALE_PCM_S16)
+      {
+        const int16_t* i16 = (const int16_t*) pcmData + offset;
+
+        for (s = 0; s < count; s++, i16 += stride) frameBuf[s * nChannels + ch] = (int32_t) *i16 * (1 << 8);
+      }
+      else
+      if (pcmFormat == EXHALE_PCM_S24)
+      {
+        const int32_t* i32 = (const int32_t*) pcmData + offset;
+
+        for (s = 0; s < count; s++, i32 += stride) frameBuf[s * nChannels + ch] = *i32;
+      }
+      else // EXHALE_PCM_F32
+      {
+        const float* f32 = (const float*) pcmData + offset;
+
+        for (s = 0; s < count; s++, f32 += stride)
+        {
+          const float f = *f32 * float (1 << 23); // * 2^23
+
+          frameBuf[s * nChannels + ch] = (f >= 8388607.0f ? 8388607 : (f <= -8388608.0f ? -8388608 : int32_t (f + (f < 0.0f ? -0.5f : 0.5f))));
+        }
+      }
+    }
+    m_streamFill += count;
+    n += count;
+
+    if (m_streamFill == nSamplesInFrame)
+    {
+      m_streamFill = 0;
+      if ((errorValue = encodeStreamFrame ()) > 0) return errorValue;
+    }
+  }
+  m_streamInput += numSamples;
+
+  return 0; // no error
+}
+
+unsigned ExhaleEncoder::setComplexity (const unsigned numSfbStates, const unsigned numTupleStates)
+{
+  if ((numSfbStates == 1) || (numSfbStates > SFB_MAX_C_STATES) || (numTupleStates > SFB_MAX_T_STATES))
+  {
+    return 1; // invalid arguments error
+  }
+  m_rdocStates[0] = (uint8_t) numSfbStates;
+  m_rdocStates[1] = (uint8_t) numTupleStates;
+
+  if (m_elementData[0] != nullptr) applyComplexity (); // update between frames
+
+  return 0; // no error
+}
+
+unsigned ExhaleEncoder::setFrameStats (ExhaleFrameStats* const frameStats)
+{
+  if (frameStats != nullptr) memset (frameStats, 0, sizeof (ExhaleFrameStats));
+
+  m_frameStats = frameStats;
+
+  return 0; // no error
+}
+
+unsigned ExhaleEncoder::setNumThreads (const unsigned numThreads)
+{
+  if ((numThreads > WP_MAX_NUM_WORKERS + 1) || (m_elementData[0] != nullptr))
+  {
+    return 1; // invalid arguments error, or initEncoder was called before
+  }
+  m_numThreads = (uint8_t) numThreads;
+
+  return 0; // no error
+}
+
+unsigned ExhaleEncoder::convertPlanarInput (const void* const channelData, int32_t* const int24Data, const unsigned numSamples)
+{
+  if ((channelData == nullptr) || (int24Data == nullptr))
+  {
+    return 1; // invalid arguments error
+  }
+#if EE_INPUT_AVX2
+  if (m_inputSimdPath)
+  {
+    convertToInt24AVX2 (channelData, m_inputFormat, m_inputFlags, int24Data, numSamples, m_ditherSeed);
+  }
+  else
+#endif
+  convertToInt24Scalar (channelData, m_inputFormat, m_inputFlags, int24Data, 0, numSamples, m_ditherSeed);
+
+  return 0; // no error
+}
+
+unsigned ExhaleEncoder::setPlanarInput (const void* const* const channelData, const ExhalePcmFormat pcmFormat, const unsigned inputFlags /*= 0*/)
+{
+  if (m_streamMode || (pcmFormat > EXHALE_PCM_F32) || (inputFlags > (EXHALE_INPUT_CLIP | EXHALE_INPUT_DITHER)))
+  {
+    return 1; // invalid arguments error, or stream mode (see pushPcmData)
+  }
+  m_inputFlags  = (uint8_t) inputFlags;
+  m_inputFormat = pcmFormat;
+  m_inputPlanar = channelData; // nullptr: interleaved m_pcm24Data
+
+  return 0; // no error
+}
+
+unsigned ExhaleEncoder::setTargetRtf (const unsigned rtfPercent, ExhaleStatsCallback statsCallback /*= nullptr*/, void* const statsContext /*= nullptr*/)
+{
+  if (rtfPercent > USHRT_MAX)
+  {
+    return 1; // invalid arguments error
+  }
+  m_rtfMeasured   = 0;
+  m_rtfTarget     = (uint16_t) rtfPercent;
+  m_statsCallback = statsCallback;
+  m_statsContext  = statsContext;
+
+  if ((rtfPercent == 0) && (m_cplxLevel > 0)) // guard off, back to full complexity
+  {
+    m_cplxLevel = 0;
+    if (m_elementData[0] != nullptr) applyComplexity ();
+  }
+
+  return 0; // no error
+}
+
 extern "C"
 {
 // C constructor
@@ -2309,4 +2882,115 @@ EXHALE_DECL unsigned exhaleEncodeFrame (ExhaleEncAPI* exhaleEnc)
   return USHRT_MAX; // error
 }
 
+// C complexity setter
+EXHALE_DECL unsigned exhaleSetComplexity (ExhaleEncAPI* exhaleEnc, const unsigned numSfbStates, const unsigned numTupleStates)
+{
+  if (exhaleEnc != NULL) return reinterpret_cast<ExhaleEncoder*> (exhaleEnc)->setComplexity (numSfbStates, numTupleStates);
+
+  return USHRT_MAX; // error
+}
+
+// C real-time factor guard setter
+EXHALE_DECL unsigned exhaleSetTargetRtf (ExhaleEncAPI* exhaleEnc, const unsigned rtfPercent, ExhaleStatsCallback statsCallback, void* const statsContext)
+{
+  if (exhaleEnc != NULL) return reinterpret_cast<ExhaleEncoder*> (exhaleEnc)->setTargetRtf (rtfPercent, statsCallback, statsContext);
+
+  return USHRT_MAX; // error
+}
+
+// C streaming input
+EXHALE_DECL unsigned exhalePushPcm (ExhaleEncAPI* exhaleEnc, const void* const pcmData, const unsigned numSamples, const unsigned pcmFormat, const bool planar)
+{
+  if (exhaleEnc != NULL) return reinterpret_cast<ExhaleEncoder*> (exhaleEnc)->pushPcmData (pcmData, numSamples, (ExhalePcmFormat) pcmFormat, planar);
+
+  return USHRT_MAX; // error
+}
+
+// C streaming end of input
+EXHALE_DECL unsigned exhaleFlush (ExhaleEncAPI* exhaleEnc)
+{
+  if (exhaleEnc != NULL) return reinterpret_cast<ExhaleEncoder*> (exhaleEnc)->flushPcmData ();
+
+  return USHRT_MAX; // error
+}
+
+// C streaming output
+EXHALE_DECL unsigned exhaleDrainAu (ExhaleEncAPI* exhaleEnc, unsigned char* const auBuffer, const unsigned auBufferSize, uint32_t* const auBytes,
+                                    int64_t* const auTimestamp)
+{
+  if (exhaleEnc != NULL) return reinterpret_cast<ExhaleEncoder*> (exhaleEnc)->drainAuData (auBuffer, auBufferSize, auBytes, auTimestamp);
+
+  return USHRT_MAX; // error
+}
+
+// C thread count setter
+EXHALE_DECL unsigned exhaleSetNumThreads (ExhaleEncAPI* exhaleEnc, const unsigned numThreads)
+{
+  if (exhaleEnc != NULL) return reinterpret_cast<ExhaleEncoder*> (exhaleEnc)->setNumThreads (numThreads);
+
+  return USHRT_MAX; // error
+}
+
+// C frame statistics setter
+EXHALE_DECL unsigned exhaleSetFrameStats (ExhaleEncAPI* exhaleEnc, ExhaleFrameStats* const frameStats)
+{
+  if (exhaleEnc != NULL) return reinterpret_cast<ExhaleEncoder*> (exhaleEnc)->setFrameStats (frameStats);
+
+  return USHRT_MAX; // error
+}
+
+// C planar input setter
+EXHALE_DECL unsigned exhaleSetPlanarInput (ExhaleEncAPI* exhaleEnc, const void* const* const channelData, const unsigned pcmFormat, const unsigned inputFlags)
+{
+  if (exhaleEnc != NULL) return reinterpret_cast<ExhaleEncoder*> (exhaleEnc)->setPlanarInput (channelData, (ExhalePcmFormat) pcmFormat, inputFlags);
+
+  return USHRT_MAX; // error
+}
+
+// C resampler constructor
+EXHALE_DECL ExhaleResAPI* exhaleCreateResampler (const unsigned inputRate, const unsigned outputRate, const unsigned numChannels,
+                                                 const unsigned maxOutLength)
+{
+  PolyphaseResampler* resampler = nullptr;
+
+  try
+  {
+    resampler = new PolyphaseResampler ();
+  }
+  catch (...)
+  {
+    return NULL; // memory allocation error
+  }
+  if (resampler->initResampler (inputRate, outputRate, numChannels, maxOutLength) > 0)
+  {
+    delete resampler;
+    return NULL; // invalid arguments or memory allocation error
+  }
+  return reinterpret_cast<ExhaleResAPI*> (resampler);
+}
+
+// C resampler destructor
+EXHALE_DECL unsigned exhaleDeleteResampler (ExhaleResAPI* resampler)
+{
+  if (resampler != NULL) { delete reinterpret_cast<PolyphaseResampler*> (resampler); return 0; }
+
+  return USHRT_MAX; // error
+}
+
+// C resampler input length
+EXHALE_DECL unsigned exhaleGetResamplerInput (ExhaleResAPI* resampler, const unsigned numOutSamples, const bool restart)
+{
+  if (resampler != NULL) return reinterpret_cast<PolyphaseResampler*> (resampler)->getInputLength (numOutSamples, restart);
+
+  return 0; // error
+}
+
+// C resampler
+EXHALE_DECL unsigned exhaleResample (ExhaleResAPI* resampler, int32_t* const pcmBuffer, const unsigned numOutSamples, const bool restart)
+{
+  if (resampler != NULL) return reinterpret_cast<PolyphaseResampler*> (resampler)->applyResampler (pcmBuffer, numOutSamples, restart);
+
+  return USHRT_MAX; // error
+}
+
 } // extern "C"
@@ -1,5 +1,5 @@
 /* exhaleEnc.h - header file for class providing Extended HE-AAC encoding capability
- * written by C. R. Helmrich, last modified in 2023 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -19,14 +19,22 @@
 #include "lappedTransform.h"
 #include "linearPrediction.h"
 #include "quantization.h"
+#include "sharedTables.h"
 #include "specAnalysis.h"
 #include "specGapFilling.h"
 #include "stereoProcessing.h"
 #include "tempAnalysis.h"
+#include "workerPool.h"
+#include <chrono>
 
 // constant and experimental macro
-#define WIN_SCALE double (1 << 23)
 #define EE_MORE_MSE              0 // 1-9: MSE optimized encoding with TNS disabled starting at bit-rate mode 1-9
+#define EE_QUIET_FRAMES          1 // 1: no MCLT, TNS, and quantization for elements with near-silent input
+#define EE_RTF_MAX_LEVEL         3 // number of complexity reduction steps of real-time factor guard
+#define EE_RTF_PERIOD            8 // number of frames between complexity updates of real-time factor guard
+#define EE_TIME_SIG_FRAMES       3 // spare frames in time signal buffers, history is moved every 4th frame
+#define EE_MAX_AU_BYTES   (9984 >> 3) // maximum AU size per channel incl. pre-roll, for internal AU buffer
+#define EE_INPUT_AVX2            SIMD_X86 // 1: use AVX2 planar input conversion if CPU supports it
 
 // channelConfigurationIndex setup
 typedef enum USAC_CCI : signed char
@@ -69,24 +77,36 @@ private:
   uint8_t         m_bitRateMode;
   USAC_CCI        m_channelConf;
   int32_t*        m_coreSignals[USAC_MAX_NUM_CHANNELS];
+  uint8_t         m_cplxLevel; // RTF guard's reduction
+  uint32_t        m_ditherSeed[8]; // 8-lane TPDF generator
   CoreCoderData*  m_elementData[USAC_MAX_NUM_ELEMENTS];
+  int32_t*        m_elemTempBuf[USAC_MAX_NUM_ELEMENTS]; // per-element temp buffer, [0] = m_tempIntBuf
   EntropyCoder    m_entropyCoder[USAC_MAX_NUM_CHANNELS];
   uint32_t        m_frameCount;
+  ExhaleFrameStats* m_frameStats; // nullptr: stats off
   USAC_CCFL       m_frameLength;
   int8_t          m_frequencyIdx;
   bool            m_indepFlag; // usacIndependencyFlag bit
   uint32_t        m_indepPeriod;
+  uint8_t         m_inputFlags;  // see ExhaleInputFlags
+  ExhalePcmFormat m_inputFormat; // of planar input data
+  const void* const* m_inputPlanar; // nullptr: m_pcm24Data
+  bool            m_inputSimdPath; // vectorized conversion
   LinearPredictor m_linPredictor; // for pre-roll est, TNS
   uint8_t*        m_mdctQuantMag[USAC_MAX_NUM_CHANNELS];
   int32_t*        m_mdctSignals[USAC_MAX_NUM_CHANNELS];
   int32_t*        m_mdstSignals[USAC_MAX_NUM_CHANNELS];
+  uint8_t         m_meanSpecCurr[USAC_MAX_NUM_CHANNELS];
   uint8_t         m_meanSpecPrev[USAC_MAX_NUM_CHANNELS]; // for
+  uint8_t         m_meanTempCurr[USAC_MAX_NUM_CHANNELS];
   uint8_t         m_meanTempPrev[USAC_MAX_NUM_CHANNELS]; // SBR
+  MemoryArena     m_memArena; // one block for all stream buffers
 #if !RESTRICT_TO_AAC
   bool            m_noiseFilling[USAC_MAX_NUM_ELEMENTS];
 #endif
   bool            m_nonMpegExt;
   uint8_t         m_numElements;
+  uint8_t         m_numThreads; // 0, 1: no element-parallel coding
   uint8_t         m_numSwbLong;
   uint8_t         m_numSwbShort;
   unsigned char*  m_outAuData;
@@ -95,46 +115,75 @@ private:
   uint8_t         m_perCorrHCurr[USAC_MAX_NUM_ELEMENTS];
   uint8_t         m_perCorrLCurr[USAC_MAX_NUM_ELEMENTS];
   uint8_t         m_priLength;
+  bool            m_quietElement[USAC_MAX_NUM_ELEMENTS]; // MCLT input near-silent
   uint32_t        m_rateFactor; // RC
+  uint8_t         m_rdocPasses[USAC_MAX_NUM_CHANNELS];
+  uint8_t         m_rdocStates[2]; // SFB, tuple states
+  uint32_t        m_rtfMeasured; // 1/16 %, smoothed
+  uint16_t        m_rtfTarget; // in %, 0: RTF guard off
   SfbGroupData*   m_scaleFacData[USAC_MAX_NUM_CHANNELS];
+  SharedTables*   m_sharedTables; // windows, LUTs, shared
   uint16_t        m_sfbLoudMem[2][26][32]; // loudness mem
-  SfbQuantizer    m_sfbQuantizer; // powerlaw quantization
+  SfbQuantizer    m_sfbQuantizer[USAC_MAX_NUM_ELEMENTS]; // powerlaw quantization, [el] for workers
   uint8_t         m_shiftValSBR; // SBR ratio for shifting
   SpecAnalyzer    m_specAnalyzer; // for spectral analysis
   uint32_t        m_specAnaCurr[USAC_MAX_NUM_CHANNELS];
+  ExhaleStatsCallback m_statsCallback; // for RTF guard
+  void*           m_statsContext;
+  std::chrono::steady_clock::time_point m_statsTime; // stage start
   uint8_t         m_specFlatPrev[USAC_MAX_NUM_CHANNELS];
 #if !RESTRICT_TO_AAC
-  SpecGapFiller   m_specGapFiller;// for noise/gap filling
+  SpecGapFiller   m_specGapFiller[USAC_MAX_NUM_ELEMENTS];// for noise/gap filling
 #endif
   StereoProcessor m_stereoCoder;  // for M/S stereo coding
+  std::vector<uint8_t>  m_streamAuData; // queued AUs
+  uint32_t        m_streamAuNext; // index of next AU
+  uint32_t        m_streamAuOffs; // offset of next AU
+  std::vector<uint32_t> m_streamAuSize;
+  uint64_t        m_streamAuTime; // count of drained AUs
+  bool            m_streamEnded; // flushPcmData called
+  uint32_t        m_streamFill;  // samples in PCM frame
+  uint32_t        m_streamFrames; // frames incl. look-ahead
+  uint64_t        m_streamInput; // samples pushed per ch.
+  bool            m_streamMode;  // owns PCM and AU buffer
   uint8_t         m_swbTableIdx;
   TempAnalyzer    m_tempAnalyzer; // for temporal analysis
   uint32_t        m_tempAnaCurr[USAC_MAX_NUM_CHANNELS];
   uint32_t        m_tempAnaNext[USAC_MAX_NUM_CHANNELS];
   uint8_t         m_tempFlatPrev[USAC_MAX_NUM_CHANNELS];
   int32_t*        m_tempIntBuf;  // temporary int32 buffer
+  uint32_t        m_timeSigOffset; // sliding window pos.
   int32_t*        m_timeSignals[USAC_MAX_NUM_CHANNELS];
 #if !RESTRICT_TO_AAC
   bool            m_timeWarping[USAC_MAX_NUM_ELEMENTS];
 #endif
-  int32_t*        m_timeWindowL[2];  // long window halves
-  int32_t*        m_timeWindowS[2]; // short window halves
   int16_t         m_tranLocCurr[USAC_MAX_NUM_CHANNELS];
   int16_t         m_tranLocNext[USAC_MAX_NUM_CHANNELS];
-  LappedTransform m_transform; // time-frequency transform
+  LappedTransform m_transform[USAC_MAX_NUM_ELEMENTS]; // time-frequency transform, [el] for workers
+  WorkerPool      m_workerPool; // for element-parallel coding
 
   // helper functions
+  void     applyComplexity    ();
   unsigned applyTnsToWinGroup (SfbGroupData& grpData, const uint8_t grpIndex, const uint8_t maxSfb, TnsData& tnsData,
                                const unsigned channelIndex, const unsigned n, const bool realOnlyCalc);
   unsigned eightShortGrouping (SfbGroupData& grpData, uint16_t* const grpOffsets,
                                int32_t* const mdctSignal, int32_t* const mdstSignal);
+  unsigned elementQuantCoding (const unsigned elementIndex);
+  static unsigned elementQuantCodingJob (void* const encoder, const unsigned elementIndex);
+  unsigned elementTransform   (const unsigned elementIndex);
+  static unsigned elementTransformJob   (void* const encoder, const unsigned elementIndex);
+  unsigned encodeStreamFrame  ();
+  void     fillFrameStats     (const unsigned auBytes);
   unsigned getOptParCorCoeffs (const SfbGroupData& grpData, const uint8_t maxSfb, TnsData& tnsData,
                                const unsigned channelIndex, const uint8_t firstGroupIndexToTest = 0);
   uint32_t getThr             (const unsigned channelIndex, const unsigned sfbIndex);
+  unsigned importPlanarInput  (const unsigned inputOffset, const unsigned numSamples, const unsigned timeSigOffset);
   unsigned psychBitAllocation ();
   unsigned quantizationCoding ();
   unsigned spectralProcessing ();
   unsigned temporalProcessing ();
+  void     updateComplexity   (const unsigned encodingMicroSec);
+  void     updateStageTime    (const ExhaleStatsStage stage);
 
 public:
 
@@ -150,9 +199,20 @@ public:
   // destructor
   virtual ~ExhaleEncoder ();
   // public functions
+  unsigned convertPlanarInput (const void* const channelData, int32_t* const int24Data, const unsigned numSamples); // see setPlanarInput
   unsigned encodeLookahead ();
   unsigned encodeFrame ();
   unsigned initEncoder (unsigned char* const audioConfigBuffer, uint32_t* const audioConfigBytes = nullptr);
+  // streaming interface, for encoders constructed with inputPcmData = outputAuData = nullptr
+  unsigned drainAuData   (unsigned char* const auBuffer, const unsigned auBufferSize, uint32_t* const auBytes, int64_t* const auTimestamp = nullptr);
+  unsigned flushPcmData  (); // zero-pads the input and encodes all pending samples
+  unsigned pushPcmData   (const void* const pcmData, const unsigned numSamples, const ExhalePcmFormat pcmFormat, const bool planar = false);
+  unsigned getStreamDelay () const; // encoder delay in samples, incl. SBR delay
+  unsigned setComplexity (const unsigned numSfbStates, const unsigned numTupleStates); // RDOC trellis, 0: default
+  unsigned setFrameStats (ExhaleFrameStats* const frameStats); // filled by encodeFrame, nullptr: off
+  unsigned setNumThreads (const unsigned numThreads); // call before initEncoder, output remains bit-exact
+  unsigned setPlanarInput (const void* const* const channelData, const ExhalePcmFormat pcmFormat, const unsigned inputFlags = 0);
+  unsigned setTargetRtf  (const unsigned rtfPercent, ExhaleStatsCallback statsCallback = nullptr, void* const statsContext = nullptr);
 
 }; // ExhaleEncoder
 
@@ -1,5 +1,5 @@
 /* exhaleLibPch.cpp - pre-compiled source file for classes of exhaleLib coding library
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -9,41 +9,108 @@
  */
 
 #include "exhaleLibPch.h"
+#if MEM_HUGE_PAGES && defined (__linux__)
+# include <sys/mman.h>
+#endif
+#if SIMD_X86 && defined (_MSC_VER)
+# include <immintrin.h> // _xgetbv
+# include <intrin.h> // __cpuid
+#endif
+
+static bool simdDisabled = false; // see setScalarOnly()
 
 // public bit-stream functions
-void OutputStream::reset () // clear writer states and byte buffer
+void OutputStream::byteAlign () // write '0' bits until byte-aligned, then flush held bytes
+{
+  const uint32_t padBitCount = (8 - heldBitCount) & 7;
+
+  heldBitChunk <<= padBitCount;
+  heldBitCount += padBitCount;
+  flushBytes (heldBitCount >> 3);
+}
+
+void OutputStream::flushBytes (const uint32_t numBytes) // write held bytes, drop those beyond limit
+{
+  for (uint32_t i = 0; i < numBytes; i++)
+  {
+    heldBitCount -= 8;
+    if (byteCount < byteLimit) byteBuffer[byteCount] = uint8_t (heldBitChunk >> heldBitCount);
+    byteCount++;
+  }
+}
+
+void OutputStream::reset (uint8_t* const buffer, const uint32_t bufferSize)
 {
   heldBitChunk = 0;
   heldBitCount = 0;
-  stream.clear ();
+  byteBuffer   = buffer;
+  byteCount    = 0;
+  byteLimit    = (buffer == nullptr ? 0 : bufferSize);
 }
 
-void OutputStream::write (const uint32_t bitChunk, const uint8_t bitCount)
+// public memory arena functions
+unsigned MemoryArena::allocate (const size_t arenaSize)
 {
-  if (bitCount == 0) return; // nothing to do for length 0, max. length is 32
+  release ();
+  if (arenaSize == 0) return 0;
 
-  const uint8_t totalBitCount   = bitCount + heldBitCount;
-  const uint8_t totalByteCount  = totalBitCount >> 3;  // to be written
-  const uint8_t newHeldBitCount = totalBitCount & 7; // not yet written
-  const uint8_t newHeldBitChunk = (bitChunk << (8 - newHeldBitCount)) & UCHAR_MAX;
+#if MEM_HUGE_PAGES && defined (__linux__)
+  if (arenaSize >= (1u << 21)) // at least one 2-MB page, use an anonymous mapping
+  {
+    const size_t mapSize = (arenaSize + (1u << 21) - 1) & ~size_t ((1u << 21) - 1);
+    void* const  mapAddr = mmap (nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-  if (totalByteCount == 0) // not enough bits to write, only update held bits
+    if (mapAddr != MAP_FAILED)
+    {
+# ifdef MADV_HUGEPAGE
+      madvise (mapAddr, mapSize, MADV_HUGEPAGE); // only a hint, failure is harmless
+# endif
+      memBase   = memBlock = (uint8_t*) mapAddr;
+      memSize   = mapSize;
+      memMapped = true;
+
+      return 0; // no error, pages are zeroed
+    }
+  }
+#endif
+  if ((memBase = (uint8_t*) calloc (arenaSize + MEM_ALIGN - 1, sizeof (uint8_t))) == nullptr)
   {
-    heldBitChunk |= newHeldBitChunk;
+    return 2; // memory allocation error
   }
-  else // write bits
+  memBlock = (uint8_t*) MEM_ALIGN_SIZE (memBase);
+  memSize  = arenaSize;
+
+  return 0; // no error
+}
+
+void MemoryArena::release ()
+{
+#if MEM_HUGE_PAGES && defined (__linux__)
+  if (memMapped && (memBase != nullptr))
   {
-    const uint32_t writtenChunk = (heldBitChunk << uint32_t ((bitCount - newHeldBitCount) & ~7)) | (bitChunk >> newHeldBitCount);
-    switch (totalByteCount)
-    {
-      case 4: stream.push_back (writtenChunk >> 24);
-      case 3: stream.push_back (writtenChunk >> 16);
-      case 2: stream.push_back (writtenChunk >> 8);
-      case 1: stream.push_back (writtenChunk);
-    }
-    heldBitChunk = newHeldBitChunk;
+    munmap (memBase, memSize);
+    memBase = nullptr;
   }
-  heldBitCount = newHeldBitCount;
+#endif
+  MFREE (memBase);
+  memBase   = memBlock = nullptr;
+  memSize   = memUsed  = 0;
+  memMapped = false;
+}
+
+void* MemoryArena::take (const size_t bufferSize)
+{
+  const size_t alignedSize = MEM_ALIGN_SIZE (bufferSize);
+  uint8_t* buffer;
+
+  if ((memBlock == nullptr) || (alignedSize == 0) || (alignedSize > memSize - memUsed))
+  {
+    return nullptr; // arena exhausted
+  }
+  buffer = &memBlock[memUsed];
+  memUsed += alignedSize;
+
+  return buffer;
 }
 
 // ISO/IEC 23003-3, Table 67
@@ -275,3 +342,47 @@ unsigned toSamplingRate (const int8_t samplingFrequencyIndex)
   }
   return allowedSamplingRates[samplingFrequencyIndex > AAC_NUM_SAMPLE_RATES ? samplingFrequencyIndex - 2 : samplingFrequencyIndex];
 }
+
+// public CPU feature functions
+bool isAvx2Supported ()
+{
+#if SIMD_X86
+  if (simdDisabled) return false;
+# ifdef _MSC_VER
+  int cpuInfo[4];
+
+  __cpuid (cpuInfo, 1);
+  if ((cpuInfo[2] & (1 << 27)) == 0 || (_xgetbv (0) & 6) != 6) return false; // no OS support for AVX
+  __cpuidex (cpuInfo, 7, 0);
+
+  return (cpuInfo[1] & (1 << 5)) != 0;
+# else
+  return __builtin_cpu_supports ("avx2") != 0;
+# endif
+#else
+  return false;
+#endif
+}
+
+bool isSse41Supported ()
+{
+#if SIMD_X86
+  if (simdDisabled) return false;
+# ifdef _MSC_VER
+  int cpuInfo[4];
+
+  __cpuid (cpuInfo, 1);
+
+  return (cpuInfo[2] & (1 << 19)) != 0;
+# else
+  return __builtin_cpu_supports ("sse4.1") != 0;
+# endif
+#else
+  return false;
+#endif
+}
+
+void setScalarOnly (const bool scalarOnly)
+{
+  simdDisabled = scalarOnly;
+}
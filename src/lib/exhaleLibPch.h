@@ -1,5 +1,5 @@
 /* exhaleLibPch.h - pre-compiled header file for classes of exhaleLib coding library
- * written by C. R. Helmrich, last modified in 2020 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -63,6 +63,26 @@
 # define MFREE(x)              if (x != nullptr) { free ((void*) x); x = nullptr; }
 #endif
 
+#define MEM_ALIGN              64 // byte alignment of buffers in a MemoryArena
+#define MEM_ALIGN_SIZE(x)      (((size_t) (x) + MEM_ALIGN - 1) & ~size_t (MEM_ALIGN - 1))
+#define MEM_HUGE_PAGES          1 // Linux: map arenas of 2 MB or more via huge pages
+
+#if defined (_M_X64) || defined (_M_IX86) || defined (__x86_64__) || defined (__i386__)
+# define SIMD_X86               1 // 1: x86 SIMD kernels, selected at runtime via CPU checks
+#else
+# define SIMD_X86               0
+#endif
+
+#if SIMD_X86
+# ifdef _MSC_VER
+#  define TARGET_AVX2
+#  define TARGET_SSE41
+# else
+#  define TARGET_AVX2           __attribute__ ((target ("avx2")))
+#  define TARGET_SSE41          __attribute__ ((target ("sse4.1")))
+# endif
+#endif
+
 // usacElementType[el] definition
 typedef enum ELEM_TYPE : int8_t
 {
@@ -148,18 +168,58 @@ struct CoreCoderData
 // bit-stream encoding data struct
 struct OutputStream
 {
-  uint8_t heldBitChunk; // bits not yet flushed to buffer
-  uint8_t heldBitCount; // number of bits not yet flushed
-  std::vector <uint8_t> stream; // FIFO bit-stream buffer
+  uint64_t heldBitChunk; // bits not yet flushed to buffer
+  uint32_t heldBitCount; // number of bits not yet flushed
+  uint8_t* byteBuffer; // caller-provided output buffer
+  uint32_t byteCount; // number of bytes flushed so far
+  uint32_t byteLimit; // bytes beyond limit are dropped
   // constructor
-  OutputStream () { reset (); }
-  // destructor
-  ~OutputStream() { stream.clear (); }
+  OutputStream () { reset (nullptr, 0); }
   // public functions
-  void reset ();   // clear writer states and byte buffer
-  void write (const uint32_t bitChunk, const uint8_t bitCount);
+  void     byteAlign ();  // write 0s for alignment, flush
+  uint32_t getBitCount () const { return (byteCount << 3) + heldBitCount; }
+  void     reset (uint8_t* const buffer, const uint32_t bufferSize); // clear writer states
+  void     write (const uint32_t bitChunk, const uint8_t bitCount)  // max. length is 32
+  {
+    heldBitChunk = (heldBitChunk << bitCount) | (bitChunk & ((uint64_t (1) << bitCount) - 1u));
+    if ((heldBitCount += bitCount) < 32) return;
+    if (byteCount + 4 > byteLimit) { flushBytes (4); return; }
+
+    heldBitCount -= 32; // write 32 bits, big-endian
+    const uint32_t bitWord = uint32_t (heldBitChunk >> heldBitCount);
+    uint8_t* const byteOut = &byteBuffer[byteCount];
+
+    byteOut[0] = uint8_t (bitWord >> 24);
+    byteOut[1] = uint8_t (bitWord >> 16);
+    byteOut[2] = uint8_t (bitWord >>  8);
+    byteOut[3] = uint8_t (bitWord);
+    byteCount += 4;
+  }
+private:
+  void     flushBytes (const uint32_t numBytes); // bounded
 }; // OutputStream
 
+// contiguous memory arena struct
+struct MemoryArena
+{
+  uint8_t* memBase;  // start of allocation, for release
+  uint8_t* memBlock; // MEM_ALIGN aligned start of arena
+  size_t   memSize;  // size of memBlock in bytes
+  size_t   memUsed;  // bytes handed out by take()
+  bool     memMapped; // 1: huge-page mapping, 0: heap
+  // constructor
+  MemoryArena () { memBase = memBlock = nullptr; memSize = memUsed = 0; memMapped = false; }
+  // destructor
+  ~MemoryArena () { release (); }
+  // public functions
+  unsigned allocate (const size_t arenaSize); // zero-initialized, size from MEM_ALIGN_SIZE sums
+  void     release  ();
+  void*    take     (const size_t bufferSize); // MEM_ALIGN aligned, nullptr if arena is exhausted
+private:
+  MemoryArena (const MemoryArena&) = delete;
+  MemoryArena& operator= (const MemoryArena&) = delete;
+}; // MemoryArena
+
 // fast calculation of sqrt (256 - x): (4 + eightTimesSqrt256Minus[x]) >> 3, for 0 <= x <= 255
 const uint8_t eightTimesSqrt256Minus[256] = {
   128, 128, 127, 127, 127, 127, 126, 126, 126, 126, 125, 125, 125, 125, 124, 124, 124, 124, 123, 123, 123, 123, 122, 122, 122, 122,
@@ -205,4 +265,9 @@ inline uint64_t square (const int64_t i) { return i * i; }
 int8_t toSamplingFrequencyIndex (const unsigned samplingRate);
 unsigned toSamplingRate (const int8_t samplingFrequencyIndex);
 
+// public CPU feature functions, SIMD code paths are selected once at class initialization
+bool isAvx2Supported ();
+bool isSse41Supported ();
+void setScalarOnly (const bool scalarOnly); // 1: report no SIMD support, e.g. to test scalar code
+
 #endif // _EXHALE_LIB_PCH_H_
@@ -0,0 +1,182 @@
+/* halfBandFilter.cpp - source file for class providing polyphase half-band downsampling for SBR
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#include "exhaleLibPch.h"
+#include "halfBandFilter.h"
+#if HB_FILTER_AVX2
+# include <immintrin.h>
+#endif
+
+static const int16_t lpfc12[65] = {  // 50% low-pass filter coefficients
+  // 269-pt. sinc windowed by 0.409 * cos(0*pi.*t) - 0.5 * cos(2*pi.*t) + 0.091 * cos(4*pi.*t)
+  17887, -27755, 16590, -11782, 9095, -7371, 6166, -5273, 4582, -4029, 3576, -3196, 2873,
+  -2594, 2350, -2135, 1944, -1773, 1618, -1478, 1351, -1235, 1129, -1032, 942, -860, 784,
+  -714, 650, -591, 536, -485, 439, -396, 357, -321, 287, -257, 229, -204, 181, -160, 141,
+  -124, 108, -95, 82, -71, 61, -52, 44, -37, 31, -26, 21, -17, 14, -11, 8, -6, 5, -3, 2, -1, 1
+};
+
+static const int16_t lpfc34[128] = { // 25% low-pass filter coefficients
+  // see also A. H. Nuttall, "Some Windows with Very Good Sidelobe Behavior," IEEE, Feb. 1981.
+  3 /*<<16*/, 26221, -8914, 19626, 0, -11731, 13789, -8331, 0, 6431, -8148, 5212, 0, -4360,
+  5688, -3728, 0, 3240, -4291, 2849, 0, -2529, 3378, -2260, 0, 2032, -2729, 1834, 0, -1662,
+  2240, -1510, 0, 1375, -1856, 1253, 0, -1144, 1546, -1045, 0, 955, -1292, 873, 0, -798,
+  1079, -729, 0, 666, -900, 608, 0, -555, 748, -505, 0, 459, -620, 418, 0, -379, 510, -343,
+  0, 310, -417, 280, 0, -252, 338, -227, 0, 203, -272, 182, 0, -162, 216, -144, 0, 128, -170,
+  113, 0, -100, 132, -88, 0, 77, -101, 67, 0, -58, 76, -50, 0, 43, -56, 37, 0, -31, 41, -26,
+  0, 22, -28, 18, 0, -15, 19, -12, 0, 10, -12, 8, 0, -6, 7, -4, 0, 3, -4, 2, 0, -1, 2, -1
+};
+
+// static helper functions
+static void applyFilterScalar (const int32_t* hrSig, const int nOutSamples, const int bandPassPhase,
+                               int64_t* const lowPassOut, int64_t* const bandPassOut)
+{
+  for (int j = 0; j < nOutSamples; j++, hrSig += 2)
+  {
+    int64_t r  = ((int64_t) hrSig[0] * (1 << 17)) + (hrSig[-1] + (int64_t) hrSig[1]) * -2*SHRT_MIN;
+    int16_t s;
+    unsigned u;
+
+    for (u = 65, s = 129; u > 0; s -= 2) r += (hrSig[-s] + (int64_t) hrSig[s]) * lpfc12[--u];
+
+    lowPassOut[j] = r; // low-pass at half rate
+
+    if ((j & 1) == bandPassPhase) // quarter-rate mid-frequency SBR signal
+    {
+      r  = ((3 * (int64_t) hrSig[0]) * (1 << 16)) - (hrSig[-1] + (int64_t) hrSig[1]) * SHRT_MIN - r;
+      r += (hrSig[-2] + (int64_t) hrSig[2]) * SHRT_MIN;
+
+      for (s = 127; s > 0; s--/*u = s*/) r += (hrSig[-s] + (int64_t) hrSig[s]) * lpfc34[s];
+
+      bandPassOut[j] = r; // SBR env. band-pass at quarter rate
+    }
+  }
+}
+
+#if HB_FILTER_AVX2
+static TARGET_AVX2 void applyFilterAVX2 (const int32_t* const evenSig, const int32_t* const oddSig, const int nOutSamples,
+                                         const int bandPassPhase, const int32_t* const lpCoeffsOdd, const int32_t* const bpCoeffsEven,
+                                         const int32_t* const bpCoeffsOdd, int64_t* const lowPassOut, int64_t* const bandPassOut)
+{
+  // bit-exact 8-way version of applyFilterScalar (), the symmetric tap pairs are folded in 32 bit
+  // (exact for 24-bit PCM) before being multiplied into 64-bit sums with the even and odd lanes
+  const __m128i bpShift = _mm_cvtsi32_si128 (32 * bandPassPhase);
+  int64_t bpSum[4];
+
+  for (int j = 0; j < nOutSamples; j += 8)
+  {
+    const int32_t* const evenSigJ = &evenSig[j];
+    const int32_t* const oddSigJ  = &oddSig[j];
+    __m256i p = _mm256_loadu_si256 ((const __m256i*) evenSigJ);
+    __m256i lpSumE, lpSumO, bpSum8;
+    int k;
+
+    p = _mm256_add_epi32 (p, p); // center taps
+    lpSumE = _mm256_mul_epi32 (p, _mm256_set1_epi32 (1 << 16));
+    lpSumO = _mm256_mul_epi32 (_mm256_srli_epi64 (p, 32), _mm256_set1_epi32 (1 << 16));
+    bpSum8 = _mm256_mul_epi32 (_mm256_srl_epi64 (p, bpShift), _mm256_set1_epi32 (bpCoeffsEven[0]));
+
+    for (k = 0; k < HB_NUM_LP_TAPS; k++) // odd input phase, shared by both filters
+    {
+      const __m256i c = _mm256_set1_epi32 (lpCoeffsOdd[k]);
+      __m256i pO;
+
+      p  = _mm256_add_epi32 (_mm256_loadu_si256 ((const __m256i*) &oddSigJ[k]), _mm256_loadu_si256 ((const __m256i*) &oddSigJ[-1 - k]));
+      pO = _mm256_srli_epi64 (p, 32);
+      lpSumE = _mm256_add_epi64 (lpSumE, _mm256_mul_epi32 (p,  c));
+      lpSumO = _mm256_add_epi64 (lpSumO, _mm256_mul_epi32 (pO, c));
+      if (k < HB_NUM_BP_TAPS)
+      {
+        bpSum8 = _mm256_add_epi64 (bpSum8, _mm256_mul_epi32 (bandPassPhase ? pO : p, _mm256_set1_epi32 (bpCoeffsOdd[k])));
+      }
+    }
+    for (k = 1; k < HB_NUM_BP_TAPS; k++) // even input phase, band-pass filter only
+    {
+      if (bpCoeffsEven[k] == 0) continue;
+
+      p = _mm256_add_epi32 (_mm256_loadu_si256 ((const __m256i*) &evenSigJ[k]), _mm256_loadu_si256 ((const __m256i*) &evenSigJ[-k]));
+      bpSum8 = _mm256_add_epi64 (bpSum8, _mm256_mul_epi32 (_mm256_srl_epi64 (p, bpShift), _mm256_set1_epi32 (bpCoeffsEven[k])));
+    }
+
+    // reorder the even and odd output lanes and store
+    p      = _mm256_unpacklo_epi64 (lpSumE, lpSumO);
+    lpSumO = _mm256_unpackhi_epi64 (lpSumE, lpSumO);
+    _mm256_storeu_si256 ((__m256i*) &lowPassOut[j    ], _mm256_permute2x128_si256 (p, lpSumO, 0x20));
+    _mm256_storeu_si256 ((__m256i*) &lowPassOut[j + 4], _mm256_permute2x128_si256 (p, lpSumO, 0x31));
+    _mm256_storeu_si256 ((__m256i*) bpSum, bpSum8);
+
+    for (k = 0; k < 4; k++)
+    {
+      const int i = j + bandPassPhase + 2 * k;
+
+      bandPassOut[i] = bpSum[k] - lowPassOut[i];
+    }
+  }
+}
+#endif // HB_FILTER_AVX2
+
+// constructor
+HalfBandFilter::HalfBandFilter ()
+{
+  int k;
+
+  // merge the center and +-1, +-2 taps of applyFilterScalar () into the phase coefficients
+  for (k = 0; k < HB_NUM_LP_TAPS; k++) m_lpCoeffsOdd[k] = lpfc12[k];
+  m_lpCoeffsOdd[0] += 1 << 16;
+  for (k = 0; k < HB_NUM_BP_TAPS; k++)
+  {
+    m_bpCoeffsEven[k] = lpfc34[2 * k];
+    m_bpCoeffsOdd [k] = lpfc34[2 * k + 1];
+  }
+  m_bpCoeffsEven[0]  = 3 << 15; // applied twice
+  m_bpCoeffsEven[1] += SHRT_MIN;
+  m_bpCoeffsOdd [0] -= SHRT_MIN;
+
+  memset (m_bandPassOut, 0, (HB_MAX_OUT_LENGTH + 8) * sizeof (int64_t));
+  memset (m_lowPassOut,  0, (HB_MAX_OUT_LENGTH + 8) * sizeof (int64_t));
+  memset (m_phaseEven,   0, HB_PHASE_LENGTH * sizeof (int32_t));
+  memset (m_phaseOdd,    0, HB_PHASE_LENGTH * sizeof (int32_t));
+#if HB_FILTER_AVX2
+  m_filterSimdPath = isAvx2Supported ();
+#else
+  m_filterSimdPath = false;
+#endif
+}
+
+// public functions
+unsigned HalfBandFilter::applyFilter (const int32_t* const hrSig, const int nOutSamples, const int bandPassPhase)
+{
+  if ((hrSig == nullptr) || (nOutSamples <= 0) || (nOutSamples > HB_MAX_OUT_LENGTH) || (bandPassPhase & ~1))
+  {
+    return 1; // invalid arguments error
+  }
+
+#if HB_FILTER_AVX2
+  if (m_filterSimdPath)
+  {
+    int32_t* const evenSig = &m_phaseEven[HB_PHASE_OFFSET];
+    int32_t* const oddSig  = &m_phaseOdd [HB_PHASE_OFFSET];
+    const int phaseEnd = nOutSamples + HB_NUM_LP_TAPS - 1;
+    int m;
+
+    // split input into its polyphase components, zero-padded beyond the filter supports
+    for (m = 1 - HB_NUM_LP_TAPS; m < phaseEnd; m++) evenSig[m] = hrSig[2 * m];
+    for (m = 0 - HB_NUM_LP_TAPS; m < phaseEnd; m++) oddSig[m]  = hrSig[2 * m + 1];
+    memset (&evenSig[phaseEnd], 0, (HB_PHASE_OFFSET + 1 - HB_NUM_LP_TAPS) * sizeof (int32_t));
+    memset (&oddSig [phaseEnd], 0, (HB_PHASE_OFFSET + 1 - HB_NUM_LP_TAPS) * sizeof (int32_t));
+
+    applyFilterAVX2 (evenSig, oddSig, nOutSamples, bandPassPhase, m_lpCoeffsOdd, m_bpCoeffsEven, m_bpCoeffsOdd,
+                     m_lowPassOut, m_bandPassOut);
+  }
+  else
+#endif
+  applyFilterScalar (hrSig, nOutSamples, bandPassPhase, m_lowPassOut, m_bandPassOut);
+
+  return 0; // no error
+}
@@ -0,0 +1,51 @@
+/* halfBandFilter.h - header file for class providing polyphase half-band downsampling for SBR
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#ifndef _HALF_BAND_FILTER_H_
+#define _HALF_BAND_FILTER_H_
+
+#include "exhaleLibPch.h"
+
+// constants, experimental macros
+#define HB_MAX_OUT_LENGTH    1024 // output samples per call
+#define HB_NUM_LP_TAPS         65 // odd-phase tap pairs, 50%
+#define HB_NUM_BP_TAPS         64 // tap pairs per phase, 25%
+#define HB_PHASE_OFFSET        72 // filter history per phase
+#define HB_PHASE_LENGTH  (HB_MAX_OUT_LENGTH + 2 * HB_PHASE_OFFSET)
+#define HB_FILTER_AVX2          SIMD_X86 // 1: use AVX2 FIR kernel if CPU supports it
+
+// polyphase half-band filter class
+class HalfBandFilter
+{
+private:
+
+  // member variables
+  int64_t  m_bandPassOut[HB_MAX_OUT_LENGTH + 8]; // unrounded quarter-rate output
+  int32_t  m_bpCoeffsEven[HB_NUM_BP_TAPS];
+  int32_t  m_bpCoeffsOdd [HB_NUM_BP_TAPS];
+  bool     m_filterSimdPath; // runtime-dispatched vectorized FIR
+  int32_t  m_lpCoeffsOdd [HB_NUM_LP_TAPS];
+  int64_t  m_lowPassOut[HB_MAX_OUT_LENGTH + 8]; // unrounded half-rate output
+  int32_t  m_phaseEven[HB_PHASE_LENGTH]; // deinterleaved input samples
+  int32_t  m_phaseOdd [HB_PHASE_LENGTH];
+
+public:
+
+  // constructor
+  HalfBandFilter ();
+  // destructor
+  ~HalfBandFilter () { }
+  // public functions
+  unsigned applyFilter (const int32_t* const hrSig, const int nOutSamples, const int bandPassPhase);
+  const int64_t* getBandPassOutput () const { return m_bandPassOut; }
+  const int64_t* getLowPassOutput  () const { return m_lowPassOut; }
+}; // HalfBandFilter
+
+#endif // _HALF_BAND_FILTER_H_
@@ -1,5 +1,5 @@
 /* lappedTransform.cpp - source file for class providing time-frequency transformation
- * written by C. R. Helmrich, last modified in 2019 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -15,35 +15,11 @@
 
 # pragma intrinsic (_BitScanReverse)
 #endif
+#if LT_FFT_SSE41
+# include <smmintrin.h>
+#endif
 
 // static helper functions
-static short* createPermutTable (const short tableSize)
-{
-  const short lOver2 = tableSize >> 1;
-  short* permutTable = nullptr;
-  short  i = 0;
-
-  if ((permutTable = (short*) malloc (tableSize * sizeof (short))) == nullptr)
-  {
-    return nullptr; // allocation error
-  }
-
-  permutTable[0] = 0;
-  for (short s = 1; s < tableSize; s++)
-  {
-    short l = lOver2;
-
-    while (i >= l)
-    {
-      i -= l;
-      l >>= 1;
-    }
-    permutTable[s] = (i += l);
-  }
-
-  return permutTable;
-}
-
 static inline int shortIntLog2 (uint16_t s)
 {
 #ifdef _MSC_VER
@@ -62,6 +38,58 @@ static inline int shortIntLog2 (uint16_t s)
 #endif
 }
 
+#if LT_FFT_SSE41
+// four rounded (a * b +/- c * d) >> LUT_SHIFT with 64-bit products, bit-exact to scalar code
+static TARGET_SSE41 inline __m128i rotateSSE41 (const __m128i a, const __m128i b, const __m128i c, const __m128i d,
+                                                const bool subtract)
+{
+  const __m128i off = _mm_set1_epi64x (LUT_OFFSET);
+  const __m128i abE = _mm_mul_epi32 (a, b); // even lanes
+  const __m128i cdE = _mm_mul_epi32 (c, d);
+  const __m128i abO = _mm_mul_epi32 (_mm_srli_epi64 (a, 32), _mm_srli_epi64 (b, 32)); // odd
+  const __m128i cdO = _mm_mul_epi32 (_mm_srli_epi64 (c, 32), _mm_srli_epi64 (d, 32));
+  const __m128i sumE = _mm_add_epi64 (subtract ? _mm_sub_epi64 (abE, cdE) : _mm_add_epi64 (abE, cdE), off);
+  const __m128i sumO = _mm_add_epi64 (subtract ? _mm_sub_epi64 (abO, cdO) : _mm_add_epi64 (abO, cdO), off);
+
+  // bits 31-62 of each sum hold the result, so logical shifts are sufficient
+  return _mm_blend_epi16 (_mm_srli_epi64 (sumE, LUT_SHIFT), _mm_slli_epi64 (sumO, 32 - LUT_SHIFT), 0xCC);
+}
+
+static TARGET_SSE41 void applyFFTStagesSSE41 (int32_t* const iR, int32_t* const iI, const int l, int l2, int l3,
+                                              const int32_t* const fftHalfCos, const int32_t* const fftHalfSin)
+{
+  while (l2 < l) // radix-2 stages with at least 4 butterflies per rotation
+  {
+    const int l1 = l2;
+    l2 <<= 1;
+    l3 >>= 1;
+
+    for (int j = 0; j < l1; j += 4)
+    {
+      const __m128i cosjl3 = _mm_set_epi32 (fftHalfCos[(j + 3) * l3], fftHalfCos[(j + 2) * l3], fftHalfCos[(j + 1) * l3], fftHalfCos[j * l3]);
+      const __m128i sinjl3 = _mm_set_epi32 (fftHalfSin[(j + 3) * l3], fftHalfSin[(j + 2) * l3], fftHalfSin[(j + 1) * l3], fftHalfSin[j * l3]);
+
+      for (int i = j; i < l; i += l2)
+      {
+        __m128i* const pR0 = (__m128i*) &iR[i];
+        __m128i* const pI0 = (__m128i*) &iI[i];
+        __m128i* const pR1 = (__m128i*) &iR[i + l1];
+        __m128i* const pI1 = (__m128i*) &iI[i + l1];
+        const __m128i iR0  = _mm_loadu_si128 (pR0);
+        const __m128i iI0  = _mm_loadu_si128 (pI0);
+        const __m128i iR1  = _mm_loadu_si128 (pR1);
+        const __m128i iI1  = _mm_loadu_si128 (pI1);
+        const __m128i rotR = rotateSSE41 (cosjl3, iR1, sinjl3, iI1, false); // clockwise
+        const __m128i rotI = rotateSSE41 (cosjl3, iI1, sinjl3, iR1, true);  // rotation
+
+        _mm_storeu_si128 (pR1, _mm_add_epi32 (iR0, rotR));  _mm_storeu_si128 (pR0, _mm_sub_epi32 (iR0, rotR));
+        _mm_storeu_si128 (pI1, _mm_add_epi32 (iI0, rotI));  _mm_storeu_si128 (pI0, _mm_sub_epi32 (iI0, rotI));
+      }
+    }
+  }
+}
+#endif // LT_FFT_SSE41
+
 // private helper functions
 void LappedTransform::applyHalfSizeFFT (int32_t* const iR/*eal*/, int32_t* const iI/*mag*/, const bool shortTransform) // works in-place
 {
@@ -111,6 +139,28 @@ void LappedTransform::applyHalfSizeFFT (int32_t* const iR/*eal*/, int32_t* const
     }
   }
 
+#if LT_FFT_SSE41
+  if (m_fftSimdPath && (l >= 8))
+  {
+    // first two stages as one radix-4 pass, its rotations by 0 and -90 degrees are exact
+    for (int i = 0; i < l; i += 4)
+    {
+      const int32_t r0 = iR[i    ] + iR[i + 1], r1 = iR[i    ] - iR[i + 1];
+      const int32_t r2 = iR[i + 2] + iR[i + 3], r3 = iR[i + 2] - iR[i + 3];
+      const int32_t i0 = iI[i    ] + iI[i + 1], i1 = iI[i    ] - iI[i + 1];
+      const int32_t i2 = iI[i + 2] + iI[i + 3], i3 = iI[i + 2] - iI[i + 3];
+
+      iR[i    ] = r0 + r2;  iI[i    ] = i0 + i2;
+      iR[i + 1] = r1 + i3;  iI[i + 1] = i1 - r3;
+      iR[i + 2] = r0 - r2;  iI[i + 2] = i0 - i2;
+      iR[i + 3] = r1 - i3;  iI[i + 3] = i1 + r3;
+    }
+    // remaining stages with vectorized butterflies
+    applyFFTStagesSSE41 (iR, iI, l, 4, l3 >> 2, m_fftHalfCos, m_fftHalfSin);
+
+    return;
+  }
+#endif
   // get length-l Fast Fourier Transform (FFT)
   for (int k = shortIntLog2 ((uint16_t) l) - 1; k >= 0; k--)
   {
@@ -138,7 +188,7 @@ void LappedTransform::applyHalfSizeFFT (int32_t* const iR/*eal*/, int32_t* const
 }
 
 void LappedTransform::windowAndFoldInL (const int32_t* inputL, const bool shortTransform, const bool kbdWindowL, const bool lowOverlapL,
-                                        const bool mdstKernel, int32_t* const output)
+                                        int32_t* const outMdct, int32_t* const outMdst)
 {
   const unsigned ws = (kbdWindowL ? 1 : 0); // shape
   const int32_t* wl = (lowOverlapL ? m_timeWindowS[ws] : m_timeWindowL[ws]);
@@ -149,36 +199,23 @@ void LappedTransform::windowAndFoldInL (const int32_t* inputL, const bool shortT
   const int Mm1mO   = Mm1 - Mo2mO; // overlap offset
   int n;
 
-  if (mdstKernel) // time-reversal and TDA sign flip
+  // MDST kernel: time-reversal and TDA sign flip, MDCT kernel: neither, both share the window products
+  for (n = Mo2m1; n >= Mo2mO; n--) // windowed pt.
   {
-    for (n = Mo2m1; n >= Mo2mO; n--) // windowed pt.
-    {
-      const int64_t i64 = (int64_t) inputL[Mm1 - n] * wl[Mm1mO - n] + (int64_t) inputL[n] * wl[n - Mo2mO];
+    const int64_t i64R = (int64_t) inputL[Mm1 - n] * wl[Mm1mO - n];
+    const int64_t i64L = (int64_t) inputL[n] * wl[n - Mo2mO];
 
-      output[Mo2m1 - n] = int32_t ((i64 + WIN_OFFSET) >> WIN_SHIFT);
-    }
-    for (/*Mo2mO-1*/; n >= 0; n--) // unwindowed pt.
-    {
-      output[Mo2m1 - n] = (inputL[Mm1 - n] + 2) >> 2;
-    }
+    outMdct[Mo2 + n]   = int32_t ((i64R - i64L + WIN_OFFSET) >> WIN_SHIFT);
+    outMdst[Mo2m1 - n] = int32_t ((i64R + i64L + WIN_OFFSET) >> WIN_SHIFT);
   }
-  else // MDCT kernel, no time-reversal or sign flip
+  for (/*Mo2mO-1*/; n >= 0; n--) // unwindowed pt.
   {
-    for (n = Mo2m1; n >= Mo2mO; n--) // windowed pt.
-    {
-      const int64_t i64 = (int64_t) inputL[Mm1 - n] * wl[Mm1mO - n] - (int64_t) inputL[n] * wl[n - Mo2mO];
-
-      output[Mo2 + n]   = int32_t ((i64 + WIN_OFFSET) >> WIN_SHIFT);
-    }
-    for (/*Mo2mO-1*/; n >= 0; n--) // unwindowed pt.
-    {
-      output[Mo2 + n]   = (inputL[Mm1 - n] + 2) >> 2;
-    }
+    outMdct[Mo2 + n]   = outMdst[Mo2m1 - n] = (inputL[Mm1 - n] + 2) >> 2;
   }
 }
 
 void LappedTransform::windowAndFoldInR (const int32_t* inputR, const bool shortTransform, const bool kbdWindowR, const bool lowOverlapR,
-                                        const bool mdstKernel, int32_t* const output)
+                                        int32_t* const outMdct, int32_t* const outMdst)
 {
   const unsigned ws = (kbdWindowR ? 1 : 0); // shape
   const int32_t* wr = (lowOverlapR ? m_timeWindowS[ws] : m_timeWindowL[ws]);
@@ -189,31 +226,18 @@ void LappedTransform::windowAndFoldInR (const int32_t* inputR, const bool shortT
   const int Mm1mO   = Mm1 - Mo2mO; // overlap offset
   int n;
 
-  if (mdstKernel) // time-reversal and TDA sign flip
+  // MDST kernel: time-reversal and TDA sign flip, MDCT kernel: neither, both share the window products
+  for (n = Mo2m1; n >= Mo2mO; n--) // windowed pt.
   {
-    for (n = Mo2m1; n >= Mo2mO; n--) // windowed pt.
-    {
-      const int64_t i64 = (int64_t) inputR[n] * wr[Mm1mO - n] - (int64_t) inputR[Mm1 - n] * wr[n - Mo2mO];
+    const int64_t i64L = (int64_t) inputR[n] * wr[Mm1mO - n];
+    const int64_t i64R = (int64_t) inputR[Mm1 - n] * wr[n - Mo2mO];
 
-      output[Mo2 + n]   = int32_t ((i64 + WIN_OFFSET) >> WIN_SHIFT);
-    }
-    for (/*Mo2mO-1*/; n >= 0; n--) // unwindowed pt.
-    {
-      output[Mo2 + n]   = (inputR[n] + 2) >> 2;
-    }
+    outMdct[Mo2m1 - n] = int32_t ((i64L + i64R + WIN_OFFSET) >> WIN_SHIFT);
+    outMdst[Mo2 + n]   = int32_t ((i64L - i64R + WIN_OFFSET) >> WIN_SHIFT);
   }
-  else // MDCT kernel, no time-reversal or sign flip
+  for (/*Mo2mO-1*/; n >= 0; n--) // unwindowed pt.
   {
-    for (n = Mo2m1; n >= Mo2mO; n--) // windowed pt.
-    {
-      const int64_t i64 = (int64_t) inputR[n] * wr[Mm1mO - n] + (int64_t) inputR[Mm1 - n] * wr[n - Mo2mO];
-
-      output[Mo2m1 - n] = int32_t ((i64 + WIN_OFFSET) >> WIN_SHIFT);
-    }
-    for (/*Mo2mO-1*/; n >= 0; n--) // unwindowed pt.
-    {
-      output[Mo2m1 - n] = (inputR[n] + 2) >> 2;
-    }
+    outMdct[Mo2m1 - n] = outMdst[Mo2 + n] = (inputR[n] + 2) >> 2;
   }
 }
 
@@ -229,6 +253,7 @@ LappedTransform::LappedTransform ()
   m_fftHalfSin = nullptr;
   m_fftPermutL = nullptr;
   m_fftPermutS = nullptr;
+  m_fftSimdPath = false;
   m_tempIntBuf = nullptr;
 
   // initialize all window buffers
@@ -244,15 +269,7 @@ LappedTransform::LappedTransform ()
 // destructor
 LappedTransform::~LappedTransform ()
 {
-  // free allocated helper buffers
-  MFREE (m_dctRotCosL);
-  MFREE (m_dctRotCosS);
-  MFREE (m_dctRotSinL);
-  MFREE (m_dctRotSinS);
-  MFREE (m_fftHalfCos);
-  MFREE (m_fftHalfSin);
-  MFREE (m_fftPermutL);
-  MFREE (m_fftPermutS);
+  // tables are owned by SharedTables
   m_tempIntBuf = nullptr;
 }
 
@@ -321,10 +338,8 @@ unsigned LappedTransform::applyMCLT (const int32_t* timeSig, const bool eightTra
 
     for (unsigned w = 0; w < 8; w++)
     {
-      windowAndFoldInL (tSigS /*window half 1*/, true, kbdWindowL, lowOverlapL, false, outMdctS);
-      windowAndFoldInR (&tSigS[m_transfLengthS], true, kbdWindowR, lowOverlapR, false, outMdctS);
-      windowAndFoldInL (tSigS /*window half 1*/, true, kbdWindowL, lowOverlapL, true, outMdstS);
-      windowAndFoldInR (&tSigS[m_transfLengthS], true, kbdWindowR, lowOverlapR, true, outMdstS);
+      windowAndFoldInL (tSigS /*window half 1*/, true, kbdWindowL, lowOverlapL, outMdctS, outMdstS);
+      windowAndFoldInR (&tSigS[m_transfLengthS], true, kbdWindowR, lowOverlapR, outMdctS, outMdstS);
       // MDCT via DCT-IV
       applyNegDCT4 (outMdctS, true);
       // MDST via DCT-IV
@@ -343,10 +358,8 @@ unsigned LappedTransform::applyMCLT (const int32_t* timeSig, const bool eightTra
   }
   else  // 1 long window
   {
-    windowAndFoldInL (timeSig /*window half 1*/, false, kbdWindowL, lowOverlapL, false, outMdct);
-    windowAndFoldInR (&timeSig[m_transfLengthL], false, kbdWindowR, lowOverlapR, false, outMdct);
-    windowAndFoldInL (timeSig /*window half 1*/, false, kbdWindowL, lowOverlapL, true, outMdst);
-    windowAndFoldInR (&timeSig[m_transfLengthL], false, kbdWindowR, lowOverlapR, true, outMdst);
+    windowAndFoldInL (timeSig /*window half 1*/, false, kbdWindowL, lowOverlapL, outMdct, outMdst);
+    windowAndFoldInR (&timeSig[m_transfLengthL], false, kbdWindowR, lowOverlapR, outMdct, outMdst);
     // MDCT using DCT-IV
     applyNegDCT4 (outMdct, false);
     // MDST using DCT-IV
@@ -362,69 +375,37 @@ unsigned LappedTransform::applyMCLT (const int32_t* timeSig, const bool eightTra
   return 0; // no error
 }
 
-unsigned LappedTransform::initConstants (int32_t* const tempIntBuf, int32_t* const timeWindowL[2], int32_t* const timeWindowS[2],
-                                         const unsigned maxTransfLength)
+unsigned LappedTransform::initConstants (int32_t* const tempIntBuf, const SharedTables* const sharedTables)
 {
-  const short  halfLength = short (maxTransfLength >> 1);
-  const short  sixtLength = short (maxTransfLength >> 4);
-  const double dNormL     = 3.141592653589793 / (2.0 * halfLength);
-  const double dNormS     = 3.141592653589793 / (2.0 * sixtLength);
-  const double dNormL4    = dNormL * 4.0;
+  const unsigned maxTransfLength = (sharedTables == nullptr ? 0 : sharedTables->getFrameLength ());
   short s;
 
-  if ((tempIntBuf == nullptr) || (timeWindowL == nullptr) || (timeWindowS == nullptr) ||
-      (maxTransfLength < 128) || (maxTransfLength > 8192) || (maxTransfLength & (maxTransfLength - 1)))
+  if ((tempIntBuf == nullptr) || (maxTransfLength < 128) || (maxTransfLength > 8192) || (maxTransfLength & (maxTransfLength - 1)))
   {
     return 1; // invalid arguments error
   }
 
-  m_transfLengthL = 2 * halfLength;
-  m_transfLengthS = 2 * sixtLength;
-
-  if ((m_dctRotCosL = (int32_t*) malloc (halfLength * sizeof (int32_t))) == nullptr ||
-      (m_dctRotCosS = (int32_t*) malloc (sixtLength * sizeof (int32_t))) == nullptr ||
-      (m_dctRotSinL = (int32_t*) malloc (halfLength * sizeof (int32_t))) == nullptr ||
-      (m_dctRotSinS = (int32_t*) malloc (sixtLength * sizeof (int32_t))) == nullptr ||
-      (m_fftHalfCos = (int32_t*) malloc ((halfLength >> 1) * sizeof (int32_t))) == nullptr ||
-      (m_fftHalfSin = (int32_t*) malloc ((halfLength >> 1) * sizeof (int32_t))) == nullptr ||
-      (m_fftPermutL = createPermutTable (halfLength)) == nullptr ||
-      (m_fftPermutS = createPermutTable (sixtLength)) == nullptr)
-  {
-    return 2; // memory allocation error
-  }
-
-  // obtain cosine and sine coefficients
-  for (s = 0; s < halfLength; s++)
-  {
-    m_dctRotCosL[s] = int32_t (cos (dNormL * (s + 0.125)) * (INT_MAX + 1.0) + 0.5);
-    m_dctRotSinL[s] = int32_t (sin (dNormL * (s + 0.125)) * INT_MIN - 0.5);
-  }
-  for (s = 0; s < sixtLength; s++)
-  {
-    m_dctRotCosS[s] = int32_t (cos (dNormS * (s + 0.125)) * (INT_MAX + 1.0) + 0.5);
-    m_dctRotSinS[s] = int32_t (sin (dNormS * (s + 0.125)) * INT_MIN - 0.5);
-  }
-
-  for (s = 0; s < m_transfLengthS; s++)
-  {
-    m_fftHalfSin[s] = int32_t (sin (dNormL4 * s) * INT_MIN - 0.5);
-    m_fftHalfCos[m_transfLengthS + s] = -m_fftHalfSin[s];
-  }
-  // complete missing entries by copying
-  m_fftHalfSin[s] = INT_MIN;
-  m_fftHalfCos[0] = INT_MIN;
-  for (s = 1; s < m_transfLengthS; s++)
-  {
-    m_fftHalfSin[m_transfLengthS + s] = m_fftHalfSin[m_transfLengthS - s];
-    m_fftHalfCos[m_transfLengthS - s] = m_fftHalfSin[s];
-  }
-
+  m_transfLengthL = short (maxTransfLength);
+  m_transfLengthS = short (maxTransfLength >> 3);
+
+  // adopt shared read-only table pointers
+  m_dctRotCosL = sharedTables->getDctRotCos (false);
+  m_dctRotCosS = sharedTables->getDctRotCos (true);
+  m_dctRotSinL = sharedTables->getDctRotSin (false);
+  m_dctRotSinS = sharedTables->getDctRotSin (true);
+  m_fftHalfCos = sharedTables->getFftHalfCos ();
+  m_fftHalfSin = sharedTables->getFftHalfSin ();
+  m_fftPermutL = sharedTables->getFftPermut (false);
+  m_fftPermutS = sharedTables->getFftPermut (true);
+#if LT_FFT_SSE41
+  m_fftSimdPath = isSse41Supported ();
+#endif
   // adopt helper/window buffer pointers
   m_tempIntBuf = tempIntBuf;
   for (s = 0; s < 2; s++)
   {
-    m_timeWindowL[s] = timeWindowL[s];
-    m_timeWindowS[s] = timeWindowS[s];
+    m_timeWindowL[s] = sharedTables->getTimeWindow (false, s);
+    m_timeWindowS[s] = sharedTables->getTimeWindow (true,  s);
   }
 
   return 0; // no error
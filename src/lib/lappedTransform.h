@@ -1,5 +1,5 @@
 /* lappedTransform.h - header file for class providing time-frequency transformation
- * written by C. R. Helmrich, last modified in 2019 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -12,12 +12,14 @@
 #define _LAPPED_TRANSFORM_H_
 
 #include "exhaleLibPch.h"
+#include "sharedTables.h"
 
 // constants, experimental macros
 #define LUT_OFFSET      (1 << 30)
 #define LUT_SHIFT              31
 #define WIN_OFFSET      (1 << 24)
 #define WIN_SHIFT              25
+#define LT_FFT_SSE41            SIMD_X86 // 1: use SSE4.1 FFT if CPU supports it
 
 // time-frequency transform class
 class LappedTransform
@@ -25,26 +27,27 @@ class LappedTransform
 private:
 
   // member variables
-  int32_t* m_dctRotCosL;
-  int32_t* m_dctRotCosS;
-  int32_t* m_dctRotSinL;
-  int32_t* m_dctRotSinS;
-  int32_t* m_fftHalfCos;
-  int32_t* m_fftHalfSin;
-  short*   m_fftPermutL;
-  short*   m_fftPermutS;
+  const int32_t* m_dctRotCosL; // pointers to shared tables
+  const int32_t* m_dctRotCosS;
+  const int32_t* m_dctRotSinL;
+  const int32_t* m_dctRotSinS;
+  const int32_t* m_fftHalfCos;
+  const int32_t* m_fftHalfSin;
+  const short*   m_fftPermutL;
+  const short*   m_fftPermutS;
+  bool     m_fftSimdPath;    // runtime-dispatched vectorized FFT
   int32_t* m_tempIntBuf;     // pointer to temporary helper buffer
-  int32_t* m_timeWindowL[2]; // pointer to two long window halves
-  int32_t* m_timeWindowS[2]; // pointer to two short window halves
+  const int32_t* m_timeWindowL[2]; // pointer to two long window halves
+  const int32_t* m_timeWindowS[2]; // pointer to two short window halves
   short    m_transfLengthL;
   short    m_transfLengthS;
 
   // helper functions
   void applyHalfSizeFFT (int32_t* const iR/*eal*/, int32_t* const iI/*mag*/, const bool shortTransform);
   void windowAndFoldInL (const int32_t* inputL, const bool shortTransform, const bool kbdWindowL, const bool lowOverlapL,
-                         const bool mdstKernel, int32_t* const output);
+                         int32_t* const outMdct, int32_t* const outMdst);
   void windowAndFoldInR (const int32_t* inputR, const bool shortTransform, const bool kbdWindowR, const bool lowOverlapR,
-                         const bool mdstKernel, int32_t* const output);
+                         int32_t* const outMdct, int32_t* const outMdst);
 
 public:
 
@@ -56,8 +59,7 @@ public:
   unsigned applyNegDCT4  (int32_t* const signal,  const bool shortTransform);
   unsigned applyMCLT     (const int32_t* timeSig, const bool eightTransforms, bool kbdWindowL, const bool kbdWindowR,
                           const bool lowOverlapL, const bool lowOverlapR, int32_t* const outMdct, int32_t* const outMdst);
-  unsigned initConstants (int32_t* const tempIntBuf, int32_t* const timeWindowL[2], int32_t* const timeWindowS[2],
-                          const unsigned maxTransfLength);
+  unsigned initConstants (int32_t* const tempIntBuf, const SharedTables* const sharedTables);
 }; // LappedTransform
 
 #endif // _LAPPED_TRANSFORM_H_
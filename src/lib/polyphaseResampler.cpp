@@ -0,0 +1,348 @@
+/* polyphaseResampler.cpp - source file for class providing arbitrary-ratio polyphase resampling
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#include "exhaleLibPch.h"
+#include "polyphaseResampler.h"
+#if PR_FILTER_AVX2
+# include <immintrin.h>
+#endif
+
+static const int16_t usfc2x[32] = { // 2x upsampling filter coefficients
+  (83359-65536), -27563, 16273, -11344, 8541, -6708, 5403, -4419, 3647, -3025, 2514, -2088, 1730,
+  -1428, 1173, -957, 775, -622, 494, -388, 300, -230, 172, -127, 91, -63, 43, -27, 16, -9, 4, -1
+};
+
+static const int16_t rsfc3x[128] = {// 3x resampling filter coefficients
+  21846, 6711, (36099-32768), 0, -18000, -14370, 0, 10208, 8901, 0, -7062, -6389, 0, 5347, 4934, 0, -4258,
+  -3977, 0, 3499, 3294, 0, -2937, -2780, 0, 2501, 2376, 0, -2151, -2050, 0, 1864, 1779, 0, -1623, -1551,
+  0, 1417, 1355, 0, -1240, -1187, 0, 1086, 1040, 0, -952, -910, 0, 833, 797, 0, -728, -696, 0, 635, 607,
+  0, -553, -528, 0, 480, 457, 0, -415, -395, 0, 358, 340, 0, -307, -291, 0, 262, 248, 0, -223, -211, 0,
+  188, 177, 0, -158, -149, 0, 132, 124, 0, -109, -102, 0, 90, 84, 0, -73, -68, 0, 59, 55, 0, -47, -43,
+  0, 37, 34, 0, -29, -26, 0, 22, 20, 0, -16, -15, 0, 12, 10, 0, -8, -7, 0, 5, 5, 0, -3, -3, 0, 2
+};
+
+// static helper functions
+static unsigned greatestCommonDivisor (unsigned a, unsigned b)
+{
+  while (b > 0)
+  {
+    const unsigned r = a % b;
+
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+static double modifiedBesselFunctionOfFirstKind (const double x)
+{
+  const double xOver2 = x * 0.5;
+  double d = 1.0, sum = 1.0;
+  int    i = 0;
+
+  do
+  {
+    const double x2di = xOver2 / double (++i);
+
+    d *= (x2di * x2di);
+    sum += d;
+  }
+  while (d > sum * 1.2e-38); // FLT_MIN
+
+  return sum;
+}
+
+static void filterChannelScalar (const int32_t* chBuf, const int32_t* const coeffs, const unsigned numTaps, const unsigned numOut,
+                                 unsigned phase, const unsigned numPhases, const unsigned stepInt, const unsigned stepFrac,
+                                 int32_t* chOut, const unsigned outStride)
+{
+  for (unsigned k = 0; k < numOut; k++, chOut += outStride)
+  {
+    const int32_t* const c = &coeffs[phase * numTaps];
+    int64_t r = 1 << (PR_COEFF_SHIFT - 1); // for rounding
+
+    for (unsigned t = 0; t < numTaps; t++) r += (int64_t) chBuf[t] * c[t];
+
+    r >>= PR_COEFF_SHIFT;
+    *chOut = int32_t (r < -8388608 ? -8388608 : (r > 8388607 ? 8388607 : r));
+
+    chBuf += stepInt; // advance to next output's input position
+    if ((phase += stepFrac) >= numPhases)
+    {
+      phase -= numPhases;
+      chBuf++;
+    }
+  }
+}
+
+#if PR_FILTER_AVX2
+static TARGET_AVX2 void filterChannelAVX2 (const int32_t* chBuf, const int32_t* const coeffs, const unsigned numTaps, const unsigned numOut,
+                                           unsigned phase, const unsigned numPhases, const unsigned stepInt, const unsigned stepFrac,
+                                           int32_t* chOut, const unsigned outStride)
+{
+  // bit-exact 8-tap version of filterChannelScalar (), even and odd taps are multiplied into 64-bit sums separately
+  for (unsigned k = 0; k < numOut; k++, chOut += outStride)
+  {
+    const int32_t* const c = &coeffs[phase * numTaps];
+    __m256i sumE = _mm256_setzero_si256 ();
+    __m256i sumO = _mm256_setzero_si256 ();
+    __m128i sum2;
+    int64_t r;
+
+    for (unsigned t = 0; t < numTaps; t += 8)
+    {
+      const __m256i x8 = _mm256_loadu_si256 ((const __m256i*) &chBuf[t]);
+      const __m256i c8 = _mm256_loadu_si256 ((const __m256i*) &c[t]);
+
+      sumE = _mm256_add_epi64 (sumE, _mm256_mul_epi32 (x8, c8));
+      sumO = _mm256_add_epi64 (sumO, _mm256_mul_epi32 (_mm256_srli_epi64 (x8, 32), _mm256_srli_epi64 (c8, 32)));
+    }
+    sumE = _mm256_add_epi64 (sumE, sumO);
+    sum2 = _mm_add_epi64 (_mm256_castsi256_si128 (sumE), _mm256_extracti128_si256 (sumE, 1));
+    _mm_storel_epi64 ((__m128i*) &r, _mm_add_epi64 (sum2, _mm_unpackhi_epi64 (sum2, sum2)));
+
+    r = (r + (1 << (PR_COEFF_SHIFT - 1))) >> PR_COEFF_SHIFT;
+    *chOut = int32_t (r < -8388608 ? -8388608 : (r > 8388607 ? 8388607 : r));
+
+    chBuf += stepInt;
+    if ((phase += stepFrac) >= numPhases)
+    {
+      phase -= numPhases;
+      chBuf++;
+    }
+  }
+}
+#endif // PR_FILTER_AVX2
+
+// private helper functions
+void PolyphaseResampler::initLegacyFilter (const int16_t* const table, const unsigned ratioM)
+{
+  // hand-tuned 2:1 and 2:3 filters of former exhaleApp resamplers, symmetric tap pairs
+  const int la = m_lookahead;
+  int32_t* const phase0 = &m_coeffs[m_tapOffset];
+  int32_t* const phase1 = &m_coeffs[m_tapOffset + m_numTaps]; // centered between taps 0 and 1
+  int c;
+
+  if (ratioM == 1) // 2x upsampling, even output samples are input copies
+  {
+    phase0[0] = 1 << PR_COEFF_SHIFT;
+    for (c = 0; c < la; c++) phase1[-c] = phase1[c + 1] = table[c] + (c == 0 ? 1 << 16 : 0);
+  }
+  else // 3:2 downsampling, 3x band-limitation at twice the input rate
+  {
+    phase0[0] = table[0] + (1 << 16);
+    for (c = 1; c < la; c++) phase0[-c] = phase0[c] = table[c << 1] + (c == 1 ? 1 << 15 : 0);
+    phase0[-la] = phase0[la] = 1;
+    for (c = 0; c < la; c++) phase1[-c] = phase1[c + 1] = table[(c << 1) + 1] + (c == 0 ? 1 << 16 : 0);
+  }
+}
+
+unsigned PolyphaseResampler::initSincFilter (const unsigned ratioM)
+{
+  // Kaiser-windowed sinc, -6 dB point at 91% of the lower Nyquist frequency, ~80 dB rejection
+  const double ratio = __min (1.0, double (m_numPhases) / ratioM);
+  const double fc2 = 0.91 * ratio; // twice the cut-off frequency relative to the input rate
+  const double support = PR_HALF_SUPPORT / ratio; // in input samples
+  const double beta = 8.0;
+  const double dNorm = 1.0 / modifiedBesselFunctionOfFirstKind (beta);
+  double* coeffs = (double*) malloc (m_numTaps * sizeof (double));
+
+  if (coeffs == nullptr) return 2; // memory allocation error
+
+  for (unsigned p = 0; p < m_numPhases; p++)
+  {
+    int32_t* const c = &m_coeffs[p * m_numTaps];
+    double sum = 0.0;
+    int32_t iSum = 0;
+    unsigned t, tMax = 0;
+
+    for (t = 0; t < m_numTaps; t++) // tap t is at x input samples from the output position
+    {
+      const double x = double (int (t) - m_tapOffset) - double (p) / m_numPhases;
+      const double w = x / support;
+
+      coeffs[t] = 0.0;
+      if (w * w < 1.0)
+      {
+        const double a = 3.141592653589793 * fc2 * x;
+
+        coeffs[t] = (fabs (a) < 1.0e-9 ? 1.0 : sin (a) / a) * modifiedBesselFunctionOfFirstKind (beta * sqrt (1.0 - w * w)) * dNorm;
+        sum += coeffs[t];
+      }
+    }
+    sum = double (1 << PR_COEFF_SHIFT) / sum; // unity gain at DC in every phase
+
+    for (t = 0; t < m_numTaps; t++)
+    {
+      c[t] = int32_t (floor (coeffs[t] * sum + 0.5));
+      iSum += c[t];
+      if (abs (c[t]) > abs (c[tMax])) tMax = t;
+    }
+    c[tMax] += (1 << PR_COEFF_SHIFT) - iSum; // correct rounding error
+  }
+  free (coeffs);
+
+  return 0; // no error
+}
+
+// constructor
+PolyphaseResampler::PolyphaseResampler ()
+{
+  m_chanBuffer   = nullptr;
+  m_chanLength   = 0;
+  m_coeffs       = nullptr;
+#if PR_FILTER_AVX2
+  m_filterSimdPath = isAvx2Supported ();
+#else
+  m_filterSimdPath = false;
+#endif
+  m_lookahead    = 0;
+  m_maxOutLength = 0;
+  m_numChannels  = 0;
+  m_numPhases    = 0;
+  m_numTaps      = 0;
+  m_phase        = 0;
+  m_primed       = false;
+  m_stepFrac     = 0;
+  m_stepInt      = 0;
+  m_tapOffset    = 0;
+}
+
+// destructor
+PolyphaseResampler::~PolyphaseResampler ()
+{
+  // free allocated buffers
+  MFREE (m_chanBuffer);
+  MFREE (m_coeffs);
+}
+
+// public functions
+unsigned PolyphaseResampler::applyResampler (int32_t* const pcmBuffer, const unsigned numOutSamples, const bool restart /*= false*/)
+{
+  const bool     start    = restart || !m_primed;
+  const unsigned inLength = getInputLength (numOutSamples, restart);
+  const unsigned valid    = m_tapOffset + (start ? 0 : m_lookahead);
+  const unsigned nChans   = m_numChannels;
+  unsigned ch, s, advance;
+
+  if ((pcmBuffer == nullptr) || (m_coeffs == nullptr) || (numOutSamples > m_maxOutLength))
+  {
+    return 1; // invalid arguments error, or initResampler was not called before
+  }
+  if (start) m_phase = 0;
+  advance = unsigned ((m_phase + (uint64_t) numOutSamples * (m_stepInt * m_numPhases + m_stepFrac)) / m_numPhases);
+
+  for (ch = 0; ch < nChans; ch++) // step 1: add deinterleaved input samples to resampling buffer
+  {
+    int32_t* const chBuf = &m_chanBuffer[m_chanLength * ch];
+    const int32_t* chPcm = &pcmBuffer[ch];
+
+    if (start) // construct leading sample values via extrapolation
+    {
+      for (s = 0; s < m_tapOffset; s++)
+      {
+        const int32_t i = 32 - int32_t (m_tapOffset - s); // ramp index
+
+        chBuf[s] = (i < 0 ? 0 : (*chPcm * i + (32 >> 1)) >> 5);
+      }
+    }
+    for (s = valid; s < valid + inLength; s++, chPcm += nChans) chBuf[s] = *chPcm;
+  }
+
+  for (ch = 0; ch < nChans; ch++) // step 2: resample, reinterleave, and save to PCM input buffer
+  {
+    int32_t* const chBuf = &m_chanBuffer[m_chanLength * ch];
+
+#if PR_FILTER_AVX2
+    if (m_filterSimdPath)
+    {
+      filterChannelAVX2 (chBuf, m_coeffs, m_numTaps, numOutSamples, m_phase, m_numPhases, m_stepInt, m_stepFrac, &pcmBuffer[ch], nChans);
+    }
+    else
+#endif
+    filterChannelScalar (chBuf, m_coeffs, m_numTaps, numOutSamples, m_phase, m_numPhases, m_stepInt, m_stepFrac, &pcmBuffer[ch], nChans);
+
+    memmove (chBuf, &chBuf[advance], (valid + inLength - advance) * sizeof (int32_t)); // update memory
+  }
+  m_phase  = uint16_t ((m_phase + (uint64_t) numOutSamples * m_stepFrac) % m_numPhases);
+  m_primed = true;
+
+  return 0; // no error
+}
+
+unsigned PolyphaseResampler::getInputLength (const unsigned numOutSamples, const bool restart /*= false*/) const
+{
+  const bool start = restart || !m_primed;
+
+  if (m_numPhases == 0) return 0;
+
+  return unsigned (((start ? 0 : m_phase) + (uint64_t) numOutSamples * (m_stepInt * m_numPhases + m_stepFrac)) / m_numPhases) +
+         (start ? m_lookahead : 0);
+}
+
+unsigned PolyphaseResampler::initResampler (const unsigned inputRate, const unsigned outputRate, const unsigned numChannels,
+                                            const unsigned maxOutLength)
+{
+  const unsigned gcd = greatestCommonDivisor (inputRate, outputRate);
+  const unsigned ratioL = (gcd > 0 ? outputRate / gcd : 0);
+  const unsigned ratioM = (gcd > 0 ? inputRate / gcd : 0);
+  unsigned maxAdvance;
+
+  MFREE (m_chanBuffer);
+  MFREE (m_coeffs);
+  m_numPhases = 0;
+  m_primed = false;
+
+  if ((ratioL == 0) || (ratioL > PR_MAX_PHASES) || (ratioL == ratioM) || (ratioL > ratioM * PR_MAX_RATIO) || (ratioM > ratioL * PR_MAX_RATIO) ||
+      (numChannels == 0) || (numChannels > USAC_MAX_NUM_CHANNELS) || (maxOutLength == 0) || (maxOutLength > SHRT_MAX))
+  {
+    return 1; // invalid arguments error
+  }
+  m_maxOutLength = maxOutLength;
+  m_numChannels  = (uint16_t) numChannels;
+  m_numPhases    = (uint16_t) ratioL;
+  m_stepFrac     = uint16_t (ratioM % ratioL);
+  m_stepInt      = uint16_t (ratioM / ratioL);
+
+  if ((ratioL == 2) && (ratioM <= 3)) // tuned 2:1 or 2:3 filter, taps 1-la...la or -la...la
+  {
+    m_lookahead  = uint16_t (ratioM == 1 ? 32 : __max (PR_HALF_SUPPORT, __min (64, maxOutLength >> 4)));
+    m_numTaps    = uint16_t ((2 * m_lookahead + (ratioM == 1 ? 7 : 8)) & ~7);
+  }
+  else // designed windowed-sinc filter
+  {
+    m_numTaps    = uint16_t ((2 * ((PR_HALF_SUPPORT * __max (ratioL, ratioM) + ratioL - 1) / ratioL) + 7) & ~7);
+    m_lookahead  = (m_numTaps >> 1) + 1; // last tap of an output sharing its input position with the next call's first output
+  }
+  m_tapOffset    = uint16_t ((m_numTaps >> 1) - 1);
+
+  maxAdvance     = unsigned ((ratioL - 1 + (uint64_t) maxOutLength * ratioM) / ratioL);
+  m_chanLength   = maxAdvance + m_numTaps + m_lookahead;
+
+  if ((m_chanBuffer = (int32_t*) calloc (m_chanLength * numChannels, sizeof (int32_t))) == nullptr ||
+      (m_coeffs     = (int32_t*) calloc (ratioL * m_numTaps, sizeof (int32_t))) == nullptr)
+  {
+    m_numPhases = 0;
+    return 2; // memory allocation error
+  }
+
+  if ((ratioL == 2) && (ratioM <= 3))
+  {
+    initLegacyFilter (ratioM == 1 ? usfc2x : rsfc3x, ratioM);
+  }
+  else if (initSincFilter (ratioM) > 0)
+  {
+    MFREE (m_coeffs);
+    m_numPhases = 0;
+    return 2;
+  }
+
+  return 0; // no error
+}
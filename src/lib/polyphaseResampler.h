@@ -0,0 +1,61 @@
+/* polyphaseResampler.h - header file for class providing arbitrary-ratio polyphase resampling
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#ifndef _POLYPHASE_RESAMPLER_H_
+#define _POLYPHASE_RESAMPLER_H_
+
+#include "exhaleLibPch.h"
+
+// constants, experimental macros
+#define PR_COEFF_SHIFT         17 // fixed-point filter gain
+#define PR_HALF_SUPPORT        32 // zero crossings per side
+#define PR_MAX_PHASES        2048 // after ratio reduction
+#define PR_MAX_RATIO            8 // up- or downsampling
+#define PR_FILTER_AVX2          SIMD_X86 // 1: use AVX2 FIR kernel if CPU supports it
+
+// polyphase resampler class
+class PolyphaseResampler
+{
+private:
+
+  // member variables
+  int32_t* m_chanBuffer; // per-channel input history
+  uint32_t m_chanLength;
+  int32_t* m_coeffs;     // numPhases x numTaps filters
+  bool     m_filterSimdPath; // runtime-dispatched vectorized FIR
+  uint16_t m_lookahead;  // input samples beyond output
+  uint32_t m_maxOutLength;
+  uint16_t m_numChannels;
+  uint16_t m_numPhases;  // L, output rate / GCD
+  uint16_t m_numTaps;    // multiple of 8
+  uint16_t m_phase;      // of next output sample
+  bool     m_primed;     // false: restart in next call
+  uint16_t m_stepFrac;   // M % L, M: input rate / GCD
+  uint16_t m_stepInt;    // M / L
+  uint16_t m_tapOffset;  // history taps before output
+
+  // helper functions
+  void     initLegacyFilter (const int16_t* const table, const unsigned ratioM);
+  unsigned initSincFilter (const unsigned ratioM);
+
+public:
+
+  // constructor
+  PolyphaseResampler ();
+  // destructor
+  ~PolyphaseResampler ();
+  // public functions
+  unsigned applyResampler (int32_t* const pcmBuffer, const unsigned numOutSamples, const bool restart = false);
+  unsigned getInputLength (const unsigned numOutSamples, const bool restart = false) const;
+  unsigned initResampler  (const unsigned inputRate, const unsigned outputRate, const unsigned numChannels,
+                           const unsigned maxOutLength);
+}; // PolyphaseResampler
+
+#endif // _POLYPHASE_RESAMPLER_H_
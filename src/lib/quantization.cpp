@@ -1,5 +1,5 @@
 /* quantization.cpp - source file for class with nonuniform quantization functionality
- * written by C. R. Helmrich, last modified in 2023 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -13,6 +13,9 @@
 #if SFB_QUANT_SSE
 # include <xmmintrin.h>
 #endif
+#if SFB_QUANT_AVX2
+# include <immintrin.h>
+#endif
 
 #define EC_TRAIN (0 && EC_TRELLIS_OPT_CODING) // for RDOC testing
 
@@ -35,6 +38,140 @@ static inline short getBitCount (EntropyCoder& entrCoder, const int sfIndex, con
   return (short) __min (SHRT_MAX, bitCount); // exclude sign bits
 }
 
+static inline void quantizeCoeff (const double normalizedMagn, const double* const lutXExp43, uint8_t& coeffQuant,
+                                  short& maxQ, short& numQ, double& dNum, double& dDen)
+{
+  short q;
+
+  if (normalizedMagn < 28.5)  // fast approximate pow (d, 0.75)
+  {
+    // based on code from: N. N. Schraudolph, "A Fast, Compact Approximation of the Expo-
+    // nential Function," Neural Comput., vol. 11, pp. 853-862, 1998 and M. Ankerl, 2007,
+    // https://martin.ankerl.com/2007/10/04/optimized-pow-approximation-for-java-and-c-c/
+    union { double d; int32_t i[2]; } u = { normalizedMagn };
+
+    u.i[1] = int32_t (0.75 * (u.i[1] - 1072632447) + 1072632447.0);
+    u.i[0] = 0;
+    q = short (u.d + (u.d < 1.0 ? 0.3822484 : 0.2734375));
+  }
+  else
+  {
+    q = short (SFB_QUANT_OFFSET + pow (__min (1048544.0, normalizedMagn), 0.75)); // min avoids rare preset-9 overflow
+  }
+
+  if (q > 0)
+  {
+    if (q >= SCHAR_MAX)
+    {
+      if (maxQ < q)
+      {
+        maxQ = q; // find maximum quantized magnitude in vector
+      }
+      q = SCHAR_MAX;
+    }
+    else
+    {
+      const double diffRoundD = lutXExp43[q    ] - normalizedMagn;
+      const double diffRoundU = lutXExp43[q + 1] - normalizedMagn;
+
+      if (diffRoundU * diffRoundU < diffRoundD * diffRoundD)
+      {
+        q++; // round-up gives lower distortion than round-down
+      }
+    }
+    if (maxQ < q)
+    {
+      maxQ = q;
+    }
+    numQ++;
+    dNum += lutXExp43[q] * normalizedMagn;
+    dDen += lutXExp43[q] * lutXExp43[q];
+  }
+#if SFB_QUANT_PERCEPT_OPT
+  else // q == 0, assume perceptual transparency for code below
+  {
+    dNum += normalizedMagn * normalizedMagn;
+    dDen += normalizedMagn * normalizedMagn;
+  }
+#endif
+  coeffQuant = (uint8_t) q;
+}
+
+#if SFB_QUANT_AVX2
+static TARGET_AVX2 void quantizeMagnAVX2 (const unsigned* const coeffMagn, const double stepSizeDiv, const double* const lutXExp43,
+                                          uint8_t* const coeffQuant, const int numCoeffs, short& maxQ, short& numQ, double& dNum, double& dDen)
+{
+  // bit-exact 4-way version of quantizeCoeff () loop, the sums are accumulated in the scalar order
+  const __m256d normDiv = _mm256_set1_pd (stepSizeDiv);
+  const __m256d magnMax = _mm256_set1_pd (28.5);
+  const __m256d one     = _mm256_set1_pd (1.0);
+  const __m256d uint31  = _mm256_set1_pd (2147483648.0);
+  const __m256i oddInts = _mm256_setr_epi32 (1, 3, 5, 7, 1, 3, 5, 7);
+  const __m256i evenInt = _mm256_setr_epi32 (0, 2, 4, 6, 0, 2, 4, 6);
+  const __m128i signBit = _mm_set1_epi32 (INT_MIN);
+  const __m128i expOffs = _mm_set1_epi32 (1072632447);
+  const __m128i zero    = _mm_setzero_si128 ();
+  __m128i maxQ4 = zero;
+  double  num[4], den[4];
+  int i = numCoeffs - 1;
+
+  for (; (i & 3) != 3; i--) quantizeCoeff ((double) coeffMagn[i] * stepSizeDiv, lutXExp43, coeffQuant[i], maxQ, numQ, dNum, dDen);
+
+  for (i -= 3; i >= 0; i -= 4)
+  {
+    const __m128i m = _mm_loadu_si128 ((const __m128i*) &coeffMagn[i]);
+    const __m256d x = _mm256_mul_pd (_mm256_add_pd (_mm256_cvtepi32_pd (_mm_xor_si128 (m, signBit)), uint31), normDiv);
+
+    if (_mm256_movemask_pd (_mm256_cmp_pd (x, magnMax, _CMP_GE_OQ)) != 0) // need pow ()
+    {
+      for (int j = i + 3; j >= i; j--) quantizeCoeff ((double) coeffMagn[j] * stepSizeDiv, lutXExp43, coeffQuant[j], maxQ, numQ, dNum, dDen);
+      continue;
+    }
+    // Schraudolph approximation on the upper 32 bits of each double, see quantizeCoeff ()
+    const __m128i e = _mm_sub_epi32 (_mm256_castsi256_si128 (_mm256_permutevar8x32_epi32 (_mm256_castpd_si256 (x), oddInts)), expOffs);
+    const __m256d t = _mm256_add_pd (_mm256_mul_pd (_mm256_cvtepi32_pd (e), _mm256_set1_pd (0.75)), _mm256_set1_pd (1072632447.0));
+    const __m256d u = _mm256_castsi256_pd (_mm256_slli_epi64 (_mm256_cvtepi32_epi64 (_mm256_cvttpd_epi32 (t)), 32));
+    const __m256d r = _mm256_add_pd (u, _mm256_blendv_pd (_mm256_set1_pd (0.2734375), _mm256_set1_pd (0.3822484),
+                                                          _mm256_cmp_pd (u, one, _CMP_LT_OQ)));
+    const __m256d nonZero = _mm256_cmp_pd (r, one, _CMP_GE_OQ);
+    __m128i q = _mm256_cvttpd_epi32 (r); // 0 <= q < SCHAR_MAX since x < 28.5
+
+    // round up where this yields lower distortion, then compute the sum terms
+    const __m256d lutD = _mm256_mask_i32gather_pd (x, lutXExp43,     q, nonZero, 8);
+    const __m256d lutU = _mm256_mask_i32gather_pd (x, lutXExp43 + 1, q, nonZero, 8);
+    const __m256d dD = _mm256_sub_pd (lutD, x);
+    const __m256d dU = _mm256_sub_pd (lutU, x);
+    const __m256d up = _mm256_and_pd (nonZero, _mm256_cmp_pd (_mm256_mul_pd (dU, dU), _mm256_mul_pd (dD, dD), _CMP_LT_OQ));
+    const __m256d xq = _mm256_blendv_pd (lutD, lutU, up); // x where q == 0
+
+    q = _mm_sub_epi32 (q, _mm256_castsi256_si128 (_mm256_permutevar8x32_epi32 (_mm256_castpd_si256 (up), evenInt)));
+    maxQ4 = _mm_max_epi32 (maxQ4, q);
+    const int nz = _mm256_movemask_pd (nonZero);
+
+    numQ += short ((nz & 1) + ((nz >> 1) & 1) + ((nz >> 2) & 1) + (nz >> 3));
+#if SFB_QUANT_PERCEPT_OPT
+    _mm256_storeu_pd (num, _mm256_mul_pd (xq, x));
+    _mm256_storeu_pd (den, _mm256_mul_pd (xq, xq));
+#else
+    _mm256_storeu_pd (num, _mm256_and_pd (nonZero, _mm256_mul_pd (xq, x)));
+    _mm256_storeu_pd (den, _mm256_and_pd (nonZero, _mm256_mul_pd (xq, xq)));
+#endif
+    for (int j = 3; j >= 0; j--)
+    {
+      dNum += num[j];
+      dDen += den[j];
+    }
+    const int32_t q4 = _mm_cvtsi128_si32 (_mm_packus_epi16 (_mm_packs_epi32 (q, zero), zero));
+
+    memcpy (&coeffQuant[i], &q4, sizeof (int32_t));
+  }
+
+  maxQ4 = _mm_max_epi32 (maxQ4, _mm_shuffle_epi32 (maxQ4, 0x4E));
+  maxQ4 = _mm_max_epi32 (maxQ4, _mm_shuffle_epi32 (maxQ4, 0xB1));
+  maxQ  = __max (maxQ, (short) _mm_cvtsi128_si32 (maxQ4));
+}
+#endif // SFB_QUANT_AVX2
+
 #if EC_TRELLIS_OPT_CODING && !EC_TRAIN
 static inline double getLagrangeValue (const uint16_t rateIndex) // RD optimization constant
 {
@@ -91,64 +228,16 @@ uint8_t SfbQuantizer::quantizeMagnSfb (const unsigned* const coeffMagn, const ui
   const double stepSizeDiv = m_lutSfNorm[scaleFactor];
   double  dNum = 0.0, dDen = 0.0;
   short sf, maxQ = 0, numQ = 0;
-
-  for (int i = numCoeffs - 1; i >= 0; i--)
+#if SFB_QUANT_AVX2
+  if (m_quantSimdPath)
   {
-    const double normalizedMagn = (double) coeffMagn[i] * stepSizeDiv;
-    short q;
-
-    if (normalizedMagn < 28.5)  // fast approximate pow (d, 0.75)
-    {
-      // based on code from: N. N. Schraudolph, "A Fast, Compact Approximation of the Expo-
-      // nential Function," Neural Comput., vol. 11, pp. 853-862, 1998 and M. Ankerl, 2007,
-      // https://martin.ankerl.com/2007/10/04/optimized-pow-approximation-for-java-and-c-c/
-      union { double d; int32_t i[2]; } u = { normalizedMagn };
-
-      u.i[1] = int32_t (0.75 * (u.i[1] - 1072632447) + 1072632447.0);
-      u.i[0] = 0;
-      q = short (u.d + (u.d < 1.0 ? 0.3822484 : 0.2734375));
-    }
-    else
-    {
-      q = short (SFB_QUANT_OFFSET + pow (__min (1048544.0, normalizedMagn), 0.75)); // min avoids rare preset-9 overflow
-    }
-
-    if (q > 0)
-    {
-      if (q >= SCHAR_MAX)
-      {
-        if (maxQ < q)
-        {
-          maxQ = q; // find maximum quantized magnitude in vector
-        }
-        q = SCHAR_MAX;
-      }
-      else
-      {
-        const double diffRoundD = m_lutXExp43[q    ] - normalizedMagn;
-        const double diffRoundU = m_lutXExp43[q + 1] - normalizedMagn;
-
-        if (diffRoundU * diffRoundU < diffRoundD * diffRoundD)
-        {
-          q++; // round-up gives lower distortion than round-down
-        }
-      }
-      if (maxQ < q)
-      {
-        maxQ = q;
-      }
-      numQ++;
-      dNum += m_lutXExp43[q] * normalizedMagn;
-      dDen += m_lutXExp43[q] * m_lutXExp43[q];
-    }
-#if SFB_QUANT_PERCEPT_OPT
-    else // q == 0, assume perceptual transparency for code below
-    {
-      dNum += normalizedMagn * normalizedMagn;
-      dDen += normalizedMagn * normalizedMagn;
-    }
+    quantizeMagnAVX2 (coeffMagn, stepSizeDiv, m_lutXExp43, coeffQuant, numCoeffs, maxQ, numQ, dNum, dDen);
+  }
+  else
 #endif
-    coeffQuant[i] = (uint8_t) q;
+  for (int i = numCoeffs - 1; i >= 0; i--)
+  {
+    quantizeCoeff ((double) coeffMagn[i] * stepSizeDiv, m_lutXExp43, coeffQuant[i], maxQ, numQ, dNum, dDen);
   }
 
   if (sigMaxQ) *sigMaxQ = maxQ; // max. quantized value magnitude
@@ -264,7 +353,7 @@ uint32_t SfbQuantizer::quantizeMagnRDOC (EntropyCoder& entropyCoder, const uint8
   const uint32_t  codStart = entropyCoder.arithGetCodState ();
   const uint32_t  ctxStart = entropyCoder.arithGetCtxState (); // before call to getBitCount
   const double stepSizeDiv = m_lutSfNorm[optimalSf];
-  const uint16_t numStates = 4; // 4 reduction types: [0, 0], [0, -1], [-1, 0], and [-1, -1]
+  const uint16_t numStates = m_numTStates; // reduction types [0, 0], [0, -1], [-1, 0], [-1, -1]
   const uint16_t numTuples = numCoeffs >> 1;
   uint8_t* const quantRate = &m_coeffTemp[((unsigned) m_maxSize8M1 + 1) << 3];
   uint32_t prevCodState[4] = {0, 0, 0, 0};
@@ -273,7 +362,7 @@ uint32_t SfbQuantizer::quantizeMagnRDOC (EntropyCoder& entropyCoder, const uint8
   uint32_t tempCodState[4] = {0, 0, 0, 0};
   uint32_t tempCtxState[4] = {0, 0, 0, 0};
   double   tempVtrbCost[4] = {0, 0, 0, 0};
-  double   quantDist[32][4];   // TODO: dynamic memory allocation
+  double (* const quantDist)[4] = (double (*)[4]) m_tupleDist;
   uint8_t* const optimalIs = (uint8_t* const) (quantDist[32-1]);
   uint8_t  tempQuant[4], numQ; // for tuple/SFB sign bit counting
   unsigned tuple, is;
@@ -503,8 +592,12 @@ SfbQuantizer::SfbQuantizer ()
   m_lutXExp43 = nullptr;
 
   m_maxSfIndex = 0;
+  m_quantSimdPath = false;
 #if EC_TRELLIS_OPT_CODING
   m_numCStates = 0;
+  m_numTStates = 0;
+  m_refCStates = 0;
+  m_trellisMem = nullptr;
 
   for (unsigned b = 0; b < 52; b++)
   {
@@ -512,95 +605,120 @@ SfbQuantizer::SfbQuantizer ()
     m_quantInSf[b] = nullptr;
     m_quantRate[b] = nullptr;
   }
+  m_tupleDist  = nullptr;
 #endif
 }
 
 // destructor
 SfbQuantizer::~SfbQuantizer ()
 {
-  // free allocated helper buffers
-  MFREE (m_coeffMagn);
-#if EC_TRELLIS_OPT_CODING
-  MFREE (m_coeffTemp);
-#endif
-  MFREE (m_lut2ExpX4);
-  MFREE (m_lutSfNorm);
-  MFREE (m_lutXExp43);
+  // helper buffers are freed by the arena
+}
+
+// public functions
 #if EC_TRELLIS_OPT_CODING
+size_t SfbQuantizer::getQuantMemSize (const unsigned maxTransfLength, const uint8_t numSwb, const unsigned samplingRate)
+{
+  const unsigned numTrellisSfbs  = __min (52u, numSwb);
+  const unsigned trellisMemSize  = numTrellisSfbs * SFB_MAX_C_STATES * (sizeof (double) + sizeof (uint8_t) + SFB_MAX_C_STATES * sizeof (uint16_t)) +
+                                   32 * SFB_MAX_T_STATES * sizeof (double);
+  const uint16_t quantRateLength = (samplingRate < 28800 || samplingRate >= 57600 ? 512 : 256); // quantizeMagnRDOC()
 
-  for (unsigned b = 0; b < 52; b++)
-  {
-    MFREE (m_quantDist[b]);
-    MFREE (m_quantInSf[b]);
-    MFREE (m_quantRate[b]);
-  }
-#endif
+  return MEM_ALIGN_SIZE (maxTransfLength * sizeof (unsigned)) + MEM_ALIGN_SIZE (maxTransfLength + quantRateLength) + MEM_ALIGN_SIZE (trellisMemSize);
 }
+#else
+size_t SfbQuantizer::getQuantMemSize (const unsigned maxTransfLength)
+{
+  return MEM_ALIGN_SIZE (maxTransfLength * sizeof (unsigned));
+}
+#endif
 
-// public functions
-unsigned SfbQuantizer::initQuantMemory (const unsigned maxTransfLength,
+unsigned SfbQuantizer::initQuantMemory (const SharedTables* const sharedTables, const unsigned maxTransfLength,
 #if EC_TRELLIS_OPT_CODING
                                         const uint8_t numSwb, const uint8_t bitRateMode, const unsigned samplingRate,
 #endif
-                                        const uint8_t maxScaleFacIndex /*= SCHAR_MAX*/)
+                                        const uint8_t maxScaleFacIndex /*= SCHAR_MAX*/, MemoryArena* const arena /*= nullptr*/)
 {
-  const unsigned numScaleFactors = (unsigned) maxScaleFacIndex + 1;
 #if EC_TRELLIS_OPT_CODING
   const uint8_t complexityOffset = (samplingRate < 28800 ? 8 - (samplingRate >> 13) : 5) + ((bitRateMode == 0) && (samplingRate >= 8192) ? 1 : 0);
   const uint8_t numTrellisStates = complexityOffset - __min (2, (bitRateMode + 2) >> 2);  // number of states per SFB
-  const uint8_t numSquaredStates = numTrellisStates * numTrellisStates;
+  const unsigned numTrellisSfbs  = __min (52u, numSwb);
+  const unsigned trellisMemSize  = numTrellisSfbs * SFB_MAX_C_STATES * (sizeof (double) + sizeof (uint8_t) + SFB_MAX_C_STATES * sizeof (uint16_t)) +
+                                   32 * SFB_MAX_T_STATES * sizeof (double);
   const uint16_t quantRateLength = (samplingRate < 28800 || samplingRate >= 57600 ? 512 : 256); // quantizeMagnRDOC()
 #endif
+  MemoryArena& memArena = (arena != nullptr ? *arena : m_memArena);
   unsigned x;
 
-  if ((maxTransfLength < 128) || (maxTransfLength > 2048) || (maxTransfLength & 7) || (maxScaleFacIndex == 0) || (maxScaleFacIndex > SCHAR_MAX))
+  if ((sharedTables == nullptr) || (maxTransfLength < 128) || (maxTransfLength > 2048) || (maxTransfLength & 7) || (maxScaleFacIndex == 0) || (maxScaleFacIndex > SCHAR_MAX))
   {
     return 1; // invalid arguments error
   }
 
   m_maxSfIndex = maxScaleFacIndex;
 
-  if ((m_coeffMagn = (unsigned*) malloc (maxTransfLength * sizeof (unsigned))) == nullptr ||
 #if EC_TRELLIS_OPT_CODING
-      (m_coeffTemp = (uint8_t* ) malloc (maxTransfLength + quantRateLength  )) == nullptr ||
+  if ((arena == nullptr && m_memArena.allocate (getQuantMemSize (maxTransfLength, numSwb, samplingRate)) > 0) ||
+#else
+  if ((arena == nullptr && m_memArena.allocate (getQuantMemSize (maxTransfLength)) > 0) ||
 #endif
-      (m_lut2ExpX4 = (double*  ) malloc (numScaleFactors * sizeof (double  ))) == nullptr ||
-      (m_lutSfNorm = (double*  ) malloc (numScaleFactors * sizeof (double  ))) == nullptr ||
-      (m_lutXExp43 = (double*  ) malloc ((SCHAR_MAX + 1) * sizeof (double  ))) == nullptr)
+      (m_coeffMagn = (unsigned*) memArena.take (maxTransfLength * sizeof (unsigned))) == nullptr)
   {
     return 2; // memory allocation error
   }
 #if EC_TRELLIS_OPT_CODING
   m_maxSize8M1 = (maxTransfLength >> 3) - 1;
   m_numCStates = numTrellisStates;
+  m_numTStates = SFB_MAX_T_STATES;
+  m_refCStates = numTrellisStates;
   m_rateIndex  = bitRateMode;
 
-  for (x = 0; x < __min (52u, numSwb); x++)
+  if ((m_coeffTemp = (uint8_t*) memArena.take (maxTransfLength + quantRateLength)) == nullptr ||
+      (m_trellisMem = (uint8_t*) memArena.take (trellisMemSize)) == nullptr)
   {
-    if ((m_quantDist[x] = (double*  ) malloc (numTrellisStates * sizeof (double  ))) == nullptr ||
-        (m_quantInSf[x] = (uint8_t* ) malloc (numTrellisStates * sizeof (uint8_t ))) == nullptr ||
-        (m_quantRate[x] = (uint16_t*) malloc (numSquaredStates * sizeof (uint16_t))) == nullptr)
+    return 2;
+  }
+  else // partition arena, sized for max. number of states, see setNumRdocStates()
+  {
+    double*   const distMem = (double*) m_trellisMem + 32 * SFB_MAX_T_STATES;
+    uint16_t* const rateMem = (uint16_t*) &distMem[numTrellisSfbs * SFB_MAX_C_STATES];
+    uint8_t*  const inSfMem = (uint8_t* ) &rateMem[numTrellisSfbs * SFB_MAX_C_STATES * SFB_MAX_C_STATES];
+
+    m_tupleDist = (double*) m_trellisMem;
+    for (x = 0; x < numTrellisSfbs; x++)
     {
-      return 2;
+      m_quantDist[x] = &distMem[x * SFB_MAX_C_STATES];
+      m_quantRate[x] = &rateMem[x * SFB_MAX_C_STATES * SFB_MAX_C_STATES];
+      m_quantInSf[x] = &inSfMem[x * SFB_MAX_C_STATES];
     }
   }
 #else
   memset (m_coeffTemp, 0, sizeof (m_coeffTemp));
 #endif
-  // calculate scale factor gain 2^(x/4)
-  for (x = 0; x < numScaleFactors; x++)
-  {
-    m_lut2ExpX4[x] = pow (2.0, (double) x / 4.0);
-    m_lutSfNorm[x] = 1.0 / m_lut2ExpX4[x];
-  }
-  // calculate dequantized coeff x^(4/3)
-  for (x = 0; x < (SCHAR_MAX + 1); x++)
+  // adopt shared 2^(x/4) and x^(4/3) LUTs
+  m_lut2ExpX4 = sharedTables->getLut2ExpX4 ();
+  m_lutSfNorm = sharedTables->getLutSfNorm ();
+  m_lutXExp43 = sharedTables->getLutXExp43 ();
+#if SFB_QUANT_AVX2
+  m_quantSimdPath = isAvx2Supported ();
+#endif
+
+  return 0; // no error
+}
+
+#if EC_TRELLIS_OPT_CODING
+unsigned SfbQuantizer::setNumRdocStates (const uint8_t numSfbStates, const uint8_t numTupleStates)
+{
+  if ((numSfbStates == 1) || (numSfbStates > SFB_MAX_C_STATES) || (numTupleStates > SFB_MAX_T_STATES) || (m_trellisMem == nullptr))
   {
-    m_lutXExp43[x] = pow ((double) x, 4.0 / 3.0);
+    return 1; // invalid arguments error, or initQuantMemory was not called before
   }
+  m_numCStates = (numSfbStates   > 0 ? numSfbStates   : m_refCStates);
+  m_numTStates = (numTupleStates > 0 ? numTupleStates : SFB_MAX_T_STATES);
 
   return 0; // no error
 }
+#endif
 
 uint8_t SfbQuantizer::quantizeSpecSfb (EntropyCoder& entropyCoder, const int32_t* const inputCoeffs, const uint8_t grpLength,
                                        const uint16_t* const grpOffsets, uint32_t* const grpStats,  // quant./coding statistics
@@ -1,5 +1,5 @@
 /* quantization.h - header file for class with nonuniform quantization functionality
- * written by C. R. Helmrich, last modified in 2023 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -13,6 +13,7 @@
 
 #include "exhaleLibPch.h"
 #include "entropyCoding.h"
+#include "sharedTables.h"
 
 // constants, experimental macros
 #define FOUR_LOG102   13.28771238 // 4 / log10 (2)
@@ -22,6 +23,9 @@
 #define SFB_QUANT_OFFSET 0.496094 // 13 - 29^(3/4)
 #define SFB_QUANT_PERCEPT_OPT   1 // psych. quant.
 #define SFB_QUANT_SSE           0
+#define SFB_MAX_C_STATES        8 // states/SFB
+#define SFB_MAX_T_STATES        4 // states/tuple
+#define SFB_QUANT_AVX2          SIMD_X86 // 1: use AVX2 quantizer if CPU supports it
 
 // class for BL USAC quantization
 class SfbQuantizer
@@ -35,19 +39,25 @@ private:
 #else
   uint8_t   m_coeffTemp[200]; // 40 * 5 - NOTE: increase this when maximum grpLength > 5
 #endif
-  double*   m_lut2ExpX4; // for 2^(X/4)
-  double*   m_lutSfNorm; // 1 / 2^(X/4)
-  double*   m_lutXExp43; // for X^(4/3)
+  const double* m_lut2ExpX4; // for 2^(X/4)
+  const double* m_lutSfNorm; // 1 / 2^(X/4)
+  const double* m_lutXExp43; // for X^(4/3)
   uint8_t   m_maxSfIndex; // 1,..., 127
+  bool      m_quantSimdPath; // runtime-dispatched vectorized quantizer
 #if EC_TRELLIS_OPT_CODING
   uint8_t   m_maxSize8M1; // (size/8)-1
   uint8_t   m_numCStates; // states/SFB
+  uint8_t   m_numTStates; // states/tuple
+  uint8_t   m_refCStates; // preset's states/SFB
   uint8_t   m_rateIndex; // lambda mode
-  // trellis memory, max. 8 KB @ num_swb=51
+  // trellis memory, max. 11 KB @ num_swb=51
+  uint8_t*  m_trellisMem; // one arena for all of the below
   double*   m_quantDist[52]; // quantizing distortion
   uint8_t*  m_quantInSf[52]; // initial scale factors
   uint16_t* m_quantRate[52]; // MDCT and SF bit count
+  double*   m_tupleDist; // 32 x 4 tuple distortions
 #endif
+  MemoryArena m_memArena; // owns buffers if no arena was given
 
   // helper functions
   double    getQuantDist (const unsigned* const coeffMagn, const uint8_t scaleFactor,
@@ -71,13 +81,21 @@ public:
   ~SfbQuantizer ();
   // public functions
   unsigned* getCoeffMagnPtr ()                      const { return m_coeffMagn; }
-  double*   getSfNormTabPtr ()                      const { return m_lutSfNorm; }
+#if EC_TRELLIS_OPT_CODING
+  static size_t getQuantMemSize (const unsigned maxTransfLength, const uint8_t numSwb, const unsigned samplingRate);
+#else
+  static size_t getQuantMemSize (const unsigned maxTransfLength);
+#endif
+  const double* getSfNormTabPtr ()                  const { return m_lutSfNorm; }
   uint8_t getScaleFacOffset (const double absValue) const { return uint8_t (SF_QUANT_OFFSET + FOUR_LOG102 * log10 (__max (1.0, absValue))); }
-  unsigned  initQuantMemory (const unsigned maxTransfLength,
+  unsigned  initQuantMemory (const SharedTables* const sharedTables, const unsigned maxTransfLength,
 #if EC_TRELLIS_OPT_CODING
                              const uint8_t numSwb, const uint8_t bitRateMode, const unsigned samplingRate,
 #endif
-                             const uint8_t maxScaleFacIndex = SCHAR_MAX);
+                             const uint8_t maxScaleFacIndex = SCHAR_MAX, MemoryArena* const arena = nullptr);
+#if EC_TRELLIS_OPT_CODING
+  unsigned  setNumRdocStates (const uint8_t numSfbStates, const uint8_t numTupleStates); // 0: use preset's default
+#endif
   uint8_t   quantizeSpecSfb (EntropyCoder& entropyCoder, const int32_t* const inputCoeffs, const uint8_t grpLength,
                              const uint16_t* const grpOffsets, uint32_t* const grpStats,  // quant./coding statistics
                              const unsigned sfb, const uint8_t sfIndex, const uint8_t sfIndexPred = UCHAR_MAX,
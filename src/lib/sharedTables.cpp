@@ -0,0 +1,293 @@
+/* sharedTables.cpp - source file for class holding read-only tables shared by encoder instances
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#include "exhaleLibPch.h"
+#include "sharedTables.h"
+
+std::mutex    SharedTables::s_registryMutex;
+SharedTables* SharedTables::s_registryHead = nullptr;
+
+// static helper functions
+static short* createPermutTable (const short tableSize)
+{
+  const short lOver2 = tableSize >> 1;
+  short* permutTable = nullptr;
+  short  i = 0;
+
+  if ((permutTable = (short*) malloc (tableSize * sizeof (short))) == nullptr)
+  {
+    return nullptr; // allocation error
+  }
+
+  permutTable[0] = 0;
+  for (short s = 1; s < tableSize; s++)
+  {
+    short l = lOver2;
+
+    while (i >= l)
+    {
+      i -= l;
+      l >>= 1;
+    }
+    permutTable[s] = (i += l);
+  }
+
+  return permutTable;
+}
+
+static double modifiedBesselFunctionOfFirstKind (const double x)
+{
+  const double xOver2 = x * 0.5;
+  double d = 1.0, sum = 1.0;
+  int    i = 0;
+
+  do
+  {
+    const double x2di = xOver2 / double (++i);
+
+    d *= (x2di * x2di);
+    sum += d;
+  }
+  while (d > sum * 1.2e-38); // FLT_MIN
+
+  return sum;
+}
+
+static int32_t* initWindowHalfCoeffs (const USAC_WSHP windowShape, const unsigned frameLength)
+{
+  int32_t* windowBuf = nullptr;
+  unsigned u;
+
+  if ((windowBuf = (int32_t*) malloc (frameLength * sizeof (int32_t))) == nullptr)
+  {
+    return nullptr; // allocation error
+  }
+
+  if (windowShape == WINDOW_SINE)
+  {
+    const double dNorm = 3.141592653589793 / (2.0 * frameLength);
+    // MLT sine window half
+    for (u = 0; u < frameLength; u++)
+    {
+      windowBuf[u] = int32_t (sin (dNorm * (u + 0.5)) * WIN_SCALE + 0.5);
+    }
+  }
+  else  // if windowShape == WINDOW_KBD
+  {
+    const double alpha = 3.141592653589793 * (frameLength > 256 ? 4.0 : 6.0);
+    const double dBeta = 1.0 / modifiedBesselFunctionOfFirstKind (alpha /*sqrt (1.0)*/);
+    const double dNorm = 4.0 / (2.0 * frameLength);
+    const double iScal = double (1u << 30);
+    const double dScal = 1.0 / iScal;
+    double d, sum = 0.0;
+    // create Kaiser-Bessel window half
+    for (u = 0; u < frameLength; u++)
+    {
+      const double du1 = dNorm * u - 1.0;
+
+      d = dBeta * modifiedBesselFunctionOfFirstKind (alpha * sqrt (1.0 - du1 * du1));
+      sum += d;
+      windowBuf[u] = int32_t (d * iScal + 0.5);
+    }
+    d = 1.0 / sum; // normalized to sum
+    sum = 0.0;
+    // KBD window half
+    for (u = 0; u < frameLength; u++)
+    {
+      sum += dScal * windowBuf[u];
+      windowBuf[u] = int32_t (sqrt (d * sum /*cumulative sum*/) * WIN_SCALE + 0.5);
+    }
+  }
+  return windowBuf;
+}
+
+// private helper function
+unsigned SharedTables::initTables (const unsigned frameLength)
+{
+  const short  halfLength = short (frameLength >> 1);
+  const short  sixtLength = short (frameLength >> 4);
+  const short  transfLenS = 2 * sixtLength;
+  const double dNormL     = 3.141592653589793 / (2.0 * halfLength);
+  const double dNormS     = 3.141592653589793 / (2.0 * sixtLength);
+  const double dNormL4    = dNormL * 4.0;
+  short s;
+
+  m_frameLength = frameLength;
+
+  if ((m_dctRotCosL = (int32_t*) malloc (halfLength * sizeof (int32_t))) == nullptr ||
+      (m_dctRotCosS = (int32_t*) malloc (sixtLength * sizeof (int32_t))) == nullptr ||
+      (m_dctRotSinL = (int32_t*) malloc (halfLength * sizeof (int32_t))) == nullptr ||
+      (m_dctRotSinS = (int32_t*) malloc (sixtLength * sizeof (int32_t))) == nullptr ||
+      (m_fftHalfCos = (int32_t*) malloc ((halfLength >> 1) * sizeof (int32_t))) == nullptr ||
+      (m_fftHalfSin = (int32_t*) malloc ((halfLength >> 1) * sizeof (int32_t))) == nullptr ||
+      (m_fftPermutL = createPermutTable (halfLength)) == nullptr ||
+      (m_fftPermutS = createPermutTable (sixtLength)) == nullptr ||
+      (m_lut2ExpX4  = (double*) malloc (ST_NUM_SF_VALUES * sizeof (double))) == nullptr ||
+      (m_lutSfNorm  = (double*) malloc (ST_NUM_SF_VALUES * sizeof (double))) == nullptr ||
+      (m_lutXExp43  = (double*) malloc (ST_NUM_SF_VALUES * sizeof (double))) == nullptr)
+  {
+    return 2; // memory allocation error
+  }
+  // allocate all window buffers
+  for (s = WINDOW_SINE; s <= WINDOW_KBD; s++)
+  {
+    if ((m_timeWindowL[s] = initWindowHalfCoeffs ((USAC_WSHP) s, frameLength)) == nullptr ||
+        (m_timeWindowS[s] = initWindowHalfCoeffs ((USAC_WSHP) s, frameLength >> 3)) == nullptr)
+    {
+      return 2;
+    }
+  }
+
+  // obtain cosine and sine coefficients
+  for (s = 0; s < halfLength; s++)
+  {
+    m_dctRotCosL[s] = int32_t (cos (dNormL * (s + 0.125)) * (INT_MAX + 1.0) + 0.5);
+    m_dctRotSinL[s] = int32_t (sin (dNormL * (s + 0.125)) * INT_MIN - 0.5);
+  }
+  for (s = 0; s < sixtLength; s++)
+  {
+    m_dctRotCosS[s] = int32_t (cos (dNormS * (s + 0.125)) * (INT_MAX + 1.0) + 0.5);
+    m_dctRotSinS[s] = int32_t (sin (dNormS * (s + 0.125)) * INT_MIN - 0.5);
+  }
+
+  for (s = 0; s < transfLenS; s++)
+  {
+    m_fftHalfSin[s] = int32_t (sin (dNormL4 * s) * INT_MIN - 0.5);
+    m_fftHalfCos[transfLenS + s] = -m_fftHalfSin[s];
+  }
+  // complete missing entries by copying
+  m_fftHalfSin[s] = INT_MIN;
+  m_fftHalfCos[0] = INT_MIN;
+  for (s = 1; s < transfLenS; s++)
+  {
+    m_fftHalfSin[transfLenS + s] = m_fftHalfSin[transfLenS - s];
+    m_fftHalfCos[transfLenS - s] = m_fftHalfSin[s];
+  }
+
+  // calculate scale factor gain 2^(x/4)
+  for (s = 0; s < ST_NUM_SF_VALUES; s++)
+  {
+    m_lut2ExpX4[s] = pow (2.0, (double) s / 4.0);
+    m_lutSfNorm[s] = 1.0 / m_lut2ExpX4[s];
+  }
+  // calculate dequantized coeff x^(4/3)
+  for (s = 0; s < ST_NUM_SF_VALUES; s++)
+  {
+    m_lutXExp43[s] = pow ((double) s, 4.0 / 3.0);
+  }
+
+  return 0; // no error
+}
+
+// constructor
+SharedTables::SharedTables ()
+{
+  // initialize all table pointers
+  m_dctRotCosL  = nullptr;
+  m_dctRotCosS  = nullptr;
+  m_dctRotSinL  = nullptr;
+  m_dctRotSinS  = nullptr;
+  m_fftHalfCos  = nullptr;
+  m_fftHalfSin  = nullptr;
+  m_fftPermutL  = nullptr;
+  m_fftPermutS  = nullptr;
+  m_frameLength = 0;
+  m_lut2ExpX4   = nullptr;
+  m_lutSfNorm   = nullptr;
+  m_lutXExp43   = nullptr;
+  m_next        = nullptr;
+  m_refCount    = 0;
+
+  for (unsigned ws = WINDOW_SINE; ws <= WINDOW_KBD; ws++)
+  {
+    m_timeWindowL[ws] = nullptr;
+    m_timeWindowS[ws] = nullptr;
+  }
+}
+
+// destructor
+SharedTables::~SharedTables ()
+{
+  // free allocated tables
+  MFREE (m_dctRotCosL);
+  MFREE (m_dctRotCosS);
+  MFREE (m_dctRotSinL);
+  MFREE (m_dctRotSinS);
+  MFREE (m_fftHalfCos);
+  MFREE (m_fftHalfSin);
+  MFREE (m_fftPermutL);
+  MFREE (m_fftPermutS);
+  MFREE (m_lut2ExpX4);
+  MFREE (m_lutSfNorm);
+  MFREE (m_lutXExp43);
+
+  for (unsigned ws = WINDOW_SINE; ws <= WINDOW_KBD; ws++)
+  {
+    MFREE (m_timeWindowL[ws]);
+    MFREE (m_timeWindowS[ws]);
+  }
+}
+
+// public functions
+SharedTables* SharedTables::acquire (const unsigned frameLength)
+{
+  SharedTables* tables = nullptr;
+
+  if ((frameLength < 128) || (frameLength > 8192) || (frameLength & (frameLength - 1)))
+  {
+    return nullptr; // invalid arguments error
+  }
+
+  std::lock_guard<std::mutex> lock (s_registryMutex);
+
+  for (tables = s_registryHead; tables != nullptr; tables = tables->m_next)
+  {
+    if (tables->m_frameLength == frameLength) // reuse existing tables
+    {
+      tables->m_refCount++;
+      return tables;
+    }
+  }
+
+  try
+  {
+    tables = new SharedTables ();
+  }
+  catch (...)
+  {
+    return nullptr; // memory allocation error
+  }
+  if (tables->initTables (frameLength) > 0)
+  {
+    delete tables;
+    return nullptr;
+  }
+  tables->m_next     = s_registryHead;
+  tables->m_refCount = 1;
+  s_registryHead     = tables;
+
+  return tables;
+}
+
+void SharedTables::release (SharedTables* const tables)
+{
+  SharedTables** link = &s_registryHead;
+
+  if (tables == nullptr) return;
+
+  std::lock_guard<std::mutex> lock (s_registryMutex);
+
+  if (--tables->m_refCount > 0) return;
+
+  while ((*link != nullptr) && (*link != tables)) link = &(*link)->m_next;
+
+  if (*link != nullptr) *link = tables->m_next; // unlink and free the tables
+  delete tables;
+}
@@ -0,0 +1,73 @@
+/* sharedTables.h - header file for class holding read-only tables shared by encoder instances
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#ifndef _SHARED_TABLES_H_
+#define _SHARED_TABLES_H_
+
+#include "exhaleLibPch.h"
+#include <mutex>
+
+// constants, experimental macros
+#define ST_NUM_SF_VALUES (SCHAR_MAX + 1)
+#define WIN_SCALE double (1 << 23)
+
+// shared, reference-counted table class
+class SharedTables
+{
+private:
+
+  // member variables
+  int32_t*      m_dctRotCosL;
+  int32_t*      m_dctRotCosS;
+  int32_t*      m_dctRotSinL;
+  int32_t*      m_dctRotSinS;
+  int32_t*      m_fftHalfCos;
+  int32_t*      m_fftHalfSin;
+  short*        m_fftPermutL;
+  short*        m_fftPermutS;
+  unsigned      m_frameLength; // registry key
+  double*       m_lut2ExpX4; // for 2^(X/4)
+  double*       m_lutSfNorm; // 1 / 2^(X/4)
+  double*       m_lutXExp43; // for X^(4/3)
+  SharedTables* m_next;      // registry link
+  unsigned      m_refCount;
+  int32_t*      m_timeWindowL[2];  // long window halves
+  int32_t*      m_timeWindowS[2]; // short window halves
+
+  static std::mutex    s_registryMutex;
+  static SharedTables* s_registryHead;
+
+  // constructor
+  SharedTables ();
+  // destructor
+  ~SharedTables ();
+  // helper functions
+  unsigned initTables (const unsigned frameLength);
+
+public:
+
+  // public functions
+  static SharedTables* acquire (const unsigned frameLength); // nullptr on error
+  static void          release (SharedTables* const tables);
+
+  const int32_t*  getDctRotCos (const bool shortTransform) const { return (shortTransform ? m_dctRotCosS : m_dctRotCosL); }
+  const int32_t*  getDctRotSin (const bool shortTransform) const { return (shortTransform ? m_dctRotSinS : m_dctRotSinL); }
+  const int32_t*  getFftHalfCos ()                         const { return m_fftHalfCos; }
+  const int32_t*  getFftHalfSin ()                         const { return m_fftHalfSin; }
+  const short*    getFftPermut (const bool shortTransform) const { return (shortTransform ? m_fftPermutS : m_fftPermutL); }
+  unsigned        getFrameLength ()                        const { return m_frameLength; }
+  const double*   getLut2ExpX4 ()                          const { return m_lut2ExpX4; }
+  const double*   getLutSfNorm ()                          const { return m_lutSfNorm; }
+  const double*   getLutXExp43 ()                          const { return m_lutXExp43; }
+  const int32_t*  getTimeWindow (const bool shortWindow, const unsigned shape) const
+                                                                 { return (shortWindow ? m_timeWindowS[shape & 1] : m_timeWindowL[shape & 1]); }
+}; // SharedTables
+
+#endif // _SHARED_TABLES_H_
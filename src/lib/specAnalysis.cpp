@@ -1,5 +1,5 @@
 /* specAnalysis.cpp - source file for class providing spectral analysis of MCLT signals
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -159,19 +159,26 @@ void SpecAnalyzer::getSpectralBandwidth (uint16_t bandwidthOffset[USAC_MAX_NUM_C
   memcpy (bandwidthOffset, m_bandwidthOff, nChannels * sizeof (uint16_t));
 }
 
-unsigned SpecAnalyzer::initSigAnaMemory (LinearPredictor* const linPredictor, const unsigned nChannels, const unsigned maxTransfLength)
+unsigned SpecAnalyzer::initSigAnaMemory (LinearPredictor* const linPredictor, const unsigned nChannels, const unsigned maxTransfLength,
+                                         MemoryArena* const arena /*= nullptr*/)
 {
-  if (linPredictor == nullptr)
+  MemoryArena& memArena = (arena != nullptr ? *arena : m_memArena);
+
+  if ((linPredictor == nullptr) || (nChannels > USAC_MAX_NUM_CHANNELS))
   {
     return 1; // invalid arguments error
   }
   m_tnsPredictor = linPredictor;
 
+  if (arena == nullptr && m_memArena.allocate (getSigAnaMemSize (nChannels, maxTransfLength)) > 0)
+  {
+    return 2; // mem. allocation error
+  }
   for (unsigned ch = 0; ch < nChannels; ch++)
   {
-    if ((m_magnSpectra[ch] = (uint32_t*) malloc (maxTransfLength * sizeof (uint32_t))) == nullptr)
+    if ((m_magnSpectra[ch] = (uint32_t*) memArena.take (maxTransfLength * sizeof (uint32_t))) == nullptr)
     {
-      return 2; // mem. allocation error
+      return 2;
     }
     memset (m_magnSpectra[ch], 0, maxTransfLength * sizeof (uint32_t));
   }
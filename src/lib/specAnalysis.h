@@ -1,5 +1,5 @@
 /* specAnalysis.h - header file for class providing spectral analysis of MCLT signals
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -35,13 +35,14 @@ private:
   uint32_t m_specAnaStats[USAC_MAX_NUM_CHANNELS];
   uint32_t m_tnsPredGains[USAC_MAX_NUM_CHANNELS];
   LinearPredictor* m_tnsPredictor;
+  MemoryArena m_memArena; // owns m_magnSpectra if no arena was given
 
 public:
 
   // constructor
   SpecAnalyzer ();
   // destructor
-  ~SpecAnalyzer () { for (unsigned ch = 0; ch < USAC_MAX_NUM_CHANNELS; ch++) MFREE (m_magnSpectra[ch]); }
+  ~SpecAnalyzer () { }
   // public functions
   unsigned getLinPredCoeffs (short parCorCoeffs[MAX_PREDICTION_ORDER], const unsigned channelIndex); // returns best filter order
   unsigned getMeanAbsValues (const int32_t* const mdctSignal, const int32_t* const mdstSignal, const unsigned nSamplesInFrame,
@@ -49,7 +50,9 @@ public:
                              uint32_t* const meanBandValues);
   void getSpecAnalysisStats (uint32_t avgSpecAnaStats[USAC_MAX_NUM_CHANNELS], const unsigned nChannels);
   void getSpectralBandwidth (uint16_t bandwidthOffset[USAC_MAX_NUM_CHANNELS], const unsigned nChannels);
-  unsigned initSigAnaMemory (LinearPredictor* const linPredictor, const unsigned nChannels, const unsigned maxTransfLength);
+  static size_t getSigAnaMemSize (const unsigned nChannels, const unsigned maxTransfLength) { return nChannels * MEM_ALIGN_SIZE (maxTransfLength * sizeof (uint32_t)); }
+  unsigned initSigAnaMemory (LinearPredictor* const linPredictor, const unsigned nChannels, const unsigned maxTransfLength,
+                             MemoryArena* const arena = nullptr);
   unsigned optimizeGrouping (const unsigned channelIndex, const unsigned preferredBandwidth, const unsigned preferredGrouping);
   unsigned spectralAnalysis (const int32_t* const mdctSignals[USAC_MAX_NUM_CHANNELS],
                              const int32_t* const mdstSignals[USAC_MAX_NUM_CHANNELS],
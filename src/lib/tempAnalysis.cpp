@@ -1,5 +1,5 @@
 /* tempAnalysis.cpp - source file for class providing temporal analysis of PCM signals
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -11,25 +11,6 @@
 #include "exhaleLibPch.h"
 #include "tempAnalysis.h"
 
-static const int16_t lpfc12[65] = {  // 50% low-pass filter coefficients
-  // 269-pt. sinc windowed by 0.409 * cos(0*pi.*t) - 0.5 * cos(2*pi.*t) + 0.091 * cos(4*pi.*t)
-  17887, -27755, 16590, -11782, 9095, -7371, 6166, -5273, 4582, -4029, 3576, -3196, 2873,
-  -2594, 2350, -2135, 1944, -1773, 1618, -1478, 1351, -1235, 1129, -1032, 942, -860, 784,
-  -714, 650, -591, 536, -485, 439, -396, 357, -321, 287, -257, 229, -204, 181, -160, 141,
-  -124, 108, -95, 82, -71, 61, -52, 44, -37, 31, -26, 21, -17, 14, -11, 8, -6, 5, -3, 2, -1, 1
-};
-
-static const int16_t lpfc34[128] = { // 25% low-pass filter coefficients
-  // see also A. H. Nuttall, "Some Windows with Very Good Sidelobe Behavior," IEEE, Feb. 1981.
-  3 /*<<16*/, 26221, -8914, 19626, 0, -11731, 13789, -8331, 0, 6431, -8148, 5212, 0, -4360,
-  5688, -3728, 0, 3240, -4291, 2849, 0, -2529, 3378, -2260, 0, 2032, -2729, 1834, 0, -1662,
-  2240, -1510, 0, 1375, -1856, 1253, 0, -1144, 1546, -1045, 0, 955, -1292, 873, 0, -798,
-  1079, -729, 0, 666, -900, 608, 0, -555, 748, -505, 0, 459, -620, 418, 0, -379, 510, -343,
-  0, 310, -417, 280, 0, -252, 338, -227, 0, 203, -272, 182, 0, -162, 216, -144, 0, 128, -170,
-  113, 0, -100, 132, -88, 0, 77, -101, 67, 0, -58, 76, -50, 0, 43, -56, 37, 0, -31, 41, -26,
-  0, 22, -28, 18, 0, -15, 19, -12, 0, 10, -12, 8, 0, -6, 7, -4, 0, 3, -4, 2, 0, -1, 2, -1
-};
-
 // static helper functions
 static uint64_t updateAbsStats (const int32_t* const chSig, const int nSamples, unsigned* const maxAbsVal, int16_t* const maxAbsIdx)
 {
@@ -100,6 +81,7 @@ TempAnalyzer::TempAnalyzer ()
     m_maxHfLevPrev[ch] = 0;
     m_maxIdxHpPrev[ch] = 1;
     m_pitchLagPrev[ch] = 0;
+    m_quietFrames[ch]  = 0;
     m_tempAnaStats[ch] = 0;
     m_transientLoc[ch] = -1;
 
@@ -108,6 +90,15 @@ TempAnalyzer::TempAnalyzer ()
 }
 
 // public functions
+void TempAnalyzer::getQuietFrameFlags (uint8_t quietFrameFlags[USAC_MAX_NUM_CHANNELS], const unsigned nChannels)
+{
+  if ((quietFrameFlags == nullptr) || (nChannels > USAC_MAX_NUM_CHANNELS))
+  {
+    return;
+  }
+  memcpy (quietFrameFlags, m_quietFrames, nChannels * sizeof (uint8_t));
+}
+
 void TempAnalyzer::getTempAnalysisStats (uint32_t avgTempAnaStats[USAC_MAX_NUM_CHANNELS], const unsigned nChannels)
 {
   if ((avgTempAnaStats == nullptr) || (nChannels > USAC_MAX_NUM_CHANNELS))
@@ -204,30 +195,30 @@ unsigned TempAnalyzer::temporalAnalysis (const int32_t* const timeSignals[USAC_M
     if (applyResampler && lrCoreTimeSignals[ch] != nullptr) // downsampler
     {
       /*LF*/int32_t* lrSig = &lrCoreTimeSignals[ch][resamplerOffset >> sbrShift];
-      const int32_t* hrSig = &timeSignals[ch][resamplerOffset];
+      const int numOutSamples = nSamplesInFrame >> sbrShift;
+      const int64_t* lpOut = m_halfBandFilter.getLowPassOutput ();
+      const int64_t* bpOut = m_halfBandFilter.getBandPassOutput ();
       int64_t* const rPrev = m_filtSampPrev[ch];
       uint64_t     subSumL = 0, subSumM = 0, subSumH = 0;
 
-      for (int i = nSamplesInFrame >> sbrShift; i > 0; i--, lrSig++, hrSig += 2)
+      // polyphase FIR filtering, band-pass output needed where the counter i below is odd
+      if (m_halfBandFilter.applyFilter (&timeSignals[ch][resamplerOffset], numOutSamples, 1 - (numOutSamples & 1)) > 0)
       {
-        int64_t r  = ((int64_t) hrSig[0] * (1 << 17)) + (hrSig[-1] + (int64_t) hrSig[1]) * -2*SHRT_MIN;
-        int16_t s;
+        return 1;
+      }
 
-        for (u = 65, s = 129; u > 0; s -= 2) r += (hrSig[-s] + (int64_t) hrSig[s]) * lpfc12[--u];
+      for (int i = numOutSamples; i > 0; i--, lrSig++, lpOut++, bpOut++)
+      {
+        int64_t r;
 
-        *lrSig = int32_t ((r + (1 << 17)) >> 18); // low-pass at half rate
+        *lrSig = int32_t ((*lpOut + (1 << 17)) >> 18); // low-pass at half rate
         if (*lrSig < -8388608) *lrSig = -8388608;
         else
         if (*lrSig >  8388607) *lrSig =  8388607;
 
         if ((i & 1) != 0) // compute quarter-rate mid-frequency SBR signal
         {
-          r  = ((3 * (int64_t) hrSig[0]) * (1 << 16)) - (hrSig[-1] + (int64_t) hrSig[1]) * SHRT_MIN - r;
-          r += (hrSig[-2] + (int64_t) hrSig[2]) * SHRT_MIN;
-
-          for (s = 127; s > 0; s--/*u = s*/) r += (hrSig[-s] + (int64_t) hrSig[s]) * lpfc34[s];
-
-          r = (r + (1 << 17)) >> 18; // SBR env. band-pass at quarter rate
+          r = (*bpOut + (1 << 17)) >> 18; // SBR env. band-pass at quarter rate
           ue[i >> 7] += square (r);
 
           // calculate 3 SBR subband envelope energies (low, mid and high)
@@ -265,6 +256,10 @@ unsigned TempAnalyzer::temporalAnalysis (const int32_t* const timeSignals[USAC_M
       }
     }
 
+    // near-silence detection, the loop ends early at the first louder sample
+    for (u = 0; (u < (unsigned) nSamplesInFrame) && (abs (chSig[u]) <= TA_QUIET_PEAK); u++);
+    m_quietFrames[ch] = uint8_t ((m_quietFrames[ch] << 1) | (u == (unsigned) nSamplesInFrame ? 1 : 0));
+
     if (ch == lfeChannelIndex)  // no analysis
     {
       m_tempAnaStats[ch] = 0; // flat/stationary frame
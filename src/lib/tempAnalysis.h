@@ -1,5 +1,5 @@
 /* tempAnalysis.h - header file for class providing temporal analysis of PCM signals
- * written by C. R. Helmrich, last modified in 2021 - see License.htm for legal notices
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
  *
  * The copyright in this software is being made available under the exhale Copyright License
  * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
@@ -12,9 +12,11 @@
 #define _TEMP_ANALYSIS_H_
 
 #include "exhaleLibPch.h"
+#include "halfBandFilter.h"
 
 // constants, experimental macros
 #define TA_EPS               4096
+#define TA_QUIET_PEAK         256 // max. magnitude of near-silent frame, 1 LSB at 16 bit
 
 // temporal signal analysis class
 class TempAnalyzer
@@ -27,7 +29,9 @@ private:
   int32_t  m_maxHfLevPrev[USAC_MAX_NUM_CHANNELS];
   unsigned m_maxIdxHpPrev[USAC_MAX_NUM_CHANNELS];
   unsigned m_pitchLagPrev[USAC_MAX_NUM_CHANNELS];
+  uint8_t  m_quietFrames[USAC_MAX_NUM_CHANNELS]; // near-silence history, bit 0: last frame
   int64_t  m_filtSampPrev[USAC_MAX_NUM_CHANNELS][6]; // for SBR subband calculation (NOTE: only approximate)
+  HalfBandFilter m_halfBandFilter; // SBR downsampler, shared by all channels
   uint32_t m_tempAnaStats[USAC_MAX_NUM_CHANNELS];
   int16_t  m_transientLoc[USAC_MAX_NUM_CHANNELS];
 
@@ -38,6 +42,7 @@ public:
   // destructor
   ~TempAnalyzer () { }
   // public functions
+  void getQuietFrameFlags   (uint8_t quietFrameFlags[USAC_MAX_NUM_CHANNELS], const unsigned nChannels);
   void getTempAnalysisStats (uint32_t avgTempAnaStats[USAC_MAX_NUM_CHANNELS], const unsigned nChannels);
   void getTransientAndPitch (int16_t transIdxAndPitch[USAC_MAX_NUM_CHANNELS], const unsigned nChannels);
   uint8_t stereoPreAnalysis (const int32_t* const timeSignals[2], const uint8_t specFlatness[2], const unsigned nSamplesInSig);
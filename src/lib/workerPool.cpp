@@ -0,0 +1,139 @@
+/* workerPool.cpp - source file for class providing a simple pool of worker threads
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#include "exhaleLibPch.h"
+#include "workerPool.h"
+
+// private helper functions
+unsigned WorkerPool::processJobs ()
+{
+  unsigned result = 0;
+
+  while (true) // fetch and run jobs until none are left
+  {
+    unsigned jobIndex;
+    {
+      std::lock_guard<std::mutex> lock (m_jobMutex);
+
+      if (m_nextJob >= m_numJobs) break;
+      jobIndex = m_nextJob++;
+    }
+    result |= m_jobFunction (m_jobContext, jobIndex);
+  }
+  return result;
+}
+
+void WorkerPool::workerLoop ()
+{
+  unsigned generation = 0; // workers are created before the first job batch
+
+  while (true)
+  {
+    unsigned result;
+    {
+      std::unique_lock<std::mutex> lock (m_jobMutex);
+
+      m_jobsReady.wait (lock, [&] { return m_terminate || (m_jobGeneration != generation); });
+      if (m_terminate) return;
+      generation = m_jobGeneration;
+    }
+    result = processJobs ();
+    {
+      std::lock_guard<std::mutex> lock (m_jobMutex);
+
+      m_jobResult |= result;
+      if (--m_numActive == 0) m_jobsDone.notify_one ();
+    }
+  }
+}
+
+// constructor
+WorkerPool::WorkerPool ()
+{
+  m_jobContext    = nullptr;
+  m_jobFunction   = nullptr;
+  m_jobGeneration = 0;
+  m_jobResult     = 0;
+  m_numActive     = 0;
+  m_numJobs       = 0;
+  m_nextJob       = 0;
+  m_terminate     = false;
+}
+
+// destructor
+WorkerPool::~WorkerPool ()
+{
+  {
+    std::lock_guard<std::mutex> lock (m_jobMutex);
+
+    m_terminate = true;
+  }
+  m_jobsReady.notify_all ();
+
+  for (size_t t = 0; t < m_workers.size (); t++) m_workers[t].join ();
+}
+
+// public functions
+unsigned WorkerPool::initWorkers (const unsigned numWorkers)
+{
+  if ((numWorkers > WP_MAX_NUM_WORKERS) || !m_workers.empty ())
+  {
+    return 1; // invalid arguments error
+  }
+
+  try
+  {
+    for (unsigned t = 0; t < numWorkers; t++) m_workers.push_back (std::thread (&WorkerPool::workerLoop, this));
+  }
+  catch (...)
+  {
+    return 2; // thread creation error
+  }
+
+  return 0; // no error
+}
+
+unsigned WorkerPool::runJobs (const WP_JOB jobFunction, void* const jobContext, const unsigned numJobs)
+{
+  unsigned result = 0;
+
+  if (jobFunction == nullptr)
+  {
+    return 1; // invalid arguments error
+  }
+
+  if (m_workers.empty () || (numJobs <= 1)) // run jobs in order on caller's thread
+  {
+    for (unsigned j = 0; j < numJobs; j++) result |= jobFunction (jobContext, j);
+
+    return result;
+  }
+  {
+    std::lock_guard<std::mutex> lock (m_jobMutex);
+
+    m_jobContext  = jobContext;
+    m_jobFunction = jobFunction;
+    m_jobResult   = 0;
+    m_numActive   = (unsigned) m_workers.size ();
+    m_numJobs     = numJobs;
+    m_nextJob     = 0;
+    m_jobGeneration++;
+  }
+  m_jobsReady.notify_all ();
+
+  result = processJobs (); // caller's thread helps out
+  {
+    std::unique_lock<std::mutex> lock (m_jobMutex);
+
+    m_jobsDone.wait (lock, [&] { return m_numActive == 0; });
+    result |= m_jobResult;
+  }
+  return result;
+}
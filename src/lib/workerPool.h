@@ -0,0 +1,60 @@
+/* workerPool.h - header file for class providing a simple pool of worker threads
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+#include "exhaleLibPch.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// constants, experimental macros
+#define WP_MAX_NUM_WORKERS      7 // 8 threads incl. caller
+
+// job callback, returns 0 on success
+typedef unsigned (*WP_JOB) (void* const jobContext, const unsigned jobIndex);
+
+// worker thread pool class
+class WorkerPool
+{
+private:
+
+  // member variables
+  std::condition_variable m_jobsDone;
+  std::condition_variable m_jobsReady;
+  std::mutex   m_jobMutex;
+  void*        m_jobContext;
+  WP_JOB       m_jobFunction;
+  unsigned     m_jobGeneration;
+  unsigned     m_jobResult;
+  unsigned     m_numActive; // busy workers
+  unsigned     m_numJobs;
+  unsigned     m_nextJob;
+  bool         m_terminate;
+  std::vector<std::thread> m_workers;
+
+  // helper functions
+  unsigned processJobs ();
+  void     workerLoop  ();
+
+public:
+
+  // constructor
+  WorkerPool ();
+  // destructor
+  ~WorkerPool ();
+  // public functions
+  unsigned getNumWorkers () const { return (unsigned) m_workers.size (); }
+  unsigned initWorkers (const unsigned numWorkers);
+  unsigned runJobs     (const WP_JOB jobFunction, void* const jobContext, const unsigned numJobs); // OR of job results
+}; // WorkerPool
+
+#endif // _WORKER_POOL_H_
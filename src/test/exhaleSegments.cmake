@@ -0,0 +1,35 @@
+## exhaleSegments.cmake - CMake script comparing segment-parallel (option p) and sequential exhale app output
+ # written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ #
+ # The copyright in this software is being made available under the exhale Copyright License
+ # and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ # party rights, including patent rights. No such rights are granted under this License.
+ #
+ # Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ ##
+
+# usage: cmake -DEXHALE_APP=<exhale> -DEXHALE_TEST=<exhaleTest> -DWORK_DIR=<dir> -P exhaleSegments.cmake
+file(MAKE_DIRECTORY ${WORK_DIR})
+execute_process(COMMAND ${EXHALE_TEST} wave ${WORK_DIR}/segments.wav RESULT_VARIABLE result OUTPUT_QUIET)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "exhaleTest could not write ${WORK_DIR}/segments.wav")
+endif()
+
+# presets 4 and higher apply random stereo quantization dither, whose state differs after each splice
+foreach(preset 1 b)
+    foreach(mode - p)
+        # fixed MP4 creation time, see SOURCE_DATE_EPOCH
+        execute_process(COMMAND ${CMAKE_COMMAND} -E env SOURCE_DATE_EPOCH=0 ${EXHALE_APP} ${preset} ${mode} 10
+                                ${WORK_DIR}/segments.wav ${WORK_DIR}/segments_${preset}${mode}.m4a
+                        RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "exhale ${preset} ${mode} 10 failed with exit code ${result}")
+        endif()
+    endforeach()
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK_DIR}/segments_${preset}-.m4a ${WORK_DIR}/segments_${preset}p.m4a
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "preset ${preset}: segment-parallel and sequential output files differ")
+    endif()
+    message(STATUS "preset ${preset}: segment-parallel and sequential output files are identical")
+endforeach()
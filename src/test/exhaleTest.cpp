@@ -0,0 +1,193 @@
+/* exhaleTest.cpp - source file with main() routine for exhale encoder consistency checks
+ * written by C. R. Helmrich, last modified in 2026 - see License.htm for legal notices
+ *
+ * The copyright in this software is being made available under the exhale Copyright License
+ * and comes with ABSOLUTELY NO WARRANTY. This software may be subject to other third-
+ * party rights, including patent rights. No such rights are granted under this License.
+ *
+ * Copyright (c) 2018-2024 Christian R. Helmrich, project ecodis. All rights reserved.
+ */
+
+#include "../lib/exhaleEnc.h"
+#include "version.h"
+
+#include <stdio.h>
+
+// constants, experimental macros
+#define ET_NUM_CHANNELS      6  // 5.1, one SCE, two CPEs and one LFE
+#define ET_NUM_SIGNALS       4  // see etCreateSignal
+#define ET_SAMPLE_RATE   48000
+#define ET_SECONDS           5  // length of multichannel test signal
+#define ET_WAVE_SECONDS     24  // length of stereo test file for exhale app checks
+
+// static helper functions
+static void etCreateSignal (int32_t* const signal, const unsigned numSamples, const unsigned numChannels, const unsigned signalType)
+{
+  std::minstd_rand randomInt32 (0x1234567u + signalType); // fixed seed for reproducibility
+  const double freqNorm = 6.283185307179586 / ET_SAMPLE_RATE;
+
+  for (unsigned s = 0; s < numSamples; s++)
+  {
+    for (unsigned ch = 0; ch < numChannels; ch++)
+    {
+      const int32_t noise = int32_t (randomInt32 () & 0xFFFFFF) - (1 << 23);
+      double d = 0.0;
+
+      switch (signalType)
+      {
+        case 0: // white noise at -6 dBFS
+          d = noise * 0.5;
+          break;
+        case 1: // harmonic tone at 220 Hz with slight inter-channel detuning, plus -90 dBFS noise
+          for (unsigned h = 1; h <= 12; h++) d += sin (freqNorm * 220.0 * h * (1.0 + 0.001 * ch) * s) * (1 << 21) / h;
+          d += noise * 3.2e-5;
+          break;
+        case 2: // decaying noise bursts every 8192 samples on -60 dBFS background noise
+          d = noise * (0.5 * exp (-double (s & 8191) / 256.0) + 0.001);
+          break;
+        default: // digital silence in every other channel, -100 dBFS noise in the rest
+          d = (ch & 1 ? noise * 1.0e-5 : 0.0);
+          break;
+      }
+      signal[s * numChannels + ch] = int32_t (__max (-8388608.0, __min (8388607.0, d)));
+    }
+  }
+}
+
+// encodes multichannel input with and without worker threads, returns number of differing AU bytes
+static unsigned etEncoderThreads (const char preset, const int32_t* const signal, const unsigned numSamples, const unsigned numThreads)
+{
+  const bool     sbrPreset   = (preset >= 'a');
+  const unsigned frameLength = (sbrPreset ? 2048 : 1024);
+  const unsigned bitRateMode = (sbrPreset ? preset - 'a' : preset - '0');
+  std::vector <uint8_t> auStreams[2];
+  unsigned numDiffs = 0, t;
+
+  for (t = 0; t < 2; t++)
+  {
+    std::vector <int32_t> pcmFrame (frameLength * ET_NUM_CHANNELS, 0);
+    std::vector <uint8_t> auBuffer ((6144 >> 3) * ET_NUM_CHANNELS); // max frame AU size
+    unsigned char audioConfig[108] = {0};
+    uint32_t audioConfigBytes = 0;
+    unsigned auBytes;
+    ExhaleEncoder exhaleEnc (&pcmFrame.front (), &auBuffer.front (), ET_SAMPLE_RATE, ET_NUM_CHANNELS, frameLength, 45, bitRateMode
+#if !RESTRICT_TO_AAC
+                           , true, sbrPreset
+#endif
+                             );
+    if ((exhaleEnc.setNumThreads (t > 0 ? numThreads : 0) > 0) || (exhaleEnc.initEncoder (audioConfig, &audioConfigBytes) > 0) ||
+        ((auBytes = exhaleEnc.encodeLookahead ()) < 3)) return UINT_MAX;
+
+    auStreams[t].push_back (uint8_t (auBytes >> 8)); // AU sizes are part of the comparison
+    auStreams[t].push_back (uint8_t (auBytes));
+    auStreams[t].insert (auStreams[t].end (), auBuffer.begin (), auBuffer.begin () + auBytes);
+
+    for (unsigned s = 0; s + frameLength <= numSamples; s += frameLength)
+    {
+      memcpy (&pcmFrame.front (), &signal[s * ET_NUM_CHANNELS], frameLength * ET_NUM_CHANNELS * sizeof (int32_t));
+
+      if ((auBytes = exhaleEnc.encodeFrame ()) < 3) return UINT_MAX;
+
+      auStreams[t].push_back (uint8_t (auBytes >> 8));
+      auStreams[t].push_back (uint8_t (auBytes));
+      auStreams[t].insert (auStreams[t].end (), auBuffer.begin (), auBuffer.begin () + auBytes);
+    }
+  }
+  if (auStreams[0].size () != auStreams[1].size ()) return 1;
+
+  for (size_t i = 0; i < auStreams[0].size (); i++) numDiffs += (auStreams[0][i] != auStreams[1][i] ? 1 : 0);
+
+  return numDiffs; // 0: bit-exact
+}
+
+// writes stereo 24-bit WAVE file of all test signals, for app checks like segment vs. sequential coding
+static bool etWriteWaveFile (const char* const fileName)
+{
+  const unsigned segLength = ET_WAVE_SECONDS * ET_SAMPLE_RATE / ET_NUM_SIGNALS;
+  const uint32_t dataBytes = segLength * ET_NUM_SIGNALS * 2 * 3;
+  const uint8_t  header[44] = {'R', 'I', 'F', 'F', uint8_t (dataBytes + 36), uint8_t ((dataBytes + 36) >> 8), uint8_t ((dataBytes + 36) >> 16),
+                               uint8_t ((dataBytes + 36) >> 24), 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 2, 0,
+                               uint8_t (ET_SAMPLE_RATE), uint8_t (ET_SAMPLE_RATE >> 8), 0, 0, uint8_t (ET_SAMPLE_RATE * 6), uint8_t ((ET_SAMPLE_RATE * 6) >> 8),
+                               uint8_t ((ET_SAMPLE_RATE * 6) >> 16), 0, 6, 0, 24, 0, 'd', 'a', 't', 'a', uint8_t (dataBytes),
+                               uint8_t (dataBytes >> 8), uint8_t (dataBytes >> 16), uint8_t (dataBytes >> 24)};
+  std::vector <int32_t> signal (segLength * 2);
+  std::vector <uint8_t> bytes (segLength * 2 * 3);
+  FILE* waveFile = fopen (fileName, "wb");
+  bool  success  = (waveFile != nullptr) && (fwrite (header, 1, sizeof (header), waveFile) == sizeof (header));
+
+  for (unsigned t = 0; success && (t < ET_NUM_SIGNALS); t++)
+  {
+    etCreateSignal (&signal.front (), segLength, 2, t);
+
+    for (size_t i = 0; i < signal.size (); i++) // little-endian 24-bit PCM
+    {
+      bytes[i * 3    ] = uint8_t (signal[i]);
+      bytes[i * 3 + 1] = uint8_t (signal[i] >> 8);
+      bytes[i * 3 + 2] = uint8_t (signal[i] >> 16);
+    }
+    success = (fwrite (&bytes.front (), 1, bytes.size (), waveFile) == bytes.size ());
+  }
+  if (waveFile != nullptr) success = (fclose (waveFile) == 0) && success;
+
+  return success;
+}
+
+// main routine
+int main (const int argc, char* argv[])
+{
+  const char* const check = (argc > 1 ? argv[1] : "all");
+  unsigned errors = 0, t;
+
+  fprintf (stdout, "\n exhaleTest %s.%s%s - encoder consistency checks\n\n", EXHALELIB_VERSION_MAJOR, EXHALELIB_VERSION_MINOR, EXHALELIB_VERSION_BUGFIX);
+
+  if (check[0] == '-')
+  {
+    fprintf (stdout, " Usage:\t%s [threads | all | wave <file.wav>]\n\n", argv[0]);
+    return 0;
+  }
+
+  if (strcmp (check, "wave") == 0) // only create test input file for the exhale app
+  {
+    if ((argc < 3) || !etWriteWaveFile (argv[2]))
+    {
+      fprintf (stderr, " ERROR while trying to write WAVE file %s!\n\n", argc < 3 ? "" : argv[2]);
+      return 1;
+    }
+    fprintf (stdout, " %-30s %u seconds stereo written to %s\n\n", "etWriteWaveFile", ET_WAVE_SECONDS, argv[2]);
+    return 0;
+  }
+
+  if ((strcmp (check, "threads") == 0) || (strcmp (check, "all") == 0))
+  {
+    const unsigned segLength = ET_SECONDS * ET_SAMPLE_RATE / ET_NUM_SIGNALS;
+    std::vector <int32_t> signal (segLength * ET_NUM_SIGNALS * ET_NUM_CHANNELS);
+    const char presets[] = {'1', '5', 'b', 'f'}; // with and without SBR
+
+    for (t = 0; t < ET_NUM_SIGNALS; t++) etCreateSignal (&signal[segLength * ET_NUM_CHANNELS * t], segLength, ET_NUM_CHANNELS, t);
+
+    for (t = 0; t < sizeof (presets); t++)
+    {
+      for (unsigned numThreads = 2; numThreads <= WP_MAX_NUM_WORKERS + 1; numThreads <<= 1)
+      {
+        const unsigned numDiffs = etEncoderThreads (presets[t], &signal.front (), segLength * ET_NUM_SIGNALS, numThreads);
+
+        if (numDiffs == UINT_MAX)
+        {
+          fprintf (stderr, " ERROR while trying to encode with preset %c!\n\n", presets[t]);
+          return 1;
+        }
+        fprintf (stdout, " %-30s 5.1 preset %c %u threads %s\n", "ExhaleEncoder::setNumThreads", presets[t], numThreads,
+                 numDiffs == 0 ? "bit-exact" : "MISMATCH");
+        errors += (numDiffs > 0 ? 1 : 0);
+      }
+    }
+  }
+  fprintf (stdout, "\n");
+
+  if (errors > 0)
+  {
+    fprintf (stderr, " ERROR: %u of the checks failed!\n\n", errors);
+    return 1;
+  }
+  return 0;
+}